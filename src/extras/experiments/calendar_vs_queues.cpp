@@ -0,0 +1,78 @@
+// Compares the event queues of the identifier component (compile from the src folder with: g++ -std=c++14 -O2 -I.).
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lib/component/identifier.hpp"
+
+#define ROUNDS 3
+
+using namespace std;
+using namespace fcpp;
+
+class timer {
+    typedef std::chrono::high_resolution_clock clock_t;
+    typedef std::chrono::duration<double, std::ratio<1>> second_t;
+
+    std::chrono::time_point<clock_t, second_t> beginning;
+
+  public:
+    timer() : beginning(clock_t::now()) {}
+    double elapsed() const {
+        return std::chrono::duration_cast<second_t>(clock_t::now() - beginning).count();
+    }
+};
+
+// runs ROUNDS near-periodic rounds of n nodes, returning the nanoseconds per event
+template <typename Q>
+double run(size_t n) {
+    mt19937_64 rnd(42);
+    uniform_real_distribution<times_t> start(0, 1), jitter(0.9, 1.1);
+    Q q;
+    for (size_t i = 0; i < n; ++i) q.push(start(rnd), i);
+    size_t events = 0;
+    timer t;
+    while (events < ROUNDS * n) {
+        times_t now = q.next();
+        vector<device_t> v = q.pop(now);
+        for (device_t d : v) q.push(now + jitter(rnd), d);
+        events += v.size();
+    }
+    return t.elapsed() * 1e9 / events;
+}
+
+void experiment(size_t n) {
+    cout << "Experiment with " << n << " nodes (ns per event)" << endl;
+    cout << "heap:     " << run<component::details::times_queue<false>>(n) << endl;
+    cout << "map:      " << run<component::details::times_queue<true>>(n) << endl;
+    cout << "calendar: " << run<component::details::calendar_queue>(n) << endl;
+}
+
+int main(int argc, char** argv) {
+    size_t maxn = argc > 1 ? stoull(argv[1]) : 10000000;
+    for (size_t n = 10000; n <= maxn; n *= 10) experiment(n);
+}
+
+/*
+ RESULTS (-O2)
+
+Experiment with 10000 nodes (ns per event)
+heap:     138.837
+map:      198.98
+calendar: 88.2432
+Experiment with 100000 nodes (ns per event)
+heap:     176.418
+map:      301.585
+calendar: 97.8492
+Experiment with 1000000 nodes (ns per event)
+heap:     269.222
+map:      669.433
+calendar: 161.517
+Experiment with 10000000 nodes (ns per event)
+heap:     482.01
+map:      1807.4
+calendar: 297.049
+ */
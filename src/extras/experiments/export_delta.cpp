@@ -0,0 +1,108 @@
+// Compares full and delta-encoded exports in a batch simulation
+// (compile from the src folder with: g++ -std=c++14 -O2 -I. -pthread, linking the fcpp and stb_image libraries).
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "lib/fcpp.hpp"
+
+#define END 100
+#define REPEAT 3
+
+using namespace std;
+using namespace fcpp;
+using namespace component::tags;
+
+class timer {
+    typedef std::chrono::high_resolution_clock clock_t;
+    typedef std::chrono::duration<double, std::ratio<1>> second_t;
+
+    std::chrono::time_point<clock_t, second_t> beginning;
+
+  public:
+    timer() : beginning(clock_t::now()) {}
+    double elapsed() const {
+        return std::chrono::duration_cast<second_t>(clock_t::now() - beginning).count();
+    }
+};
+
+namespace fcpp {
+namespace coordination {
+    namespace tags {
+        struct count {};
+    }
+
+    // mostly stable exports: distance and count towards a source, highest identifier, round counter
+    MAIN() {
+        bool source = node.uid == 0;
+        real_t d = abf_distance(CALL, source);
+        real_t c = sp_collection(CALL, d, real_t(1), real_t(0), [](real_t x, real_t y){
+            return x+y;
+        });
+        device_t m = gossip_max(CALL, node.uid);
+        int r = counter(CALL);
+        node.storage(tags::count{}) = source ? c + m + r : 0;
+    }
+    FUN_EXPORT main_t = common::export_list<abf_distance_t, sp_collection_t<real_t, real_t>, gossip_max_t<device_t>, counter_t<>>;
+}
+}
+
+template <size_t n, intmax_t side, intmax_t period>
+DECLARE_OPTIONS(options,
+    program<coordination::main>,
+    exports<coordination::main_t>,
+    tuple_store<coordination::tags::count, real_t>,
+    round_schedule<sequence::periodic_n<1, 0, 1, END>>,
+    spawn_schedule<sequence::multiple_n<n, 0>>,
+    init<x, distribution::rect_n<1, 0, 0, side, side>>,
+    connector<connect::fixed<10>>,
+    export_delta<period>
+);
+
+// runs the simulation REPEAT times, returning the least microseconds per round
+template <size_t n, intmax_t side, intmax_t period>
+double run() {
+    double best = 1e9;
+    for (int i = 0; i < REPEAT; ++i) {
+        typename component::batch_simulator<options<n, side, period>>::net network{common::make_tagged_tuple<output>(nullptr)};
+        timer t;
+        network.run();
+        best = std::min(best, t.elapsed() * 1e6 / (n * END));
+    }
+    return best;
+}
+
+template <size_t n, intmax_t side>
+void experiment() {
+    cout << "Experiment with " << n << " nodes on a " << side << "x" << side << " square (us per round)" << endl;
+    cout << "full:     " << run<n, side, 0>() << endl;
+    cout << "delta 4:  " << run<n, side, 4>() << endl;
+    cout << "delta 16: " << run<n, side, 16>() << endl;
+}
+
+int main() {
+    experiment<1000, 200>();
+    experiment<1000, 100>();
+    experiment<10000, 400>();
+}
+
+/*
+ RESULTS (-O2)
+
+Experiment with 1000 nodes on a 200x200 square (us per round)
+full:     6.44771
+delta 4:  12.0523
+delta 16: 10.4081
+Experiment with 1000 nodes on a 100x100 square (us per round)
+full:     14.9444
+delta 4:  47.1531
+delta 16: 36.0521
+Experiment with 10000 nodes on a 400x400 square (us per round)
+full:     20.6864
+delta 4:  64.5782
+delta 16: 41.6687
+
+ Full exports are only shared between nodes in simulation, so delta encoding costs time there
+ (encoding on send, patching on receive, copying keyframes once): it only pays off on the wire.
+ */
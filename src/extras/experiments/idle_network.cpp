@@ -0,0 +1,76 @@
+// Measures the CPU time used by the thread of an idle async_retry_network, and the schedule of retries
+// of a failing send (compile from the src folder with: g++ -std=c++14 -O3 -I. -pthread).
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "lib/deployment/os.hpp"
+
+#define SECONDS 2
+
+using namespace std;
+using namespace fcpp;
+
+typedef chrono::steady_clock clock_type;
+
+// times of the send attempts
+vector<clock_type::time_point> attempts;
+
+// non-blocking transceiver, never receiving and failing the first sends
+struct mock_transceiver {
+    using data_type = int;
+    data_type data;
+    mock_transceiver(data_type d) : data(d) {}
+    bool send(device_t, vector<char> const&, int attempt) {
+        attempts.push_back(clock_type::now());
+        return attempt >= data;
+    }
+    message_type receive(int) {
+        return {};
+    }
+};
+
+// node interface required by networks
+struct mock_node {
+    struct {
+        times_t internal_time() const {
+            return 0;
+        }
+    } net;
+    device_t uid = 1;
+    void receive(message_type&) {}
+};
+
+typedef os::async_retry_network<true, mock_transceiver>::network<mock_node> network_type;
+
+int main() {
+    mock_node n;
+    {
+        clock_t c = clock();
+        clock_type::time_point t = clock_type::now();
+        {
+            network_type net(n, 0);
+            this_thread::sleep_for(chrono::seconds(SECONDS));
+        }
+        double cpu = double(clock() - c) / CLOCKS_PER_SEC;
+        double wall = chrono::duration<double>(clock_type::now() - t).count();
+        cout << "idle network: " << cpu << "s cpu over " << wall << "s (" << 100 * cpu / wall << "% of a core)" << endl;
+    }
+    {
+        clock_type::time_point t;
+        {
+            network_type net(n, 5);
+            this_thread::sleep_for(chrono::milliseconds(50));
+            vector<char> m{1, 2, 3};
+            t = clock_type::now();
+            net.send(m);
+            this_thread::sleep_for(chrono::milliseconds(200));
+        }
+        cout << "send attempts after:";
+        for (auto a : attempts) cout << " " << chrono::duration<double, milli>(a - t).count() << "ms";
+        cout << endl;
+    }
+}
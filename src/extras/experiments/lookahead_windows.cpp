@@ -0,0 +1,101 @@
+// Compares epsilon batches and lookahead windows of a deterministic simulation with sparse round times
+// (compile from the src folder with: g++ -std=c++14 -O2 -I. -pthread, linking the fcpp and stb_image libraries).
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "lib/fcpp.hpp"
+
+#define END 10
+#define REPEAT 3
+
+using namespace std;
+using namespace fcpp;
+using namespace component::tags;
+
+class timer {
+    typedef std::chrono::high_resolution_clock clock_t;
+    typedef std::chrono::duration<double, std::ratio<1>> second_t;
+
+    std::chrono::time_point<clock_t, second_t> beginning;
+
+  public:
+    timer() : beginning(clock_t::now()) {}
+    double elapsed() const {
+        return std::chrono::duration_cast<second_t>(clock_t::now() - beginning).count();
+    }
+};
+
+namespace fcpp {
+namespace coordination {
+    // a cheap program: counting rounds and neighbours
+    MAIN() {
+        counter(CALL);
+        count_hood(CALL);
+    }
+    FUN_EXPORT main_t = common::export_list<counter_t<>, int>;
+}
+}
+
+// rounds start at random times in [0,1] and repeat with random periods in [0.5,1.5]
+template <size_t n, intmax_t side>
+DECLARE_OPTIONS(options,
+    program<coordination::main>,
+    exports<coordination::main_t>,
+    parallel<true>,
+    deterministic<true>,
+    round_schedule<sequence::periodic<distribution::interval_n<times_t, 0, 1>, distribution::interval_n<times_t, 1, 3, 2>, distribution::constant_n<times_t, END>>>,
+    spawn_schedule<sequence::multiple_n<n, 0>>,
+    init<x, distribution::rect_n<1, 0, 0, side, side>>,
+    connector<connect::fixed<10>>,
+    delay<distribution::constant_n<times_t, 1>>
+);
+
+// runs the simulation REPEAT times with a given window, returning the least microseconds per round
+template <size_t n, intmax_t side>
+double run(times_t eps, times_t ahead) {
+    double best = 1e9;
+    for (int i = 0; i < REPEAT; ++i) {
+        typename component::batch_simulator<options<n, side>>::net network{common::make_tagged_tuple<output, threads, epsilon, lookahead>(nullptr, 1, eps, ahead)};
+        timer t;
+        network.run();
+        best = std::min(best, t.elapsed() * 1e6 / (n * END));
+    }
+    return best;
+}
+
+template <size_t n, intmax_t side>
+void experiment(times_t w) {
+    cout << "Experiment with " << n << " nodes on a " << side << "x" << side << " square and windows of " << w << " (us per round)" << endl;
+    cout << "epsilon:   " << run<n, side>(w, 0) << endl;
+    cout << "lookahead: " << run<n, side>(0, w) << endl;
+}
+
+int main() {
+    experiment<1000, 200>(0.01);
+    experiment<1000, 200>(0.001);
+    experiment<10000, 630>(0.01);
+    experiment<10000, 630>(0.001);
+}
+
+/*
+ RESULTS (-O2)
+
+Experiment with 1000 nodes on a 200x200 square and windows of 0.01 (us per round)
+epsilon:   4.01075
+lookahead: 4.25769
+Experiment with 1000 nodes on a 200x200 square and windows of 0.001 (us per round)
+epsilon:   4.15836
+lookahead: 4.13819
+Experiment with 10000 nodes on a 630x630 square and windows of 0.01 (us per round)
+epsilon:   11.2832
+lookahead: 12.8729
+Experiment with 10000 nodes on a 630x630 square and windows of 0.001 (us per round)
+epsilon:   11.3431
+lookahead: 9.14399
+
+ Sending ahead visits only the nodes with events within the window, so lookahead costs about as
+ epsilon batching however sparse the windows are. Visiting every node for every window instead took
+ 4.84152, 9.26994, 12.9098 and 39.7029 us per round on the same experiments, growing with nodes per event.
+ */
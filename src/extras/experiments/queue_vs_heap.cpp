@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#define ROUNDS 20000
+
+using namespace std;
+
+class timer {
+    typedef std::chrono::high_resolution_clock clock_t;
+    typedef std::chrono::duration<double, std::ratio<1>> second_t;
+
+    std::chrono::time_point<clock_t, second_t> beginning;
+
+  public:
+    timer(string s) : beginning(clock_t::now()) {
+        cout << s << ": ";
+    }
+    ~timer() {
+        cout << elapsed() << " seconds" << endl;
+    }
+    double elapsed() const {
+        return std::chrono::duration_cast<second_t>(clock_t::now() - beginning).count();
+    }
+};
+
+// exports are mocked by a small payload
+typedef vector<int> export_type;
+
+
+// maps with metrics and exports, worst metric found through a lazily cleaned priority queue
+class lazy_queue {
+    unordered_map<int, export_type> m_data;
+    unordered_map<int, double> m_metrics;
+    priority_queue<pair<double, int>> m_queue;
+
+    void clean() {
+        while (m_metrics.count(m_queue.top().second) == 0 or m_metrics.at(m_queue.top().second) != m_queue.top().first)
+            m_queue.pop();
+    }
+
+  public:
+    size_t queue_size() const {
+        return m_queue.size();
+    }
+    void insert(int d, export_type e, double m, double threshold, size_t hoodsize) {
+        if (m <= threshold) {
+            if (m_metrics.count(d) == 0 or m_metrics[d] != m)
+                m_queue.emplace(m, d);
+            m_metrics[d] = m;
+            m_data[d] = std::move(e);
+            if (m_data.size() > hoodsize) pop();
+            else clean();
+        }
+    }
+    void pop() {
+        clean();
+        m_data.erase(m_queue.top().second);
+        m_metrics.erase(m_queue.top().second);
+        m_queue.pop();
+    }
+    void update(double delta, double threshold) {
+        m_queue = {};
+        for (auto it = m_metrics.begin(); it != m_metrics.end(); ) {
+            it->second += delta;
+            if (it->second > threshold) {
+                m_data.erase(it->first);
+                it = m_metrics.erase(it);
+            } else {
+                m_queue.emplace(it->second, it->first);
+                ++it;
+            }
+        }
+    }
+};
+
+
+// binary heap of entries, with positions indexed by device
+class indexed_heap {
+    typedef tuple<double, int, export_type> data_type;
+
+    vector<data_type> m_heap;
+    unordered_map<int, size_t> m_pos;
+
+    bool above(data_type const& x, data_type const& y) const {
+        if (get<0>(x) != get<0>(y)) return get<0>(y) < get<0>(x);
+        return get<1>(y) < get<1>(x);
+    }
+    void place(size_t i, data_type&& x) {
+        m_heap[i] = std::move(x);
+        m_pos[get<1>(m_heap[i])] = i;
+    }
+    void sift_up(size_t i) {
+        data_type x = std::move(m_heap[i]);
+        for (; i > 0 and above(x, m_heap[(i-1)/2]); i = (i-1)/2)
+            place(i, std::move(m_heap[(i-1)/2]));
+        place(i, std::move(x));
+    }
+    void sift_down(size_t i) {
+        data_type x = std::move(m_heap[i]);
+        while (2*i+1 < m_heap.size()) {
+            size_t j = 2*i+1;
+            if (j+1 < m_heap.size() and above(m_heap[j+1], m_heap[j])) ++j;
+            if (not above(m_heap[j], x)) break;
+            place(i, std::move(m_heap[j]));
+            i = j;
+        }
+        place(i, std::move(x));
+    }
+
+  public:
+    size_t queue_size() const {
+        return m_heap.size();
+    }
+    void insert(int d, export_type e, double m, double threshold, size_t hoodsize) {
+        if (m <= threshold) {
+            auto it = m_pos.find(d);
+            if (it == m_pos.end() and m_heap.size() < hoodsize) {
+                m_heap.emplace_back(m, d, std::move(e));
+                sift_up(m_heap.size()-1);
+            } else if (it == m_pos.end()) {
+                data_type x(m, d, std::move(e));
+                if (above(x, m_heap[0])) return;
+                m_pos.erase(get<1>(m_heap[0]));
+                m_heap[0] = std::move(x);
+                sift_down(0);
+            } else {
+                size_t i = it->second;
+                get<2>(m_heap[i]) = std::move(e);
+                if (get<0>(m_heap[i]) != m) {
+                    bool up = get<0>(m_heap[i]) < m;
+                    get<0>(m_heap[i]) = m;
+                    if (up) sift_up(i);
+                    else sift_down(i);
+                }
+            }
+        }
+    }
+    void pop() {
+        m_pos.erase(get<1>(m_heap[0]));
+        m_heap[0] = std::move(m_heap.back());
+        m_heap.pop_back();
+        if (m_heap.size()) sift_down(0);
+    }
+    void update(double delta, double threshold) {
+        size_t w = 0;
+        for (size_t r = 0; r < m_heap.size(); ++r) {
+            get<0>(m_heap[r]) += delta;
+            if (get<0>(m_heap[r]) <= threshold) {
+                if (r > w) m_heap[w] = std::move(m_heap[r]);
+                ++w;
+            } else m_pos.erase(get<1>(m_heap[r]));
+        }
+        m_heap.resize(w);
+        make_heap(m_heap.begin(), m_heap.end(), [this](data_type const& x, data_type const& y){
+            return above(y, x);
+        });
+        for (size_t i = 0; i < m_heap.size(); ++i)
+            m_pos[get<1>(m_heap[i])] = i;
+    }
+};
+
+
+int N, L;
+size_t maxsize;
+vector<int> order;
+mt19937 rnd;
+
+
+// every round, N neighbours in random order send a message with a random metric,
+// then metrics age and are checked against the threshold
+template <class T>
+void round(T& c) {
+    uniform_real_distribution<double> dist(0, 1);
+    shuffle(order.begin(), order.end(), rnd);
+    for (int i=0; i<N; i++) {
+        c.insert(order[i], export_type(4, i), dist(rnd), 1.0, L);
+        maxsize = max(maxsize, c.queue_size());
+    }
+    c.update(0.1, 1.0);
+}
+
+template <class T>
+void run(string s) {
+    T c;
+    rnd.seed(42);
+    maxsize = 0;
+    {
+        timer _(s);
+        for (int i=0; i<ROUNDS; i++)
+            round(c);
+    }
+    cout << "max container size: " << maxsize << endl;
+}
+
+void experiment(int N, int L) {
+    ::N = N;
+    ::L = L;
+    order.clear();
+    for (int i=0; i<N; i++) order.push_back(i);
+    cout << "Experiment with N, L = " << N << ", " << L << endl;
+    run<lazy_queue>("lazy queue");
+    run<indexed_heap>("indexed heap");
+}
+
+int main() {
+    experiment(10,  20);
+    experiment(50,  20);
+    experiment(100, 20);
+    experiment(200, 20);
+
+    experiment(50,  100);
+    experiment(100, 100);
+    experiment(200, 100);
+    experiment(500, 100);
+}
+
+/*
+ RESULTS
+ 
+Experiment with N, L = 10, 20
+lazy queue: 0.0158612 seconds
+max container size: 20
+indexed heap: 0.01485 seconds
+max container size: 10
+Experiment with N, L = 50, 20
+lazy queue: 0.114149 seconds
+max container size: 40
+indexed heap: 0.087222 seconds
+max container size: 20
+Experiment with N, L = 100, 20
+lazy queue: 0.227197 seconds
+max container size: 40
+indexed heap: 0.14612 seconds
+max container size: 20
+Experiment with N, L = 200, 20
+lazy queue: 0.441332 seconds
+max container size: 40
+indexed heap: 0.244679 seconds
+max container size: 20
+Experiment with N, L = 50, 100
+lazy queue: 0.0767864 seconds
+max container size: 100
+indexed heap: 0.0854408 seconds
+max container size: 50
+Experiment with N, L = 100, 100
+lazy queue: 0.153775 seconds
+max container size: 200
+indexed heap: 0.179164 seconds
+max container size: 100
+Experiment with N, L = 200, 100
+lazy queue: 0.488758 seconds
+max container size: 200
+indexed heap: 0.431079 seconds
+max container size: 100
+Experiment with N, L = 500, 100
+lazy queue: 1.25754 seconds
+max container size: 194
+indexed heap: 0.874054 seconds
+max container size: 100
+ */
@@ -8,8 +8,11 @@
 #ifndef FCPP_CLOUD_GRAPH_CONNECTOR_H_
 #define FCPP_CLOUD_GRAPH_CONNECTOR_H_
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 
+#include <memory>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
@@ -38,6 +41,14 @@ namespace tags {
     template <typename T>
     struct delay;
 
+    //! @brief Declaration flag associating to whether messages should be delivered independently of thread scheduling (defaults to false).
+    template <bool b>
+    struct deterministic;
+
+    //! @brief Declaration flag associating to whether messages should be delivered through lock-free inboxes, processed by receivers at their next event (defaults to false).
+    template <bool b>
+    struct inbox;
+
     //! @brief Declaration flag associating to whether message sizes should be emulated (defaults to false).
     template <bool b>
     struct message_size;
@@ -66,12 +77,26 @@ namespace tags {
  * - \ref tags::dimension defines the dimensionality of the space (defaults to 2).
  *
  * <b>Declaration flags:</b>
+ * - \ref tags::deterministic defines whether messages should be delivered independently of thread scheduling (defaults to false).
+ * - \ref tags::inbox defines whether messages should be delivered through lock-free inboxes, processed by receivers at their next event (defaults to false).
  * - \ref tags::message_size defines whether message sizes should be emulated (defaults to false).
  * - \ref tags::parallel defines whether parallelism is enabled (defaults to \ref FCPP_PARALLEL).
  * - \ref tags::symmetric defines whether the neighbour relation is symmetric (defaults to true).
+ *
+ * If \ref tags::inbox is true, senders do not lock receivers: they push messages into the inboxes of
+ * their neighbours, which process them by increasing time and sender identifier at the start of their next event.
+ * If \ref tags::deterministic is also true, messages are only processed in a later batch of concurrent events
+ * than the one they were sent in (provided that an \ref identifier is a parent component), so that the outcome
+ * of a parallel simulation does not depend on the number of threads.
  */
 template <class... Ts>
 struct graph_connector {
+    //! @brief Whether messages should be delivered independently of thread scheduling.
+    constexpr static bool deterministic = common::option_flag<tags::deterministic, false, Ts...>;
+
+    //! @brief Whether messages should be delivered through lock-free inboxes.
+    constexpr static bool inbox = common::option_flag<tags::inbox, false, Ts...> or deterministic;
+
     //! @brief Whether message sizes should be emulated.
     constexpr static bool message_size = common::option_flag<tags::message_size, false, Ts...>;
 
@@ -112,7 +137,7 @@ struct graph_connector {
              * @param t A `tagged_tuple` gathering initialisation values.
              */
             template <typename S, typename T>
-            node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), m_delay(get_generator(has_randomizer<P>{}, *this),t), m_nbr_msg_size(0) {
+            node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), m_delay(get_generator(has_randomizer<P>{}, *this),t), m_nbr_msg_size(0), m_incoming_size(no_size) {
                 m_send = TIME_MAX;
             }
 
@@ -153,13 +178,23 @@ struct graph_connector {
             }
 
             //! @brief Size of last message sent.
+            size_t msg_size() {
+                return fcpp::details::self(m_nbr_msg_size.front().build(), P::node::uid);
+            }
+
+            //! @brief Size of last message sent (const access).
             size_t msg_size() const {
-                return fcpp::details::self(m_nbr_msg_size.front(), P::node::uid);
+                return m_nbr_msg_size.front().self(P::node::uid);
             }
 
             //! @brief Sizes of messages received from neighbours.
-            field<size_t> const& nbr_msg_size() const {
-                return m_nbr_msg_size.front();
+            field<size_t> const& nbr_msg_size() {
+                return m_nbr_msg_size.front().build();
+            }
+
+            //! @brief Sizes of messages received from neighbours (const access, by copy).
+            field<size_t> nbr_msg_size() const {
+                return m_nbr_msg_size.front().merged();
             }
 
             /**
@@ -173,6 +208,7 @@ struct graph_connector {
 
             //! @brief Updates the internal status of node component.
             void update() {
+                if (inbox) process_inbox();
                 times_t t = m_send;
                 times_t pt = P::node::next();
                 if (t < pt) {
@@ -181,13 +217,20 @@ struct graph_connector {
                     m_send = TIME_MAX;
                     typename F::node::message_t m;
                     P::node::as_final().send(t, m);
-                    P::node::as_final().receive(t, P::node::uid, m);
+                    size_t sz = send_size(common::number_sequence<message_size>{}, m);
+                    receive_sized(t, P::node::uid, m, sz);
+                    if (inbox) {
+                        letter_type l{t, P::node::uid, P::node::net.batch(), std::make_shared<typename F::node::message_t const>(std::move(m)), sz};
+                        for (std::pair<device_t, typename F::node*> p : m_neighbours.first())
+                            if (p.second != this) p.second->m_inbox.push(l);
+                        return;
+                    }
                     common::unlock_guard<parallel> u(P::node::mutex);
                     for (std::pair<device_t, typename F::node*> p : m_neighbours.first()) {
                         typename F::node *n = p.second;
                         if (n != this) {
                             common::lock_guard<parallel> l(n->mutex);
-                            n->receive(t, P::node::uid, m);
+                            n->receive_sized(t, P::node::uid, m, sz);
                         }
                     }
                 } else P::node::update();
@@ -196,8 +239,10 @@ struct graph_connector {
 
             //! @brief Performs computations at round start with current time `t`.
             void round_start(times_t t) {
+                check_lookahead(has_identifier<P>{});
                 m_send = t + m_delay(get_generator(has_randomizer<P>{}, *this), common::tagged_tuple_t<>{});
                 P::node::round_start(t);
+                for (auto& b : m_nbr_msg_size) b.build();
             }
 
             //! @brief Performs computations at round end with current time `t`.
@@ -212,19 +257,74 @@ struct graph_connector {
                 receive_size(common::number_sequence<message_size>{}, d, m);
             }
 
+            //! @brief Receives an incoming message, whose serialised size `sz` has been computed by the sender.
+            template <typename S, typename T>
+            inline void receive_sized(times_t t, device_t d, common::tagged_tuple<S,T> const& m, size_t sz) {
+                m_incoming_size = sz;
+                P::node::as_final().receive(t, d, m);
+                // reset also if the message did not reach this component
+                m_incoming_size = no_size;
+            }
+
           private: // implementation details
             //! @brief Stores the list of neighbours in the graph.
             using neighbour_list = std::unordered_map<device_t, typename F::node*>;
 
+            //! @brief A message waiting in an inbox, together with the sending time, device, batch of events and serialised size.
+            struct letter_type {
+                times_t time;
+                device_t uid;
+                size_t batch;
+                std::shared_ptr<void const> message;
+                size_t size;
+            };
+
+            //! @brief Checks that there is no lookahead, since messages are not sent ahead of its window.
+            inline void check_lookahead(std::true_type) const {
+                assert(P::node::net.lookahead() == 0);
+            }
+
+            //! @brief Does not check anything without an identifier.
+            inline void check_lookahead(std::false_type) const {}
+
+            //! @brief Receives the messages in the inbox (sent in previous batches if `deterministic`), by increasing time and sender.
+            void process_inbox() {
+                if (m_inbox.empty() and m_letters.empty()) return;
+                m_inbox.pop(m_letters);
+                auto e = m_letters.end();
+                if (deterministic) {
+                    size_t b = P::node::net.batch();
+                    e = std::partition(m_letters.begin(), m_letters.end(), [b] (letter_type const& l) {
+                        return l.batch < b;
+                    });
+                }
+                std::sort(m_letters.begin(), e, [] (letter_type const& x, letter_type const& y) {
+                    return x.time < y.time or (x.time == y.time and x.uid < y.uid);
+                });
+                for (auto it = m_letters.begin(); it != e; ++it)
+                    receive_sized(it->time, it->uid, *static_cast<typename F::node::message_t const*>(it->message.get()), it->size);
+                m_letters.erase(m_letters.begin(), e);
+            }
+
             //! @brief Stores size of received message (disabled).
             template <typename S, typename T>
             void receive_size(common::number_sequence<false>, device_t, common::tagged_tuple<S,T> const&) {}
             //! @brief Stores size of received message.
             template <typename S, typename T>
             void receive_size(common::number_sequence<true>, device_t d, common::tagged_tuple<S,T> const& m) {
-                common::osstream os;
-                os << m;
-                fcpp::details::self(m_nbr_msg_size.front(), d) = os.size();
+                size_t sz = m_incoming_size == no_size ? common::serialized_size_of(m) : m_incoming_size;
+                m_nbr_msg_size.front().insert(d, sz);
+            }
+
+            //! @brief Size of a message to be sent (disabled).
+            template <typename S, typename T>
+            static constexpr size_t send_size(common::number_sequence<false>, common::tagged_tuple<S,T> const&) {
+                return no_size;
+            }
+            //! @brief Size of a message to be sent (enabled), computed once for all receivers.
+            template <typename S, typename T>
+            static size_t send_size(common::number_sequence<true>, common::tagged_tuple<S,T> const& m) {
+                return common::serialized_size_of(m);
             }
 
             //! @brief Returns the `randomizer` generator if available.
@@ -249,7 +349,19 @@ struct graph_connector {
             times_t m_send;
 
             //! @brief Sizes of messages received from neighbours.
-            common::option<field<size_t>, message_size> m_nbr_msg_size;
+            common::option<fcpp::details::field_builder<size_t>, message_size> m_nbr_msg_size;
+
+            //! @brief Placeholder for message sizes not known in advance.
+            constexpr static size_t no_size = size_t(-1);
+
+            //! @brief Size of the message being received, if computed by the sender (`no_size` otherwise).
+            size_t m_incoming_size;
+
+            //! @brief Messages sent to the node and not yet received.
+            common::inbox<parallel, letter_type> m_inbox;
+
+            //! @brief Messages being received (reused across events).
+            std::vector<letter_type> m_letters;
         };
 
         //! @brief The global part of the component.
@@ -257,13 +369,24 @@ struct graph_connector {
           public: // visible by node objects and the main program
             //! @brief Constructor from a tagged tuple.
             template <typename S, typename T>
-            explicit net(common::tagged_tuple<S,T> const& t) : P::net(t) {}
+            explicit net(common::tagged_tuple<S,T> const& t) : P::net(t), m_batch(0) {}
 
             //! @brief Destructor ensuring that nodes are deleted first.
             ~net() {
                 maybe_clear(has_identifier<P>{}, *this);
             }
 
+            //! @brief Updates the internal status of net component, starting a new batch of events.
+            void update() {
+                ++m_batch;
+                P::net::update();
+            }
+
+            //! @brief The number of the current batch of events.
+            inline size_t batch() const {
+                return m_batch;
+            }
+
           private: // implementation details
             //! @brief Returns the `randomizer` generator if available.
             template <typename N>
@@ -289,6 +412,9 @@ struct graph_connector {
 
             //! @brief The mutex regulating access to maps.
             common::mutex<parallel> m_mutex;
+
+            //! @brief The number of the current batch of events.
+            size_t m_batch;
         };
     };
 };
@@ -9,12 +9,15 @@
 #define FCPP_COMMON_ALGORITHM_H_
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iterator>
 #include <set>
 #include <type_traits>
 #include <unordered_set>
 #include <vector>
 #ifndef FCPP_DISABLE_THREADS
+#include <condition_variable>
 #include <mutex>
 #include <thread>
 #else
@@ -96,6 +99,20 @@ namespace tags {
         size_t size;
     };
 
+    //! @brief Tag for parallel execution policy, assigning contiguous ranges of tasks to threads which steal chunks from each other when idle (with a given number of threads and chunk size).
+    struct stealing_execution {
+        //! @brief Constructor.
+        explicit stealing_execution(size_t n = std::thread::hardware_concurrency(), size_t s = 1) : num(n), size(s) {}
+        //! @brief Parallel threads number.
+        size_t num;
+        //! @brief Chunk size.
+        size_t size;
+    };
+
+    //! @brief Tag for general work-stealing execution policies depending on the template parameter.
+    template <bool parallel>
+    using general_stealing_execution = std::conditional_t<parallel, stealing_execution, sequential_execution>;
+
     //! @brief Tag for distributed execution policy, assigning tasks dynamically across and within nodes through MPI (with a given number of threads per node, chunk size, static-dynamic percentage, and whether tasks should be shuffled).
     struct distributed_execution {
         //! @brief Constructor.
@@ -253,6 +270,178 @@ inline void nth_elements(E efirst, E elast, I ifirst, I ilast) {
 }
 
 
+#if !defined(_OPENMP)
+//! @cond INTERNAL
+namespace details {
+#ifndef FCPP_DISABLE_THREADS
+    /**
+     * @brief Process-wide pool of persistent worker threads, parked while idle.
+     *
+     * Runs one job at a time: concurrent or nested requests are rejected, and should be served otherwise.
+     */
+    class thread_pool {
+      public:
+        //! @brief The unique pool instance.
+        static thread_pool& instance() {
+            static thread_pool pool;
+            return pool;
+        }
+
+        //! @brief Destructor stopping and joining the workers.
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> l(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (std::thread& t : m_workers) t.join();
+        }
+
+        //! @brief Runs `f(t)` for `t < n`, with `t = 0` on the calling thread (returns false without running if the pool is busy).
+        template <typename F>
+        bool run(size_t n, F& f) {
+            if (m_busy.test_and_set()) return false;
+            while (m_workers.size() + 1 < n) m_workers.emplace_back(&thread_pool::work, this, m_workers.size() + 1);
+            {
+                std::lock_guard<std::mutex> l(m_mutex);
+                m_job = [] (void* g, size_t t) {
+                    (*static_cast<F*>(g))(t);
+                };
+                m_context = &f;
+                m_active = n;
+                m_pending = n - 1;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+            f(0);
+            {
+                std::unique_lock<std::mutex> l(m_mutex);
+                m_done.wait(l, [this] () {
+                    return m_pending == 0;
+                });
+            }
+            m_busy.clear();
+            return true;
+        }
+
+      private:
+        //! @brief Default constructor.
+        thread_pool() = default;
+
+        //! @brief The loop of worker `t`, waiting for jobs and running them if they involve it.
+        void work(size_t t) {
+            size_t seen = 0;
+            std::unique_lock<std::mutex> l(m_mutex);
+            while (true) {
+                m_wake.wait(l, [this,&seen] () {
+                    return m_stop or m_generation != seen;
+                });
+                if (m_stop) return;
+                seen = m_generation;
+                if (t >= m_active) continue;
+                l.unlock();
+                m_job(m_context, t);
+                l.lock();
+                if (--m_pending == 0) m_done.notify_one();
+            }
+        }
+
+        //! @brief Flag set while a job is running.
+        std::atomic_flag m_busy = ATOMIC_FLAG_INIT;
+
+        //! @brief Lock guarding the job data.
+        std::mutex m_mutex;
+
+        //! @brief Condition variables for waking up workers and the job owner.
+        std::condition_variable m_wake, m_done;
+
+        //! @brief The worker threads.
+        std::vector<std::thread> m_workers;
+
+        //! @brief The current job and its context.
+        void (*m_job)(void*, size_t) = nullptr;
+        void* m_context = nullptr;
+
+        //! @brief Number of threads involved in the current job, and of workers still running it.
+        size_t m_active = 0, m_pending = 0;
+
+        //! @brief Counter of the jobs submitted.
+        size_t m_generation = 0;
+
+        //! @brief Whether the workers should stop.
+        bool m_stop = false;
+    };
+#endif
+
+    //! @brief Whether the current thread is running a task of a parallel loop.
+    inline bool& parallel_task() {
+        static thread_local bool b = false;
+        return b;
+    }
+
+    //! @brief Runs `f(t)` for `t < n` in parallel, on the persistent thread pool if available.
+    template <typename F>
+    void parallel_run(size_t n, F&& f) {
+        if (n == 0) return;
+        auto g = [&f] (size_t t) {
+            bool& b = parallel_task();
+            bool outer = b;
+            b = true;
+            f(t);
+            b = outer;
+        };
+#ifndef FCPP_DISABLE_THREADS
+        if (thread_pool::instance().run(n, g)) return;
+#endif
+        std::vector<std::thread> pool;
+        pool.reserve(n);
+        for (size_t t=0; t<n; ++t)
+            pool.emplace_back([t,&g] () {
+                g(t);
+            });
+        for (std::thread& t : pool) t.join();
+    }
+}
+//! @endcond
+#endif
+
+
+//! @cond INTERNAL
+namespace details {
+    /**
+     * @brief Executes the tasks in the range of thread `t`, stealing chunks from the ranges of other threads when it is over.
+     *
+     * Ranges are packed as `begin << 32 | end`, and shrink from the front by their owner and from the back by thieves.
+     */
+    template <typename F>
+    void steal_run(size_t t, std::vector<std::atomic<uint64_t>>& ranges, size_t size, F& f) {
+        size_t n = ranges.size();
+        while (true) {
+            uint64_t r = ranges[t].load();
+            while ((r >> 32) < (r & 0xFFFFFFFF)) {
+                uint64_t b = r >> 32, e = std::min<uint64_t>(b + size, r & 0xFFFFFFFF);
+                if (ranges[t].compare_exchange_weak(r, e << 32 | (r & 0xFFFFFFFF)))
+                    for (size_t i=b; i<e; ++i) f(i,t);
+            }
+            bool stolen = false;
+            for (size_t v = (t+1) % n; v != t and not stolen; v = (v+1) % n) {
+                uint64_t q = ranges[v].load();
+                while (not stolen and (q >> 32) < (q & 0xFFFFFFFF)) {
+                    uint64_t b = q >> 32, e = q & 0xFFFFFFFF;
+                    uint64_t m = e - std::min<uint64_t>(e - b, std::max<uint64_t>(size, (e - b) / 2));
+                    if (ranges[v].compare_exchange_weak(q, b << 32 | m)) {
+                        ranges[t].store(m << 32 | e);
+                        stolen = true;
+                    }
+                }
+            }
+            if (not stolen) return;
+        }
+    }
+}
+//! @endcond
+
+
 /**
  * @brief Bypassable parallel for (sequential version).
  *
@@ -268,6 +457,20 @@ void parallel_for(tags::sequential_execution, size_t len, F&& f) {
 }
 
 
+/**
+ * @brief Whether the calling thread is running within a parallel loop.
+ *
+ * Loops nested in a parallel loop are better run sequentially, as the threads available are already busy.
+ */
+inline bool in_parallel() {
+#if defined(_OPENMP)
+    return omp_in_parallel();
+#else
+    return details::parallel_task();
+#endif
+}
+
+
 #if defined(_OPENMP)
 /**
  * @brief Bypassable parallel for (parallel OpenMP version).
@@ -301,13 +504,9 @@ void parallel_for(tags::parallel_execution e, size_t len, F&& f) {
         parallel_for(tags::sequential_execution{}, len, f);
         return;
     }
-    std::vector<std::thread> pool;
-    pool.reserve(e.num);
-    for (size_t t=0; t<std::min(e.num,len); ++t)
-        pool.emplace_back([=,&f] () {
-            for (size_t i=t; i<len; i+=e.num) f(i,t);
-        });
-    for (std::thread& t : pool) t.join();
+    details::parallel_run(std::min(e.num,len), [=,&f] (size_t t) {
+        for (size_t i=t; i<len; i+=e.num) f(i,t);
+    });
 }
 #endif
 
@@ -345,27 +544,54 @@ void parallel_for(tags::dynamic_execution e, size_t len, F&& f) {
         parallel_for(tags::sequential_execution{}, len, f);
         return;
     }
-    std::vector<std::thread> pool;
-    pool.reserve(e.num);
-    std::mutex m;
-    size_t i=0;
-    for (size_t t=0; t<std::min(e.num,len); ++t)
-        pool.emplace_back([=,&i,&f,&m] () {
-            size_t j;
-            while (true) {
-                m.lock();
-                j = i;
-                i += e.size;
-                m.unlock();
-                if (j >= len) break;
-                for (size_t k=j; k<j+e.size and k<len; ++k) f(k,t);
-            }
-        });
-    for (std::thread& t : pool) t.join();
+    std::atomic<size_t> i{0};
+    details::parallel_run(std::min(e.num,len), [=,&i,&f] (size_t t) {
+        while (true) {
+            size_t j = i.fetch_add(e.size);
+            if (j >= len) break;
+            for (size_t k=j; k<j+e.size and k<len; ++k) f(k,t);
+        }
+    });
 }
 #endif
 
 
+/**
+ * @brief Bypassable parallel for (parallel version with work stealing).
+ *
+ * Executes a function (with index and thread number as arguments) for indices up to `len`.
+ * Every thread starts from a contiguous range of indices, preserving locality, and steals chunks from others when idle.
+ * The thread numbers range from zero to `n-1`.
+ *
+ * @param e   The policy determining the number of threads to be spawned and chunk size.
+ * @param len The maximum index fed to the function.
+ * @param f   The function `void(size_t,size_t)` to be executed.
+ */
+template <typename F>
+void parallel_for(tags::stealing_execution e, size_t len, F&& f) {
+    size_t n = std::min(e.num, len);
+    if (n <= 1) {
+        parallel_for(tags::sequential_execution{}, len, f);
+        return;
+    }
+    if (len >= (size_t(1) << 32)) {
+        parallel_for(tags::dynamic_execution(e.num, e.size), len, f);
+        return;
+    }
+    std::vector<std::atomic<uint64_t>> ranges(n);
+    for (size_t t=0; t<n; ++t)
+        ranges[t].store(uint64_t(t*len/n) << 32 | uint64_t((t+1)*len/n));
+#if defined(_OPENMP)
+    #pragma omp parallel num_threads(n)
+    details::steal_run(omp_get_thread_num(), ranges, std::max<size_t>(e.size, 1), f);
+#else
+    details::parallel_run(n, [&ranges,&e,&f] (size_t t) {
+        details::steal_run(t, ranges, std::max<size_t>(e.size, 1), f);
+    });
+#endif
+}
+
+
 /**
  * @brief Bypassable parallel while (sequential version).
  *
@@ -411,13 +637,9 @@ void parallel_while(tags::parallel_execution e, F&& f) {
         parallel_while(tags::sequential_execution{}, f);
         return;
     }
-    std::vector<std::thread> pool;
-    pool.reserve(e.num);
-    for (size_t t=0; t<e.num; ++t)
-        pool.emplace_back([=,&f] () {
-            for (size_t i=t; f(i,t); i+=e.num);
-        });
-    for (std::thread& t : pool) t.join();
+    details::parallel_run(e.num, [=,&f] (size_t t) {
+        for (size_t i=t; f(i,t); i+=e.num);
+    });
 }
 #endif
 
@@ -453,23 +675,14 @@ void parallel_while(tags::dynamic_execution e, F&& f) {
         parallel_while(tags::sequential_execution{}, f);
         return;
     }
-    std::vector<std::thread> pool;
-    pool.reserve(e.num);
-    std::mutex m;
-    size_t i=0;
-    for (size_t t=0; t<e.num; ++t)
-        pool.emplace_back([=,&i,&f,&m] () {
-            size_t j;
-            while (true) {
-                m.lock();
-                j = i;
-                i += e.size;
-                m.unlock();
-                for (size_t k=j; k<j+e.size; ++k)
-                    if (not f(k,t)) return;
-            }
-        });
-    for (std::thread& t : pool) t.join();
+    std::atomic<size_t> i{0};
+    details::parallel_run(e.num, [=,&i,&f] (size_t t) {
+        while (true) {
+            size_t j = i.fetch_add(e.size);
+            for (size_t k=j; k<j+e.size; ++k)
+                if (not f(k,t)) return;
+        }
+    });
 }
 #endif
 
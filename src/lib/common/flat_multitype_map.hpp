@@ -0,0 +1,587 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file flat_multitype_map.hpp
+ * @brief Implementation of the `flat_multitype_map<T, Ts...>` class template for handling heterogeneous indexed data in contiguous memory.
+ */
+
+#ifndef FCPP_COMMON_FLAT_MULTITYPE_MAP_H_
+#define FCPP_COMMON_FLAT_MULTITYPE_MAP_H_
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lib/common/serialize.hpp"
+#include "lib/common/tagged_tuple.hpp"
+#include "lib/common/traits.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Namespace containing objects of common use.
+ */
+namespace common {
+
+
+//! @cond INTERNAL
+namespace details {
+    //! @brief Maximum number of unsorted keys kept before sorting them in.
+    constexpr size_t flat_tail_size = 16;
+
+    /**
+     * @brief Set of keys stored in a sorted array, followed by a short unsorted tail of recent insertions.
+     *
+     * @param T Key type.
+     */
+    template <typename T>
+    class flat_keys {
+      public:
+        //! @brief Equality operator.
+        bool operator==(flat_keys const& o) const {
+            if (size() != o.size()) return false;
+            for (T k : m_keys) if (o.find(k) == o.size()) return false;
+            return true;
+        }
+
+        //! @brief Number of keys stored.
+        size_t size() const {
+            return m_keys.size();
+        }
+
+        //! @brief Number of keys in the unsorted tail.
+        size_t tail() const {
+            return m_keys.size() - m_sorted;
+        }
+
+        //! @brief Key at a given position.
+        T operator[](size_t i) const {
+            return m_keys[i];
+        }
+
+        //! @brief Position of a key (or `size()` if not present).
+        size_t find(T key) const {
+            auto end = m_keys.begin() + m_sorted;
+            auto it = std::lower_bound(m_keys.begin(), end, key);
+            if (it != end and *it == key) return it - m_keys.begin();
+            for (size_t i = m_sorted; i < m_keys.size(); ++i)
+                if (m_keys[i] == key) return i;
+            return m_keys.size();
+        }
+
+        //! @brief Appends a key, returning its position (nothing is appended if the key is already present).
+        size_t insert(T key) {
+            size_t i = find(key);
+            if (i == m_keys.size()) m_keys.push_back(key);
+            return i;
+        }
+
+        //! @brief Erases the key at a given position.
+        void erase(size_t i) {
+            m_keys.erase(m_keys.begin() + i);
+            if (i < m_sorted) --m_sorted;
+        }
+
+        //! @brief Erases every key (keeping the allocated memory).
+        void clear() {
+            m_keys.clear();
+            m_sorted = 0;
+        }
+
+        //! @brief Sorts the tail into the array.
+        void compact() {
+            compact([](size_t const*){});
+        }
+
+        /**
+         * @brief Sorts the tail into the array, passing the permutation applied to a function (if any).
+         *
+         * The permutation is given as an array of `size()` old positions, in their new order.
+         * Scratch space is kept between calls, so that compacting allocates no memory in a steady state.
+         */
+        template <typename F>
+        void compact(F&& f) {
+            size_t n = m_keys.size(), t = n - m_sorted;
+            if (t == 0) return;
+            // the sorted positions of the tail, followed by the merged permutation
+            m_perm.resize(t + n);
+            size_t* tail = m_perm.data();
+            size_t* perm = tail + t;
+            for (size_t i = 0; i < t; ++i) tail[i] = m_sorted + i;
+            std::sort(tail, perm, [this](size_t i, size_t j) {
+                return m_keys[i] < m_keys[j];
+            });
+            for (size_t i = 0, j = 0, k = 0; k < n; ++k)
+                perm[k] = j == t or (i < m_sorted and m_keys[i] < m_keys[tail[j]]) ? i++ : tail[j++];
+            m_buffer.clear();
+            for (size_t k = 0; k < n; ++k) m_buffer.push_back(m_keys[perm[k]]);
+            m_keys.swap(m_buffer);
+            m_buffer.clear();
+            m_sorted = n;
+            f(static_cast<size_t const*>(perm));
+            m_perm.clear();
+        }
+
+        //! @brief Serialises the content from a given input stream (keys at full width, leaving all keys unsorted).
+        sstream<false>& serialize(sstream<false>& s) {
+            size_t n = 0;
+            size_variable_read(s, n);
+            m_keys.clear();
+            for (size_t i = 0; i < n; ++i) {
+                T k;
+                key_serialize(s, k);
+                m_keys.push_back(k);
+            }
+            m_sorted = 0;
+            return s;
+        }
+
+        //! @brief Serialises the content to a given output stream (keys at full width).
+        template <typename S>
+        S& serialize(S& s) const {
+            size_variable_write(s, m_keys.size());
+            for (T k : m_keys) key_serialize(s, k);
+            return s;
+        }
+
+      private:
+        //! @brief The keys (sorted up to `m_sorted`).
+        std::vector<T> m_keys;
+        //! @brief Length of the sorted prefix of keys.
+        size_t m_sorted = 0;
+        //! @brief Scratch space for permutations (empty between compactions).
+        std::vector<size_t> m_perm;
+        //! @brief Scratch space for keys (empty between compactions).
+        std::vector<T> m_buffer;
+    };
+
+    //! @brief Wrapper of a value (avoiding the `std::vector<bool>` specialisation).
+    template <typename V>
+    struct flat_box {
+        //! @brief The value wrapped.
+        V value;
+
+        //! @brief Serialises the content from/to a given input/output stream.
+        template <typename S>
+        S& serialize(S& s) {
+            return s & value;
+        }
+
+        //! @brief Serialises the content from/to a given input/output stream (const overload).
+        template <typename S>
+        S& serialize(S& s) const {
+            return s << value;
+        }
+    };
+
+    /**
+     * @brief Map stored as a flat array of keys and a parallel flat array of values.
+     *
+     * @param T Key type.
+     * @param V Value type.
+     */
+    template <typename T, typename V>
+    class flat_table {
+      public:
+        //! @brief Number of values stored.
+        size_t size() const {
+            return m_keys.size();
+        }
+
+        //! @brief Key at a given position.
+        T key(size_t i) const {
+            return m_keys[i];
+        }
+
+        //! @brief Value at a given position.
+        V const& value(size_t i) const {
+            return m_vals[i].value;
+        }
+
+        //! @brief Mutable value at a given position.
+        V& value(size_t i) {
+            return m_vals[i].value;
+        }
+
+        //! @brief Position of a key (or `size()` if not present).
+        size_t find(T key) const {
+            return m_keys.find(key);
+        }
+
+        //! @brief Inserts or replaces the value at a key.
+        template <typename A>
+        void insert(T key, A&& value) {
+            size_t i = m_keys.insert(key);
+            if (i < m_vals.size()) {
+                m_vals[i].value = std::forward<A>(value);
+                return;
+            }
+            m_vals.push_back({std::forward<A>(value)});
+            if (m_keys.tail() >= flat_tail_size) compact();
+        }
+
+        //! @brief Erases the value at a key (if present).
+        void erase(T key) {
+            size_t i = m_keys.find(key);
+            if (i == m_keys.size()) return;
+            m_keys.erase(i);
+            m_vals.erase(m_vals.begin() + i);
+        }
+
+        //! @brief Erases every value (keeping the allocated memory).
+        void clear() {
+            m_keys.clear();
+            m_vals.clear();
+        }
+
+        //! @brief Sorts the recent insertions into the arrays (reusing scratch space across calls).
+        void compact() {
+            m_keys.compact([this](size_t const* idx) {
+                m_buffer.clear();
+                for (size_t k = 0; k < m_vals.size(); ++k) m_buffer.push_back(std::move(m_vals[idx[k]]));
+                m_vals.swap(m_buffer);
+                m_buffer.clear();
+            });
+        }
+
+        //! @brief Serialises the content from a given input stream.
+        sstream<false>& serialize(sstream<false>& s) {
+            s >> m_keys >> m_vals;
+            compact();
+            return s;
+        }
+
+        //! @brief Serialises the content to a given output stream.
+        template <typename S>
+        S& serialize(S& s) const {
+            return s << m_keys << m_vals;
+        }
+
+      private:
+        //! @brief The keys.
+        flat_keys<T> m_keys;
+        //! @brief The values, in the same order as the keys.
+        std::vector<flat_box<V>> m_vals;
+        //! @brief Scratch space for values (empty between compactions).
+        std::vector<flat_box<V>> m_buffer;
+    };
+}
+//! @endcond
+
+
+/**
+ * @brief Class for handling heterogeneous indexed data in contiguous memory.
+ *
+ * Provides the same interface as @ref multitype_map, storing for each value type a sorted array of keys
+ * together with a parallel array of values, so that lookups are cache-local binary searches.
+ * Insertions are appended to a short unsorted tail, which is merged into the arrays by @ref compact
+ * (or automatically when it grows too long). Calling @ref compact once after the last insertion
+ * (e.g., at round end for exports) ensures that subsequent lookups never scan the tail.
+ *
+ * \ref insert "Inserting" elements of types outside `Ts...` produces a compile-time error. Other kinds of access are supported on any types, where maps on unsupported types are assumed to be always empty (since it is not allowed to insert in them).
+ *
+ * @param T Key type.
+ * @param Ts Admissible value types.
+ */
+template <typename T, typename... Ts>
+class flat_multitype_map {
+    //! @brief Checks whether a type is supported by the map.
+    template <typename A>
+    constexpr static bool type_supported = type_count<std::remove_reference_t<A>, Ts...> != 0;
+
+  public:
+    //! @brief The type of the keys.
+    typedef T key_type;
+
+    //! @brief List of admissible types (without repetitions).
+    using value_types = type_uniq<Ts...>;
+
+    //! @brief List of table types (without repetitions).
+    using map_types = type_uniq<details::flat_table<T, Ts>...>;
+
+    //! @name constructors
+    //! @{
+    /**
+     * @brief Default constructor (creates an empty structure).
+     */
+    flat_multitype_map() = default;
+
+    //! @brief Copy constructor.
+    flat_multitype_map(flat_multitype_map const&) = default;
+
+    //! @brief Move constructor.
+    flat_multitype_map(flat_multitype_map&&) = default;
+    //! @}
+
+    //! @name assignment operators
+    //! @{
+
+    //! @brief Copy assignment.
+    flat_multitype_map& operator=(flat_multitype_map const&) = default;
+
+    //! @brief Move assignment.
+    flat_multitype_map& operator=(flat_multitype_map&&) = default;
+    //! @}
+
+    //! @brief Exchanges contents of multitype maps.
+    void swap(flat_multitype_map& m) {
+        std::swap(m_keys, m.m_keys);
+        std::swap(m_data, m.m_data);
+    }
+
+    //! @brief Equality operator.
+    bool operator==(flat_multitype_map const& o) const {
+        return m_keys == o.m_keys and maps_compare(m_data, o.m_data, value_types{});
+    }
+
+    //! @cond INTERNAL
+    #define MISSING_TYPE_MESSAGE "unsupported type access (add type A to exports type list)"
+    //! @endcond
+
+    //! @brief Inserts value at corresponding key.
+    template<typename A>
+    void insert(T key, A const& value) {
+        get_map<A>(number_sequence<type_supported<A>>{}).insert(key, value);
+        static_assert(type_supported<A>, MISSING_TYPE_MESSAGE);
+    }
+
+    //! @brief Inserts value at corresponding key by moving.
+    template<typename A, typename = std::enable_if_t<not std::is_reference<A>::value>>
+    void insert(T key, A&& value) {
+        get_map<A>(number_sequence<type_supported<A>>{}).insert(key, std::move(value));
+        static_assert(type_supported<A>, MISSING_TYPE_MESSAGE);
+    }
+
+    #undef MISSING_TYPE_MESSAGE
+
+    //! @brief Inserts void value at corresponding key.
+    void insert(T key) {
+        m_keys.insert(key);
+        if (m_keys.tail() >= details::flat_tail_size) m_keys.compact();
+    }
+
+    //! @brief Inserts the contents of another multitype map (without overwriting).
+    void insert(flat_multitype_map const& m) {
+        for (size_t i = 0; i < m.m_keys.size(); ++i) insert(m.m_keys[i]);
+        multi_insert(m, value_types{});
+    }
+
+    //! @brief Deletes value at corresponding key.
+    template<typename A>
+    void erase(T key) {
+        get_map<A>(number_sequence<type_supported<A>>{}).erase(key);
+    }
+
+    //! @brief Deletes void value at corresponding key.
+    void remove(T key) {
+        size_t i = m_keys.find(key);
+        if (i < m_keys.size()) m_keys.erase(i);
+    }
+
+    //! @brief Deletes every value (keeping the allocated memory).
+    void clear() {
+        m_keys.clear();
+        multi_clear(value_types{});
+    }
+
+    //! @brief Immutable reference to the value of a certain type at a given key.
+    template<typename A>
+    A const& at(T key) const {
+        auto const& m = get_map<A>(number_sequence<type_supported<A>>{});
+        size_t i = m.find(key);
+        assert(i < m.size());
+        return m.value(i);
+    }
+
+    //! @brief Mutable reference to the value of a certain type at a given key.
+    template<typename A>
+    A& at(T key) {
+        auto& m = get_map<A>(number_sequence<type_supported<A>>{});
+        size_t i = m.find(key);
+        assert(i < m.size());
+        return m.value(i);
+    }
+
+    //! @brief Pointer to the value of a certain type at a given key (`nullptr` if not present).
+    template<typename A>
+    A const* find(T key) const {
+        auto const& m = get_map<A>(number_sequence<type_supported<A>>{});
+        size_t i = m.find(key);
+        return i < m.size() ? &m.value(i) : nullptr;
+    }
+
+    //! @brief Whether the key is present in the value map or not for a certain type.
+    template<typename A>
+    bool count(T key) const {
+        auto const& m = get_map<A>(number_sequence<type_supported<A>>{});
+        return m.find(key) < m.size();
+    }
+
+    //! @brief Whether the key is present in the value map or not for the void type.
+    bool contains(T key) const {
+        return m_keys.find(key) < m_keys.size();
+    }
+
+    //! @brief Applies a function to every key-value pair of a certain type.
+    template<typename A, typename F>
+    void for_each(F&& f) const {
+        auto const& m = get_map<A>(number_sequence<type_supported<A>>{});
+        for (size_t i = 0; i < m.size(); ++i) f(m.key(i), m.value(i));
+    }
+
+    //! @brief Applies a function to every key of the void type.
+    template<typename F>
+    void for_each_key(F&& f) const {
+        for (size_t i = 0; i < m_keys.size(); ++i) f(m_keys[i]);
+    }
+
+    //! @brief Sorts every pending insertion into the flat arrays.
+    void compact() {
+        m_keys.compact();
+        multi_compact(value_types{});
+    }
+
+    //! @brief Prints the content of the multitype map.
+    template <typename O>
+    void print(O& o) const {
+        multi_print(o, value_types{});
+    }
+
+    //! @brief Serialises the content from a given input stream.
+    sstream<false>& serialize(sstream<false>& s) {
+        s >> m_data >> m_keys;
+        m_keys.compact();
+        return s;
+    }
+
+    //! @brief Serialises the content to a given output stream.
+    template <typename S>
+    S& serialize(S& s) const {
+        return s << m_data << m_keys;
+    }
+
+  private:
+    //! @brief Access to the table corresponding to a type.
+    template <typename A>
+    details::flat_table<T, std::remove_reference_t<A>>& get_map(number_sequence<true>) {
+        return get<std::remove_reference_t<A>>(m_data);
+    }
+
+    //! @brief Const access to the table corresponding to a type.
+    template <typename A>
+    details::flat_table<T, std::remove_reference_t<A>> const& get_map(number_sequence<true>) const {
+        return get<std::remove_reference_t<A>>(m_data);
+    }
+
+    //! @brief Access to a table corresponding to a missing type.
+    template <typename A>
+    details::flat_table<T, std::remove_reference_t<A>>& get_map(number_sequence<false>) const {
+        assert(false);
+        return common::declare_reference<details::flat_table<T, std::remove_reference_t<A>>>();
+    }
+
+    //! @brief Compares tables, even in case `decltype(U == U)` is not implicitly convertible to bool.
+    template <typename U>
+    bool map_compare(details::flat_table<T, U> const& x, details::flat_table<T, U> const& y) const {
+        if (x.size() != y.size()) return false;
+        for (size_t i = 0; i < x.size(); ++i) {
+            size_t j = y.find(x.key(i));
+            if (j == y.size()) return false;
+            if (x.value(i) != y.value(j)) return false;
+        }
+        return true;
+    }
+
+    //! @brief Compares tagged tuples of tables (no elements).
+    template <typename U>
+    bool maps_compare(U const&, U const&, type_sequence<>) const {
+        return true;
+    }
+
+    //! @brief Compares tagged tuples of tables (some elements).
+    template <typename U, typename S, typename... Ss>
+    bool maps_compare(U const& x, U const& y, type_sequence<S, Ss...>) const {
+        if (not map_compare(get<S>(x), get<S>(y))) return false;
+        return maps_compare(x, y, type_sequence<Ss...>{});
+    }
+
+    //! @brief Inserts the data from another multitype map (empty form).
+    inline void multi_insert(flat_multitype_map const&, common::type_sequence<>) {}
+
+    //! @brief Inserts the data from another multitype map (active form).
+    template <typename S, typename... Ss>
+    inline void multi_insert(flat_multitype_map const& m, common::type_sequence<S, Ss...>) {
+        auto& x = get<S>(m_data);
+        auto const& y = get<S>(m.m_data);
+        for (size_t i = 0; i < y.size(); ++i)
+            if (x.find(y.key(i)) == x.size())
+                x.insert(y.key(i), y.value(i));
+        multi_insert(m, common::type_sequence<Ss...>{});
+    }
+
+    //! @brief Deletes every value (empty form).
+    inline void multi_clear(common::type_sequence<>) {}
+
+    //! @brief Deletes every value (active form).
+    template <typename S, typename... Ss>
+    inline void multi_clear(common::type_sequence<S, Ss...>) {
+        get<S>(m_data).clear();
+        multi_clear(common::type_sequence<Ss...>{});
+    }
+
+    //! @brief Sorts pending insertions in every table (empty form).
+    inline void multi_compact(common::type_sequence<>) {}
+
+    //! @brief Sorts pending insertions in every table (active form).
+    template <typename S, typename... Ss>
+    inline void multi_compact(common::type_sequence<S, Ss...>) {
+        get<S>(m_data).compact();
+        multi_compact(common::type_sequence<Ss...>{});
+    }
+
+    //! @brief Prints the tables in arrowhead format (empty form).
+    template <typename O>
+    inline void multi_print(O&, common::type_sequence<>) const {}
+
+    //! @brief Prints the tables in arrowhead format (active form).
+    template <typename O, typename S, typename... Ss>
+    inline void multi_print(O& o, common::type_sequence<S, Ss...>) const {
+        auto const& m = get<S>(m_data);
+        o << strip_namespaces(type_name<S>()) << " => {";
+        for (size_t i = 0; i < m.size(); ++i) {
+            if (i > 0) o << ", ";
+            o << escape(m.key(i)) << ":" << escape(m.value(i));
+        }
+        o << "}";
+        if (sizeof...(Ss) > 0) o << "; ";
+        multi_print(o, common::type_sequence<Ss...>{});
+    }
+
+    //! @brief Tables associating keys to data.
+    tagged_tuple<value_types, map_types> m_data;
+    //! @brief Set of keys (for void data).
+    details::flat_keys<T> m_keys;
+};
+
+
+//! @brief Exchanges contents of multitype maps.
+template <typename T, typename... Ts>
+void swap(flat_multitype_map<T, Ts...>& x, flat_multitype_map<T, Ts...>& y) {
+    x.swap(y);
+}
+
+
+}
+
+
+}
+
+#endif // FCPP_COMMON_FLAT_MULTITYPE_MAP_H_
@@ -15,6 +15,7 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "lib/common/serialize.hpp"
 #include "lib/common/tagged_tuple.hpp"
 #include "lib/common/traits.hpp"
 
@@ -132,6 +133,12 @@ class multitype_map {
         m_keys.erase(key);
     }
 
+    //! @brief Deletes every value (keeping the allocated bucket arrays, while nodes are freed).
+    void clear() {
+        m_keys.clear();
+        multi_clear(value_types{});
+    }
+
     //! @brief Immutable reference to the value of a certain type at a given key.
     template<typename A>
     A const& at(T key) const {
@@ -155,22 +162,46 @@ class multitype_map {
         return m_keys.count(key);
     }
 
+    //! @brief Applies a function to every key-value pair of a certain type.
+    template<typename A, typename F>
+    void for_each(F&& f) const {
+        for (auto const& x : get_map<A>(number_sequence<type_supported<A>>{}))
+            f(x.first, x.second);
+    }
+
+    //! @brief Applies a function to every key of the void type.
+    template<typename F>
+    void for_each_key(F&& f) const {
+        for (T const& k : m_keys) f(k);
+    }
+
     //! @brief Prints the content of the multitype map.
     template <typename O, typename... Ss>
     void print(O& o, Ss... xs) const {
         m_data.print(o, xs...);
     }
 
-    //! @brief Serialises the content from/to a given input/output stream.
-    template <typename S>
-    S& serialize(S& s) {
-        return s & m_data & m_keys;
+    //! @brief Serialises the content from a given input stream (keys at full width).
+    isstream& serialize(isstream& s) {
+        multi_serialize(s, value_types{});
+        size_t n = 0;
+        details::size_variable_read(s, n);
+        m_keys.clear();
+        for (size_t i = 0; i < n; ++i) {
+            T k;
+            key_serialize(s, k);
+            m_keys.insert(k);
+        }
+        return s;
     }
 
-    //! @brief Serialises the content from/to a given input/output stream (const overload).
+    //! @brief Serialises the content to a given output stream (keys at full width).
     template <typename S>
     S& serialize(S& s) const {
-        return s << m_data << m_keys;
+        multi_serialize(s, value_types{});
+        details::size_variable_write(s, m_keys.size());
+        for (T k : m_keys) key_serialize(s, k);
+        return s;
     }
 
   private:
@@ -227,6 +258,50 @@ class multitype_map {
         multi_insert(m, common::type_sequence<Ss...>{});
     }
 
+    //! @brief Deletes every value (empty form).
+    inline void multi_clear(common::type_sequence<>) {}
+
+    //! @brief Deletes every value (active form).
+    template <typename S, typename... Ss>
+    inline void multi_clear(common::type_sequence<S, Ss...>) {
+        get<S>(m_data).clear();
+        multi_clear(common::type_sequence<Ss...>{});
+    }
+
+    //! @brief Serialises the maps from a given input stream (empty form).
+    inline void multi_serialize(isstream&, common::type_sequence<>) {}
+
+    //! @brief Serialises the maps from a given input stream (active form).
+    template <typename S, typename... Ss>
+    inline void multi_serialize(isstream& s, common::type_sequence<S, Ss...>) {
+        auto& m = get<S>(m_data);
+        size_t n = 0;
+        details::size_variable_read(s, n);
+        m.clear();
+        for (size_t i = 0; i < n; ++i) {
+            T k;
+            key_serialize(s, k);
+            s >> m[k];
+        }
+        multi_serialize(s, common::type_sequence<Ss...>{});
+    }
+
+    //! @brief Serialises the maps to a given output stream (empty form).
+    template <typename O>
+    inline void multi_serialize(O&, common::type_sequence<>) const {}
+
+    //! @brief Serialises the maps to a given output stream (active form).
+    template <typename O, typename S, typename... Ss>
+    inline void multi_serialize(O& s, common::type_sequence<S, Ss...>) const {
+        auto const& m = get<S>(m_data);
+        details::size_variable_write(s, m.size());
+        for (auto const& x : m) {
+            key_serialize(s, x.first);
+            s << x.second;
+        }
+        multi_serialize(s, common::type_sequence<Ss...>{});
+    }
+
     //! @brief Map associating keys to data.
     tagged_tuple<value_types, map_types> m_data;
     //! @brief Set of keys (for void data).
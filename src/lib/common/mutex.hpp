@@ -2,7 +2,7 @@
 
 /**
  * @file mutex.hpp
- * @brief Implementation of the `mutex` class used to manage synchronization in parallel computations and accessory functions (uniform interface for sequential execution and OpenMP and C++14 threads).
+ * @brief Implementation of the `mutex` class used to manage synchronization in parallel computations and accessory functions and classes (uniform interface for sequential execution and OpenMP and C++14 threads).
  */
 
 #ifndef FCPP_COMMON_MUTEX_H_
@@ -10,7 +10,11 @@
 
 #include <cstdint>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <utility>
+#include <vector>
 #ifndef FCPP_DISABLE_THREADS
 #include <mutex>
 #include <shared_mutex>
@@ -477,6 +481,114 @@ inline int try_lock(mutex<true>& a, Ts&... ms) {
 #endif
 
 
+/**
+ * @brief Multiple-producer single-consumer queue, lock-free if `enabled` is true.
+ *
+ * Values can be pushed concurrently by any number of threads, while a single consumer
+ * retrieves all of them at once.
+ *
+ * @param enabled Whether the queue can be accessed concurrently.
+ * @param T The type of the values.
+ */
+template <bool enabled, typename T>
+class inbox;
+
+
+//! @brief Sequential queue when `enabled` is false.
+template <typename T>
+class inbox<false, T> {
+  public:
+    //! @brief Default constructor.
+    inbox() = default;
+
+    //! @brief Deleted copy constructor.
+    inbox(inbox const&) = delete;
+
+    //! @brief Whether the queue is empty.
+    inline bool empty() const {
+        return m_data.empty();
+    }
+
+    //! @brief Inserts a value in the queue.
+    inline void push(T x) {
+        m_data.push_back(std::move(x));
+    }
+
+    //! @brief Moves all the values in the queue (in order of insertion) at the end of a vector.
+    void pop(std::vector<T>& v) {
+        if (v.empty()) std::swap(v, m_data);
+        else for (T& x : m_data) v.push_back(std::move(x));
+        m_data.clear();
+    }
+
+  private:
+    //! @brief The values in the queue.
+    std::vector<T> m_data;
+};
+
+
+#ifdef FCPP_DISABLE_THREADS
+//! @brief Sequential queue when threads are not available.
+template <typename T>
+class inbox<true, T> : public inbox<false, T> {};
+#else
+//! @brief Lock-free queue when `enabled` is true.
+template <typename T>
+class inbox<true, T> {
+  public:
+    //! @brief Default constructor.
+    inbox() : m_head(nullptr) {}
+
+    //! @brief Deleted copy constructor.
+    inbox(inbox const&) = delete;
+
+    //! @brief Destructor.
+    ~inbox() {
+        clear(m_head.load(std::memory_order_acquire));
+    }
+
+    //! @brief Whether the queue is empty.
+    inline bool empty() const {
+        return m_head.load(std::memory_order_acquire) == nullptr;
+    }
+
+    //! @brief Inserts a value in the queue.
+    void push(T x) {
+        entry* e = new entry{std::move(x), m_head.load(std::memory_order_relaxed)};
+        while (not m_head.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    //! @brief Moves all the values in the queue (in order of insertion) at the end of a vector.
+    void pop(std::vector<T>& v) {
+        entry* e = m_head.exchange(nullptr, std::memory_order_acquire);
+        size_t n = v.size();
+        for (entry* x = e; x != nullptr; x = x->next) v.push_back(std::move(x->value));
+        std::reverse(v.begin() + n, v.end());
+        clear(e);
+    }
+
+  private:
+    //! @brief A value in the queue, linked to the one inserted before it.
+    struct entry {
+        T value;
+        entry* next;
+    };
+
+    //! @brief Deletes a list of entries.
+    static void clear(entry* e) {
+        while (e != nullptr) {
+            entry* x = e->next;
+            delete e;
+            e = x;
+        }
+    }
+
+    //! @brief The last value inserted.
+    std::atomic<entry*> m_head;
+};
+#endif
+
+
 }
 
 
@@ -129,13 +129,16 @@ template <size_t n, typename... Ts>
 auto const& get(tuple<Ts...> const&) noexcept;
 
 namespace details {
+    class domain;
     template <typename T>
-    std::vector<device_t> const& get_ids(field<T> const&);
+    domain const& get_ids(field<T> const&);
     template <typename T>
     std::vector<T> const& get_vals(field<T> const&);
 }
 
 namespace common {
+    template <typename T, typename... Ts>
+    class flat_multitype_map;
     template <typename T, typename... Ts>
     class multitype_map;
     template <typename K, typename T, typename H, typename P, typename A>
@@ -145,7 +148,7 @@ namespace common {
 }
 
 namespace internal {
-    template <bool online, bool pointer, typename M, typename... Ts>
+    template <bool online, bool pointer, bool flat, bool indexed, typename M, typename... Ts>
     class context;
     template <typename T, bool is_flat>
     class flat_ptr;
@@ -481,6 +484,18 @@ namespace fcpp {
             return fcpp::details::printable_stringify("()", m);
         }
 
+        //! @brief Printing flat multitype maps in arrowhead format.
+        template <typename O, typename T, typename... Ts, typename = if_ostream<O>>
+        O& operator<<(O& o, flat_multitype_map<T, Ts...> const& m) {
+            return fcpp::details::printable_print(o, "()", m);
+        }
+
+        //! @brief Converting flat multitype maps to strings.
+        template <typename T, typename... Ts, typename = fcpp::details::if_stringable<T, Ts...>>
+        std::string to_string(flat_multitype_map<T, Ts...> const& m) {
+            return fcpp::details::printable_stringify("()", m);
+        }
+
         //! @brief Printing random access maps.
         template <typename O, typename K, typename T, typename H, typename P, typename A, typename = if_ostream<O>>
         O& operator<<(O& o, random_access_map<K,T,H,P,A> const& m) {
@@ -509,14 +524,14 @@ namespace fcpp {
     //! @brief Namespace containing objects of internal use.
     namespace internal {
         //! @brief Printing calculus contexts.
-        template <typename O, bool b, bool d, typename... Ts, typename = common::if_ostream<O>>
-        O& operator<<(O& o, context<b, d, Ts...> const& c) {
+        template <typename O, bool b, bool d, bool f, bool i, typename... Ts, typename = common::if_ostream<O>>
+        O& operator<<(O& o, context<b, d, f, i, Ts...> const& c) {
             return fcpp::details::printable_print(o, "()", c);
         }
 
         //! @brief Converting calculus contexts to strings.
-        template <bool b, bool d, typename... Ts>
-    std::string to_string(context<b, d, Ts...> const& c) {
+        template <bool b, bool d, bool f, bool i, typename... Ts>
+    std::string to_string(context<b, d, f, i, Ts...> const& c) {
             return fcpp::details::printable_stringify("()", c);
         }
 
@@ -478,9 +478,7 @@ class rows {
     //! @brief Prints the object's contents.
     template <typename O>
     void print(O& o) {
-        using std::swap;
-        common::isstream rows({});
-        swap(rows.data(), m_rows.data());
+        common::isstream rows(m_rows.data().data(), m_rows.size());
         std::string tstr = std::string(ctime(&m_start));
         tstr.pop_back();
         o << "########################################################\n";
@@ -508,7 +506,6 @@ class rows {
         o << "########################################################\n";
         o << "# FCPP execution finished at: " << tstr << " #\n";
         o << "########################################################" << std::endl;
-        swap(rows.data(), m_rows.data());
     }
 
   private:
@@ -8,16 +8,21 @@
 #ifndef FCPP_COMMON_SERIALIZE_H_
 #define FCPP_COMMON_SERIALIZE_H_
 
+#include <array>
 #include <cstring>
+#include <limits>
 #include <map>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <type_traits>
+#include <utility>
 
+#include "lib/common/type_sequence.hpp"
 #include "lib/internal/trace.hpp"
 
 
@@ -38,6 +43,15 @@ class format_error : public std::runtime_error {
 };
 
 
+//! @brief Wire encodings supported by serialisation streams.
+enum class encoding : char {
+    //! @brief Trivial values are copied at full width.
+    plain,
+    //! @brief Integers are written as LEB128 variable-length integers, zigzag-encoded if signed (keys of multitype maps, as trace hashes, stay at full width).
+    compact
+};
+
+
 //! @cond INTERNAL
 namespace details {
     //! @brief Proxy function copying memory without unwanted warnings.
@@ -53,46 +67,80 @@ template <bool io>
 class sstream;
 
 
-//! @brief Stream-like object for input serialization.
+/**
+ * @brief Stream-like object for input serialization.
+ *
+ * Reads from a buffer which can be either owned by the stream (when constructed from a vector),
+ * or borrowed from the caller (when constructed from a pointer and a size), in which case
+ * the buffer is not copied and needs to outlive the stream.
+ */
 //! @{
 template <>
 class sstream<false> {
   public:
-    //! @brief Constructor from raw data.
-    sstream(std::vector<char> data) : m_data(data), m_idx(0) {}
+    //! @brief Constructor from raw data (owned by the stream).
+    sstream(std::vector<char> data, encoding e = encoding::plain) : m_data(std::move(data)), m_begin(m_data.data()), m_end(m_begin + m_data.size()), m_encoding(e) {}
+
+    //! @brief Constructor from a borrowed buffer of raw data (not copied).
+    sstream(char const* data, size_t size, encoding e = encoding::plain) : m_begin(data), m_end(data + size), m_encoding(e) {}
+
+    //! @brief Deleted copy constructor.
+    sstream(sstream const&) = delete;
+
+    //! @brief Move constructor.
+    sstream(sstream&& s) : m_data(std::move(s.m_data)), m_begin(s.m_begin), m_end(s.m_end), m_encoding(s.m_encoding) {
+        s.m_begin = s.m_end = nullptr;
+    }
+
+    //! @brief Deleted copy assignment.
+    sstream& operator=(sstream const&) = delete;
+
+    //! @brief Move assignment.
+    sstream& operator=(sstream&& s) {
+        m_data = std::move(s.m_data);
+        m_begin = s.m_begin;
+        m_end = s.m_end;
+        m_encoding = s.m_encoding;
+        s.m_begin = s.m_end = nullptr;
+        return *this;
+    }
+
+    //! @brief Whether the stream uses the compact encoding.
+    bool compact() const {
+        return m_encoding == encoding::compact;
+    }
 
     //! @brief Reads a trivial type from the stream.
     template <typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
     sstream& read(T& x, size_t l = sizeof(T)) {
 #ifndef FCPP_DISABLE_EXCEPTIONS
-        if (m_idx + l > m_data.size())
+        if (l > size())
             throw format_error("format error in deserialisation");
 #endif
-        details::copy(&x, m_data.data() + m_idx, l);
-        m_idx += l;
+        details::copy(&x, m_begin, l);
+        m_begin += l;
         return *this;
     }
 
     //! @brief The size of the raw data yet to be read.
     size_t size() const {
-        return m_data.size() - m_idx;
-    }
-
-    //! @brief Access to the raw data.
-    std::vector<char>& data() {
-        return m_data;
+        return m_end - m_begin;
     }
 
-    //! @brief Const access to the raw data.
-    std::vector<char> const& data() const {
-        return m_data;
+    //! @brief Access to the raw data yet to be read.
+    char const* data() const {
+        return m_begin;
     }
 
   private:
-    //! @brief The raw data.
+    //! @brief The raw data (if owned).
     std::vector<char> m_data;
-    //! @brief The read index.
-    size_t m_idx;
+    //! @brief Pointer to the first byte yet to be read.
+    char const* m_begin;
+    //! @brief Pointer past the end of the raw data.
+    char const* m_end;
+    //! @brief The wire encoding.
+    encoding m_encoding;
 };
 //! @brief Stream-like object for input serialization (alias).
 using isstream = sstream<false>;
@@ -104,8 +152,13 @@ using isstream = sstream<false>;
 template <>
 class sstream<true> {
   public:
-    //! @brief Default constructor.
-    sstream() = default;
+    //! @brief Constructor with a given wire encoding.
+    sstream(encoding e = encoding::plain) : m_encoding(e) {}
+
+    //! @brief Whether the stream uses the compact encoding.
+    bool compact() const {
+        return m_encoding == encoding::compact;
+    }
 
     //! @brief Conversion to raw data.
     operator std::vector<char>() {
@@ -125,6 +178,16 @@ class sstream<true> {
         return m_data.size();
     }
 
+    //! @brief Reserves space for writing `l` further bytes without reallocations.
+    void reserve(size_t l) {
+        m_data.reserve(m_data.size() + l);
+    }
+
+    //! @brief Discards the raw data written so far, keeping the allocated space for reuse.
+    void clear() {
+        m_data.clear();
+    }
+
     //! @brief Access to the raw data.
     std::vector<char>& data() {
         return m_data;
@@ -138,12 +201,56 @@ class sstream<true> {
   private:
     //! @brief The raw data.
     std::vector<char> m_data;
+    //! @brief The wire encoding.
+    encoding m_encoding;
 };
 //! @brief Stream-like object for output serialization (alias).
 using osstream = sstream<true>;
 //! @}
 
 
+/**
+ * @brief Stream-like object for counting the size of serialised data.
+ *
+ * Behaves as an output stream, but only accumulates the number of bytes written,
+ * so that the serialised size of an object can be measured without allocations.
+ */
+class cstream {
+  public:
+    //! @brief Constructor with a given wire encoding.
+    cstream(encoding e = encoding::plain) : m_encoding(e) {}
+
+    //! @brief Whether the stream uses the compact encoding.
+    bool compact() const {
+        return m_encoding == encoding::compact;
+    }
+
+    //! @brief Writes a trivial type to the stream.
+    template <typename T, typename = std::enable_if_t<std::is_trivially_copyable<T>::value>>
+    cstream& write(T const&, size_t l = sizeof(T)) {
+        m_size += l;
+        return *this;
+    }
+
+    //! @brief Writes `l` bytes of unspecified content to the stream.
+    cstream& skip(size_t l) {
+        m_size += l;
+        return *this;
+    }
+
+    //! @brief The size of the raw data written so far.
+    size_t size() const {
+        return m_size;
+    }
+
+  private:
+    //! @brief The number of bytes written.
+    size_t m_size = 0;
+    //! @brief The wire encoding.
+    encoding m_encoding;
+};
+
+
 /**
  * @brief Stream-like object for hashing data into an integer type `I`.
  *
@@ -272,6 +379,26 @@ struct is_stream<sstream<io>> : public std::true_type {};
 template <>
 struct is_stream<hstream> : public std::true_type {};
 
+//! @brief Checks whether a type is a FCPP stream (counting stream overload).
+template <>
+struct is_stream<cstream> : public std::true_type {};
+
+
+/**
+ * @brief Compile-time size of the serialisation of a type.
+ *
+ * If `fixed` is true, every value of type `T` serialises to exactly `value` bytes in plain encoding.
+ * Otherwise, the size depends on the value serialised and `value` is zero.
+ * Can be specialised for user classes with a value-independent serialisation.
+ */
+template <typename T, typename = void>
+struct serialized_size;
+
+//! @cond INTERNAL
+template <typename S, typename T>
+struct tagged_tuple;
+//! @endcond
+
 
 //! @cond INTERNAL
 namespace details {
@@ -303,6 +430,10 @@ template <typename T>
 std::enable_if_t<details::has_serialize_trivial<T>::value, hstream&>
 inline operator&(hstream& hs, T& x);
 
+template <typename T>
+std::enable_if_t<details::has_serialize_trivial<T>::value, cstream&>
+inline operator&(cstream& cs, T& x);
+
 namespace details {
     //! @brief Serialization of indexed classes.
     //! @{
@@ -348,19 +479,26 @@ namespace details {
     }
     //! @}
 
-    //! @brief Variable-length serialization of container sizes.
+    //! @brief Variable-length serialization of container sizes (and unsigned integers).
     //! @{
-    inline void size_variable_read(isstream& s, size_t& v) {
+    template <typename I>
+    inline void size_variable_read(isstream& s, I& v) {
+        constexpr int bits = std::numeric_limits<I>::digits;
         v = 0;
         uint8_t x;
-        for (int offs = 0; ; offs += 7) {
+        // at most ceil(bits/7) groups, the last of which must fit in the remaining bits
+        for (int offs = 0; offs < bits; offs += 7) {
             s.read(x);
-            v += (x & 127ULL) << offs;
+#ifndef FCPP_DISABLE_EXCEPTIONS
+            if (bits - offs <= 7 and (x >> (bits - offs)) != 0)
+                throw format_error("format error in deserialisation");
+#endif
+            v |= I(x & 127ULL) << offs;
             if (x < 128) break;
         }
     }
-    template <typename S>
-    inline void size_variable_write(S& s, size_t v) {
+    template <typename S, typename I>
+    inline void size_variable_write(S& s, I v) {
         do {
             uint8_t x = (v & 127) + 128 * (v >= 128);
             s.write(x);
@@ -369,6 +507,58 @@ namespace details {
     }
     //! @}
 
+    //! @brief Whether a type is written as a variable-length integer in compact encoding (only small values shrink).
+    template <typename T>
+    struct is_varint : public std::integral_constant<bool, std::is_integral<T>::value and (sizeof(T) > 1)> {};
+
+    //! @brief Zigzag encoding of integers, mapping small negative numbers to small unsigned numbers.
+    //! @{
+    template <typename T>
+    inline std::make_unsigned_t<T> zigzag(T x, std::false_type) {
+        return x;
+    }
+    template <typename T>
+    inline std::make_unsigned_t<T> zigzag(T x, std::true_type) {
+        using U = std::make_unsigned_t<T>;
+        return (U(x) << 1) ^ (x < 0 ? U(-1) : U(0));
+    }
+    template <typename T>
+    inline T unzigzag(std::make_unsigned_t<T> x, std::false_type) {
+        return x;
+    }
+    template <typename T>
+    inline T unzigzag(std::make_unsigned_t<T> x, std::true_type) {
+        using U = std::make_unsigned_t<T>;
+        return T((x >> 1) ^ (U(0) - (x & 1)));
+    }
+    //! @}
+
+    //! @brief Serialization of trivial types, according to the stream encoding.
+    //! @{
+    template <typename T>
+    inline isstream& trivial_serialize(isstream& s, T& x, std::false_type) {
+        return s.read(x);
+    }
+    template <typename T>
+    inline isstream& trivial_serialize(isstream& s, T& x, std::true_type) {
+        if (not s.compact()) return s.read(x);
+        std::make_unsigned_t<T> v;
+        size_variable_read(s, v);
+        x = unzigzag<T>(v, std::is_signed<T>{});
+        return s;
+    }
+    template <typename S, typename T>
+    inline S& trivial_serialize(S& s, T const& x, std::false_type) {
+        return s.write(x);
+    }
+    template <typename S, typename T>
+    inline S& trivial_serialize(S& s, T const& x, std::true_type) {
+        if (not s.compact()) return s.write(x);
+        size_variable_write(s, zigzag(x, std::is_signed<T>{}));
+        return s;
+    }
+    //! @}
+
     //! @brief Inert wrapper of a type.
     template <typename S>
     struct wrapper {};
@@ -402,6 +592,14 @@ namespace details {
         return s;
     }
 
+    template <typename T, typename S, typename U = wrapper<void>>
+    cstream& iterable_serialize(cstream& s, T& x, wrapper<S>, U = {}) {
+        size_variable_write(s, x.size());
+        if (serialized_size<S>::fixed and not s.compact()) return s.skip(x.size() * serialized_size<S>::value);
+        for (auto& i : x) s & i;
+        return s;
+    }
+
     template <typename S>
     S& serialize(S& s, std::string& x) {
         return iterable_serialize(s, x, wrapper<char>{});
@@ -535,10 +733,73 @@ namespace details {
     struct has_serialize_trivial {
         static constexpr bool value = std::is_trivially_copyable<C>::value and not has_serialize_method<C>::value and not has_serialize_function<C>::value;
     };
+
+    //! @brief Compile-time serialised size of a sequence of types.
+    template <typename... Ts>
+    struct serialized_size_sum;
+
+    template <>
+    struct serialized_size_sum<> {
+        static constexpr bool fixed = true;
+        static constexpr size_t value = 0;
+    };
+
+    template <typename T, typename... Ts>
+    struct serialized_size_sum<T, Ts...> {
+        static constexpr bool fixed = serialized_size<std::remove_const_t<T>>::fixed and serialized_size_sum<Ts...>::fixed;
+        static constexpr size_t value = fixed ? serialized_size<std::remove_const_t<T>>::value + serialized_size_sum<Ts...>::value : 0;
+    };
+
+    //! @brief Counts the serialised size of a value (fixed size overload).
+    template <typename T>
+    inline cstream& count_serialize(cstream& cs, T const& x, std::true_type) {
+        if (cs.compact()) return cs & ((T&)x);
+        return cs.skip(serialized_size<T>::value);
+    }
+
+    //! @brief Counts the serialised size of a value (variable size overload).
+    template <typename T>
+    inline cstream& count_serialize(cstream& cs, T const& x, std::false_type) {
+        return cs & ((T&)x);
+    }
 }
 //! @endcond
 
 
+//! @brief Compile-time size of the serialisation of a type (variable size overload).
+template <typename T, typename>
+struct serialized_size {
+    static constexpr bool fixed = false;
+    static constexpr size_t value = 0;
+};
+
+//! @brief Compile-time size of the serialisation of a type (trivial types overload).
+template <typename T>
+struct serialized_size<T, std::enable_if_t<details::has_serialize_trivial<T>::value>> {
+    static constexpr bool fixed = true;
+    static constexpr size_t value = sizeof(T);
+};
+
+//! @brief Compile-time size of the serialisation of a type (tuple overload).
+template <typename... Ts>
+struct serialized_size<std::tuple<Ts...>> : public details::serialized_size_sum<Ts...> {};
+
+//! @brief Compile-time size of the serialisation of a type (pair overload).
+template <typename T, typename U>
+struct serialized_size<std::pair<T, U>> : public details::serialized_size_sum<T, U> {};
+
+//! @brief Compile-time size of the serialisation of a type (array overload).
+template <typename T, size_t n>
+struct serialized_size<std::array<T, n>> {
+    static constexpr bool fixed = serialized_size<T>::fixed;
+    static constexpr size_t value = serialized_size<T>::value * n;
+};
+
+//! @brief Compile-time size of the serialisation of a type (tagged tuple overload).
+template <typename... Ss, typename... Ts>
+struct serialized_size<tagged_tuple<type_sequence<Ss...>, type_sequence<Ts...>>> : public details::serialized_size_sum<Ts...> {};
+
+
 //! @brief Serialisation from/to user classes.
 template <typename S, typename T>
 std::enable_if_t<details::has_serialize_method<T>::value and is_stream<S>::value, S&>
@@ -557,14 +818,14 @@ inline operator&(S& is, T& x) {
 template <typename T>
 std::enable_if_t<details::has_serialize_trivial<T>::value, isstream&>
 inline operator&(isstream& is, T& x) {
-    return is.read(x);
+    return details::trivial_serialize(is, x, details::is_varint<T>{});
 }
 
 //! @brief Serialisation to trivial types.
 template <typename T>
 std::enable_if_t<details::has_serialize_trivial<T>::value, osstream&>
 inline operator&(osstream& os, T& x) {
-    return os.write(x);
+    return details::trivial_serialize(os, x, details::is_varint<T>{});
 }
 
 //! @brief Hashing trivial types.
@@ -574,6 +835,13 @@ inline operator&(hstream& hs, T& x) {
     return hs.write(x);
 }
 
+//! @brief Counting trivial types.
+template <typename T>
+std::enable_if_t<details::has_serialize_trivial<T>::value, cstream&>
+inline operator&(cstream& cs, T& x) {
+    return details::trivial_serialize(cs, x, details::is_varint<T>{});
+}
+
 
 //! @brief Serialisation from an input stream.
 template <typename T>
@@ -596,6 +864,36 @@ inline hstream& operator<<(hstream& os, T const& x) {
 }
 
 
+//! @brief Serialisation to a counting stream (skipping values of fixed size).
+template <typename T>
+inline cstream& operator<<(cstream& cs, T const& x) {
+    return details::count_serialize(cs, x, std::integral_constant<bool, serialized_size<T>::fixed>{});
+}
+
+
+//! @brief Serialisation of a key from an input stream, at full width in every encoding (as trace hashes would grow as variable-length integers).
+template <typename T>
+inline isstream& key_serialize(isstream& is, T& k) {
+    return is.read(k);
+}
+
+
+//! @brief Serialisation of a key to an output stream, at full width in every encoding (as trace hashes would grow as variable-length integers).
+template <typename S, typename T>
+inline S& key_serialize(S& os, T const& k) {
+    return os.write(k);
+}
+
+
+//! @brief Size of the serialisation of a value in a given encoding, computed without serialising it.
+template <typename T>
+inline size_t serialized_size_of(T const& x, encoding e = encoding::plain) {
+    cstream cs(e);
+    cs << x;
+    return cs.size();
+}
+
+
 }
 
 
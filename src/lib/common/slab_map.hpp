@@ -0,0 +1,314 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file slab_map.hpp
+ * @brief Implementation of the `slab_map` class template, storing non-movable elements in stable slabs with dense iteration.
+ */
+
+#ifndef FCPP_COMMON_SLAB_MAP_H_
+#define FCPP_COMMON_SLAB_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "lib/common/random_access_map.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+/**
+ * @brief Namespace containing objects of common use.
+ */
+namespace common {
+
+
+/**
+ * @brief Class providing an unordered map interface together with random access iterators, for elements that cannot be moved.
+ *
+ * Elements are constructed in place within fixed-size slabs, so that their addresses are stable,
+ * and erased slots are recycled through a free list. Iteration is performed through a dense vector
+ * of element pointers. Keys are indexed through a direct table as long as they are small integers
+ * (comparable with the number of elements), and through an hash map otherwise.
+ *
+ * @param K Key type.
+ * @param T Mapped type.
+ */
+template <typename K, typename T>
+class slab_map {
+  public:
+    //! @brief The key type.
+    using key_type = K;
+    //! @brief The mapped type.
+    using mapped_type = T;
+    //! @brief The value type.
+    using value_type = std::pair<key_type const, mapped_type>;
+    //! @brief Reference type.
+    using reference = value_type&;
+    //! @brief Const reference type.
+    using const_reference = value_type const&;
+    //! @brief Pointer type.
+    using pointer = value_type*;
+    //! @brief Const pointer type.
+    using const_pointer = value_type const*;
+    //! @brief The type for sizes.
+    using size_type = size_t;
+    //! @brief The type for pointer differences.
+    using difference_type = std::ptrdiff_t;
+
+  private:
+    //! @brief The internal vector type for random access.
+    using vec_t = std::vector<pointer>;
+
+  public:
+    //! @brief The iterator type.
+    using iterator = details::iterator<typename vec_t::iterator, value_type, difference_type, pointer, reference>;
+    //! @brief The const iterator type.
+    using const_iterator = details::iterator<typename vec_t::const_iterator, value_type, difference_type, const_pointer, const_reference>;
+
+    //! @name constructors
+    //! @{
+
+    //! @brief Default constructor.
+    slab_map() = default;
+
+    //! @brief Deleted copy constructor.
+    slab_map(slab_map const&) = delete;
+    //! @}
+
+    //! @brief Deleted copy assignment.
+    slab_map& operator=(slab_map const&) = delete;
+
+    //! @brief Destructor.
+    ~slab_map() {
+        clear();
+    }
+
+    //! @brief Test whether the container is empty.
+    bool empty() const noexcept {
+        return m_dense.empty();
+    }
+
+    //! @brief Returns the number of elements in the container.
+    size_type size() const noexcept {
+        return m_dense.size();
+    }
+
+    //! @brief Returns an iterator pointing to the first element in the container.
+    iterator begin() noexcept {
+        return m_dense.begin();
+    }
+
+    //! @brief Returns an iterator pointing to the first element in the container (const overload).
+    const_iterator begin() const noexcept {
+        return m_dense.cbegin();
+    }
+
+    //! @brief Returns an iterator pointing to the past-the-end element in the container.
+    iterator end() noexcept {
+        return m_dense.end();
+    }
+
+    //! @brief Returns an iterator pointing to the past-the-end element in the container (const overload).
+    const_iterator end() const noexcept {
+        return m_dense.cend();
+    }
+
+    //! @brief Accesses an element of the container throwing if not found.
+    mapped_type& at(key_type const& k) {
+        size_t s = slot(k);
+        if (s == npos) throw std::out_of_range("slab_map::at");
+        return get(s).second;
+    }
+
+    //! @brief Accesses an element of the container throwing if not found (const overload).
+    mapped_type const& at(key_type const& k) const {
+        size_t s = slot(k);
+        if (s == npos) throw std::out_of_range("slab_map::at");
+        return get(s).second;
+    }
+
+    //! @brief Searches the container for an element with a given key, returning end if not found.
+    iterator find(key_type const& k) {
+        size_t s = slot(k);
+        return s == npos ? end() : begin() + m_pos[s];
+    }
+
+    //! @brief Searches the container for an element with a given key, returning end if not found (const overload).
+    const_iterator find(key_type const& k) const {
+        size_t s = slot(k);
+        return s == npos ? end() : begin() + m_pos[s];
+    }
+
+    //! @brief Counts the elements with a specific key.
+    size_type count(key_type const& k) const {
+        return slot(k) == npos ? 0 : 1;
+    }
+
+    //! @brief Constructs and inserts an element (with arguments as for constructing a `value_type`).
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        size_t s;
+        if (m_free.empty()) {
+            s = m_pos.size();
+            if (s % slab_size == 0) m_slabs.emplace_back(new storage_type[slab_size]);
+            m_pos.push_back(size_t(npos));
+        } else {
+            s = m_free.back();
+            m_free.pop_back();
+        }
+        pointer p;
+        try {
+            p = new (&m_slabs[s / slab_size][s % slab_size]) value_type(std::forward<Args>(args)...);
+        } catch (...) {
+            m_free.push_back(s);
+            throw;
+        }
+        size_t o = slot(p->first);
+        if (o != npos) {
+            p->~value_type();
+            m_free.push_back(s);
+            return {begin() + m_pos[o], false};
+        }
+        index(p->first, s);
+        m_pos[s] = m_dense.size();
+        m_dense.push_back(p);
+        return {end() - 1, true};
+    }
+
+    //! @brief Erases elements from the map (key overload).
+    size_type erase(key_type const& k) {
+        size_t s = slot(k);
+        if (s == npos) return 0;
+        pointer p = &get(s);
+        size_t i = m_pos[s];
+        m_dense[i] = m_dense.back();
+        m_pos[slot(m_dense[i]->first)] = i;
+        m_dense.pop_back();
+        m_pos[s] = npos;
+        unindex(k);
+        p->~value_type();
+        m_free.push_back(s);
+        return 1;
+    }
+
+    //! @brief Clear content.
+    void clear() noexcept {
+        for (pointer p : m_dense) p->~value_type();
+        m_dense.clear();
+        m_pos.clear();
+        m_free.clear();
+        m_slabs.clear();
+        m_table.clear();
+        m_sparse.clear();
+    }
+
+  private:
+    //! @brief Number of elements in a slab.
+    constexpr static size_t slab_size = 64;
+
+    //! @brief Placeholder for missing slots.
+    constexpr static size_t npos = size_t(-1);
+
+    //! @brief Uninitialised storage for an element.
+    using storage_type = std::aligned_storage_t<sizeof(value_type), alignof(value_type)>;
+
+    //! @brief The position of a key in the direct table (`npos` if not applicable, non-integral overload).
+    template <typename U>
+    static inline size_t table_index(U const&, std::integral_constant<int,0>) {
+        return npos;
+    }
+
+    //! @brief The position of a key in the direct table (`npos` if not applicable, unsigned overload).
+    template <typename U>
+    static inline size_t table_index(U const& k, std::integral_constant<int,1>) {
+        return size_t(k);
+    }
+
+    //! @brief The position of a key in the direct table (`npos` if not applicable, signed overload).
+    template <typename U>
+    static inline size_t table_index(U const& k, std::integral_constant<int,2>) {
+        return k < 0 ? npos : size_t(k);
+    }
+
+    //! @brief The position of a key in the direct table (`npos` if not applicable).
+    static inline size_t table_index(key_type const& k) {
+        return table_index(k, std::integral_constant<int, std::is_integral<K>::value + std::is_signed<K>::value>{});
+    }
+
+    //! @brief Accesses the element in a slot.
+    value_type& get(size_t s) const {
+        return *reinterpret_cast<pointer>(&m_slabs[s / slab_size][s % slab_size]);
+    }
+
+    //! @brief Whether a key is within the direct table.
+    inline bool in_table(key_type const& k) const {
+        return table_index(k) < m_table.size();
+    }
+
+    //! @brief The slot of a key (`npos` if missing).
+    size_t slot(key_type const& k) const {
+        if (in_table(k)) return m_table[table_index(k)];
+        if (m_sparse.empty()) return npos;
+        auto it = m_sparse.find(k);
+        return it == m_sparse.end() ? npos : it->second;
+    }
+
+    //! @brief Associates a slot to a key.
+    void index(key_type const& k, size_t s) {
+        size_t i = table_index(k);
+        if (i != npos and i >= m_table.size() and i < 4 * m_pos.size() + slab_size) {
+            // grow the direct table, moving the sparse keys it covers
+            m_table.resize(std::max(i + 1, 2 * m_table.size()), size_t(npos));
+            for (auto it = m_sparse.begin(); it != m_sparse.end(); )
+                if (in_table(it->first)) {
+                    m_table[table_index(it->first)] = it->second;
+                    it = m_sparse.erase(it);
+                } else ++it;
+        }
+        if (in_table(k)) m_table[i] = s;
+        else m_sparse[k] = s;
+    }
+
+    //! @brief Removes the slot of a key.
+    void unindex(key_type const& k) {
+        if (in_table(k)) m_table[table_index(k)] = npos;
+        else m_sparse.erase(k);
+    }
+
+    //! @brief The slabs where elements are stored.
+    std::vector<std::unique_ptr<storage_type[]>> m_slabs;
+
+    //! @brief Pointers to the elements, in iteration order.
+    vec_t m_dense;
+
+    //! @brief The position in `m_dense` of the element in every slot (`npos` if free).
+    std::vector<size_t> m_pos;
+
+    //! @brief The free slots.
+    std::vector<size_t> m_free;
+
+    //! @brief The slots of small keys.
+    std::vector<size_t> m_table;
+
+    //! @brief The slots of other keys.
+    std::unordered_map<K, size_t> m_sparse;
+};
+
+
+}
+
+
+}
+
+#endif // FCPP_COMMON_SLAB_MAP_H_
@@ -158,6 +158,11 @@ struct base {
             //! @brief Updates the internal status of node component.
             void update() {}
 
+            //! @brief A key such that nodes likely to interact have close keys, used to schedule them together.
+            size_t locality() const {
+                return 0;
+            }
+
             //! @brief Performs computations at round start with current time `t`.
             void round_start(times_t) {}
 
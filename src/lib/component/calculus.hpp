@@ -16,6 +16,8 @@
 
 #include "lib/common/serialize.hpp"
 #include "lib/internal/context.hpp"
+#include "lib/internal/export_codec.hpp"
+#include "lib/internal/recycler.hpp"
 #include "lib/internal/trace.hpp"
 #include "lib/internal/twin.hpp"
 #include "lib/option/metric.hpp"
@@ -71,6 +73,18 @@ namespace tags {
     template <bool b>
     struct export_split {};
 
+    //! @brief Declaration flag associating to whether exports are stored in flat sorted arrays instead of hash maps (defaults to \ref FCPP_EXPORT_FLAT).
+    template <bool b>
+    struct export_flat {};
+
+    //! @brief Declaration flag associating to whether neighbours' exports are indexed by trace on every round (defaults to \ref FCPP_EXPORT_INDEX).
+    template <bool b>
+    struct export_index {};
+
+    //! @brief Declaration tag associating to the number of rounds between full exports, sending only changes in between (defaults to \ref FCPP_EXPORT_DELTA, where zero always sends full exports). If positive, export types need to be serialisable, since non-arithmetic entries are compared with the previous export by serialising both on every round.
+    template <intmax_t n>
+    struct export_delta {};
+
     //! @brief Declaration flag associating to whether messages are dropped as they arrive (reduces memory footprint, defaults to \ref FCPP_ONLINE_DROP).
     template <bool b>
     struct online_drop {};
@@ -90,10 +104,13 @@ namespace tags {
  * - \ref tags::exports defines a sequence of types to be used in exports (defaults to the empty sequence).
  * - \ref tags::program defines a callable class to be executed during rounds (defaults to \ref calculus::null_program).
  * - \ref tags::retain defines a metric class regulating the discard of exports (defaults to \ref metric::once).
+ * - \ref tags::export_delta defines the number of rounds between full exports, sending only changes in between (defaults to \ref FCPP_EXPORT_DELTA, where zero always sends full exports).
  *
  * <b>Declaration flags:</b>
  * - \ref tags::export_pointer defines whether exports are wrapped in smart pointers (defaults to \ref FCPP_EXPORT_PTR).
  * - \ref tags::export_split defines whether exports for neighbours are split from those for self (defaults to \ref FCPP_EXPORT_NUM `== 2`).
+ * - \ref tags::export_flat defines whether exports are stored in flat sorted arrays instead of hash maps (defaults to \ref FCPP_EXPORT_FLAT). Only flat exports are refilled across rounds without allocating memory.
+ * - \ref tags::export_index defines whether neighbours' exports are indexed by trace on every round (defaults to \ref FCPP_EXPORT_INDEX).
  * - \ref tags::online_drop defines whether messages are dropped as they arrive (reduces memory footprint, defaults to \ref FCPP_ONLINE_DROP).
  *
  * <b>Node initialisation tags:</b>
@@ -150,6 +167,15 @@ struct calculus {
     //! @brief Whether exports for neighbours are split from those for self.
     constexpr static bool export_split = common::option_flag<tags::export_split, FCPP_EXPORT_NUM == 2, Ts...>;
 
+    //! @brief Whether exports are stored in flat sorted arrays.
+    constexpr static bool export_flat = common::option_flag<tags::export_flat, FCPP_EXPORT_FLAT, Ts...>;
+
+    //! @brief Whether neighbours' exports are indexed by trace.
+    constexpr static bool export_index = common::option_flag<tags::export_index, FCPP_EXPORT_INDEX, Ts...>;
+
+    //! @brief Number of rounds between full exports (zero for always sending full exports).
+    constexpr static intmax_t export_delta = common::option_num<tags::export_delta, FCPP_EXPORT_DELTA, Ts...>;
+
     //! @brief Whether messages are dropped as they arrive.
     constexpr static bool online_drop = common::option_flag<tags::online_drop, FCPP_ONLINE_DROP, Ts...>;
 
@@ -183,11 +209,14 @@ struct calculus {
             using metric_type = typename retain_type::result_type;
 
             //! @brief The type of the context of exports from other devices.
-            using context_type = internal::context_t<online_drop, export_pointer, metric_type, exports_type>;
+            using context_type = internal::context_t<online_drop, export_pointer, export_flat, export_index, metric_type, exports_type>;
 
             //! @brief The type of the exports of the current device.
             using export_type = typename context_type::export_type;
 
+            //! @brief The type converting exports into messages and back.
+            using codec_type = internal::export_codec<export_type, export_delta>;
+
             //! @brief Helper type providing access to the context for self-messages.
             template <typename A>
             struct self_context_type {
@@ -229,7 +258,9 @@ struct calculus {
 
                 //! @brief Accesses old stored values given a default.
                 inline to_field<A> nbr(A const& def) {
-                    return n.m_context.second().template nbr<A>(t, def, n.uid);
+                    to_field<A> f = n.m_context.second().template nbr<A>(t, def, n.uid);
+                    n.share_domain(f);
+                    return f;
                 }
 
               private:
@@ -246,9 +277,9 @@ struct calculus {
             //! @brief Helper type providing access to the context for neighbour call points.
             struct void_context_type {
                 //! @brief Accesses the list of devices aligned with the call point.
-                inline std::vector<device_t> align() {
+                inline fcpp::details::domain align() {
                     n.m_export.second()->insert(t);
-                    return n.m_context.second().align(t, n.uid);
+                    return n.share_domain(n.m_context.second().align(t, n.uid));
                 }
 
               private:
@@ -263,7 +294,7 @@ struct calculus {
             };
 
             //! @brief A `tagged_tuple` type used for messages to be exchanged with neighbours.
-            using message_t = typename P::node::message_t::template push_back<calculus_tag, export_type>;
+            using message_t = typename P::node::message_t::template push_back<calculus_tag, typename codec_type::message_type>;
 
             /**
              * @brief Main constructor.
@@ -279,8 +310,10 @@ struct calculus {
                 P::node::round_start(t);
                 assert(stack_trace.empty());
                 m_context.second().freeze(m_hoodsize, P::node::uid);
-                m_export = {};
-                std::vector<device_t> nbr_ids = m_context.second().align(P::node::uid);
+                m_codec.prune(t);
+                m_recycler.reset(m_export.first());
+                if (export_split) m_recycler.reset(m_export.second());
+                fcpp::details::domain nbr_ids = fcpp::details::domain::stamp(m_context.second().align(P::node::uid));
                 std::vector<device_t> nbr_vals;
                 nbr_vals.emplace_back();
                 nbr_vals.insert(nbr_vals.end(), nbr_ids.begin(), nbr_ids.end());
@@ -296,6 +329,8 @@ struct calculus {
             //! @brief Performs computations at round end with current time `t`.
             void round_end(times_t t) {
                 assert(stack_trace.empty());
+                compact_export(common::number_sequence<export_flat>{});
+                m_codec.encode(m_export.second());
                 P::node::round_end(t);
                 m_context.second().unfreeze(P::node::as_final(), m_metric, m_threshold);
             }
@@ -304,7 +339,11 @@ struct calculus {
             template <typename S, typename T>
             void receive(times_t t, device_t d, common::tagged_tuple<S,T> const& m) {
                 P::node::receive(t, d, m);
-                m_context.second().insert(d, common::get<calculus_tag>(m), m_metric.build(P::node::as_final(), t, d, m), m_threshold, m_hoodsize);
+                metric_type mt = m_metric.build(P::node::as_final(), t, d, m);
+                bool accept = m_context.second().accepts(d, mt, m_threshold, m_hoodsize);
+                // decoding also when rejecting, so that following deltas apply
+                if (export_type const* e = m_codec.decode(d, common::get<calculus_tag>(m), t, accept))
+                    if (accept) m_context.second().insert(d, *e, mt, m_threshold, m_hoodsize);
                 if (export_split and d == P::node::uid)
                     m_context.first().insert(d, m_export.first(), m_metric.build(P::node::as_final(), t, d, m), m_threshold, m_hoodsize);
             }
@@ -313,7 +352,7 @@ struct calculus {
             template <typename S, typename T>
             common::tagged_tuple<S,T>& send(times_t t, common::tagged_tuple<S,T>& m) const {
                 P::node::send(t, m);
-                common::get<calculus_tag>(m) = m_export.second();
+                common::get<calculus_tag>(m) = m_codec.message(m_export.second());
                 return m;
             }
 
@@ -358,12 +397,41 @@ struct calculus {
             internal::trace stack_trace;
 
           private: // implementation details
+            //! @brief Builds a domain, sharing the domain of the current round if it has the same identifiers.
+            fcpp::details::domain share_domain(std::vector<device_t>&& ids) const {
+                fcpp::details::domain const& d = fcpp::details::get_ids(m_nbr_uid);
+                if (ids == d.ids()) return d;
+                return std::move(ids);
+            }
+
+            //! @brief Makes a field share the domain of the current round if it has the same identifiers.
+            template <typename A>
+            void share_domain(field<A>& f) const {
+                fcpp::details::domain const& d = fcpp::details::get_ids(m_nbr_uid);
+                if (fcpp::details::get_ids(f) == d) fcpp::details::get_ids(f) = d;
+            }
+
+            //! @brief Sorts pending insertions into the exports (disabled).
+            inline void compact_export(common::number_sequence<false>) {}
+
+            //! @brief Sorts pending insertions into the exports (enabled).
+            inline void compact_export(common::number_sequence<true>) {
+                m_export.first()->compact();
+                m_export.second()->compact();
+            }
+
             //! @brief Map associating devices to their exports (`first` for local device, `second` for others).
             internal::twin<context_type, not export_split> m_context;
 
             //! @brief Exports of the current device (`first` for local device, `second` for others).
             internal::twin<export_type, not export_split> m_export;
 
+            //! @brief Converter of exports into messages and back.
+            codec_type m_codec;
+
+            //! @brief Recycler of the memory of past exports.
+            internal::recycler<typename export_type::value_type, not export_pointer> m_recycler;
+
             //! @brief The callable class representing the main round.
             program_type m_callback;
 
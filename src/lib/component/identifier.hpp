@@ -8,12 +8,15 @@
 #ifndef FCPP_COMPONENT_IDENTIFIER_H_
 #define FCPP_COMPONENT_IDENTIFIER_H_
 
+#include <algorithm>
+#include <cmath>
 #include <map>
 #include <queue>
 #include <type_traits>
+#include <vector>
 
 #include "lib/common/algorithm.hpp"
-#include "lib/common/random_access_map.hpp"
+#include "lib/common/slab_map.hpp"
 #include "lib/component/base.hpp"
 
 
@@ -104,6 +107,135 @@ namespace details {
         //! @brief The actual priority queue.
         std::priority_queue<type, std::vector<type>, std::greater<type>> m_queue;
     };
+
+    /**
+     * @brief Calendar queue of pairs `(times_t, device_t)`, with constant amortised time operations for evenly spread times.
+     *
+     * Times are hashed into a circular array of buckets ("days" of a "year"), whose number and width
+     * are adjusted to the number and spread of the elements as the queue grows and shrinks.
+     * The elements of the current day are kept sorted, while other buckets are unsorted.
+     */
+    class calendar_queue {
+      public:
+        //! @brief Default constructor.
+        calendar_queue() : m_buckets(min_buckets), m_width(1), m_day(0), m_size(0) {}
+
+        //! @brief The smallest time in the queue.
+        inline times_t next() const {
+            return m_today.empty() ? TIME_MAX : m_today.back().first;
+        }
+
+        //! @brief Adds a new pair to the queue.
+        void push(times_t t, device_t uid) {
+            long long d = day(t);
+            if (m_size == 0 or d < m_day) {
+                spill();
+                m_day = d;
+            }
+            if (d == m_day and not m_today.empty())
+                m_today.insert(std::upper_bound(m_today.begin(), m_today.end(), type(t, uid), std::greater<type>()), type(t, uid));
+            else
+                m_buckets[d & (m_buckets.size() - 1)].emplace_back(t, uid);
+            if (++m_size > 2 * m_buckets.size()) resize(2 * m_buckets.size());
+            else advance();
+        }
+
+        //! @brief Pops elements with times up to `t`.
+        std::vector<device_t> pop(times_t t) {
+            std::vector<device_t> v;
+            while (m_size > 0 and next() <= t) {
+                v.push_back(m_today.back().second);
+                m_today.pop_back();
+                --m_size;
+                if (m_today.empty()) advance();
+            }
+            if (m_buckets.size() > min_buckets and 4 * m_size < m_buckets.size()) resize(m_buckets.size() / 2);
+            return v;
+        }
+
+      private:
+        //! @brief The type of queue elements.
+        using type = std::pair<times_t, device_t>;
+
+        //! @brief The minimum number of buckets.
+        constexpr static size_t min_buckets = 2;
+
+        //! @brief The day of a time.
+        inline long long day(times_t t) const {
+            double d = std::floor(t / m_width);
+            return d < 1e18 ? d > -1e18 ? (long long)d : -(long long)1e18 : (long long)1e18;
+        }
+
+        //! @brief Moves the elements of the current day back to their bucket.
+        void spill() {
+            std::vector<type>& b = m_buckets[m_day & (m_buckets.size() - 1)];
+            b.insert(b.end(), m_today.begin(), m_today.end());
+            m_today.clear();
+        }
+
+        //! @brief Moves to the first day with elements (if the current day has none), collecting them.
+        void advance() {
+            if (not m_today.empty() or m_size == 0) return;
+            for (size_t i = 0; m_today.empty(); ++i, ++m_day) {
+                if (i == m_buckets.size()) {
+                    // a whole year without elements: jump to the smallest one
+                    times_t t = TIME_MAX;
+                    for (auto const& b : m_buckets) for (type const& x : b) t = std::min(t, x.first);
+                    m_day = day(t);
+                }
+                std::vector<type>& b = m_buckets[m_day & (m_buckets.size() - 1)];
+                auto it = std::partition(b.begin(), b.end(), [this] (type const& x) {
+                    return day(x.first) != m_day;
+                });
+                m_today.assign(it, b.end());
+                b.erase(it, b.end());
+                if (not m_today.empty()) break;
+            }
+            std::sort(m_today.begin(), m_today.end(), std::greater<type>());
+        }
+
+        //! @brief Changes the number of buckets, adapting their width to the spread of the elements.
+        void resize(size_t n) {
+            std::vector<type> v = std::move(m_today);
+            m_today.clear();
+            for (auto& b : m_buckets) {
+                v.insert(v.end(), b.begin(), b.end());
+                b.clear();
+            }
+            m_buckets.resize(n);
+            if (v.size() > 1) {
+                // three times the average separation within the central 80% of times
+                size_t lo = v.size() / 10, hi = v.size() - 1 - lo;
+                std::nth_element(v.begin(), v.begin() + lo, v.end());
+                times_t tlo = v[lo].first;
+                std::nth_element(v.begin() + lo, v.begin() + hi, v.end());
+                times_t thi = v[hi].first;
+                if (thi > tlo and thi < TIME_MAX) m_width = 3 * (thi - tlo) / (hi - lo);
+            }
+            times_t t = TIME_MAX;
+            for (type const& x : v) {
+                t = std::min(t, x.first);
+                m_buckets[day(x.first) & (n - 1)].push_back(x);
+            }
+            m_day = day(t);
+            advance();
+        }
+
+        //! @brief The buckets in the calendar (a power of two).
+        std::vector<std::vector<type>> m_buckets;
+
+        //! @brief The elements of the current day, sorted by decreasing time.
+        std::vector<type> m_today;
+
+        //! @brief The time width of a bucket.
+        times_t m_width;
+
+        //! @brief The current day.
+        long long m_day;
+
+        //! @brief The number of elements in the queue.
+        size_t m_size;
+    };
 }
 //! @endcond
 
@@ -118,12 +250,19 @@ namespace tags {
     template <bool b>
     struct synchronised {};
 
+    //! @brief Declaration flag associating to whether node events should be ordered through a calendar queue (defaults to false).
+    template <bool b>
+    struct calendar {};
+
     //! @brief Node initialisation tag associating to a `device_t` unique identifier (required).
     struct uid;
 
     //! @brief Initialisation tag associating to the time sensitivity, allowing indeterminacy below it (defaults to \ref FCPP_TIME_EPSILON).
     struct epsilon {};
 
+    //! @brief Net initialisation tag associating to a lower bound on the delay between a round and the sending of its messages, used as lookahead for processing node events in parallel (defaults to zero, a positive value requires a \ref simulated_connector with `deterministic<true>` and delays not below it).
+    struct lookahead {};
+
     //! @brief Net initialisation tag associating to the number of threads that can be created (defaults to \ref FCPP_THREADS).
     struct threads {};
 }
@@ -137,12 +276,19 @@ namespace tags {
  * <b>Declaration flags:</b>
  * - \ref tags::parallel defines whether parallelism is enabled (defaults to \ref FCPP_PARALLEL).
  * - \ref tags::synchronised defines whether many events are expected to happen at the same time (defaults to \ref FCPP_SYNCHRONISED).
+ * - \ref tags::calendar defines whether node events should be ordered through a calendar queue (defaults to false), with constant amortised time operations for large networks with evenly spread events (overriding \ref tags::synchronised).
  *
  * <b>Net initialisation tags:</b>
  * - \ref tags::epsilon associates to the time sensitivity, allowing indeterminacy below it (defaults to \ref FCPP_TIME_EPSILON).
+ * - \ref tags::lookahead associates to a lower bound on the delay between a round and the sending of its messages, used as lookahead for processing node events in parallel (defaults to zero).
  * - \ref tags::threads associates to the number of threads that can be created (defaults to \ref FCPP_THREADS).
  *
  * Whenever \ref tags::parallel is false, \ref tags::threads is ignored and \ref tags::epsilon has only a minor effect (it is recommended to set it to zero).
+ *
+ * If \ref tags::lookahead is positive, it replaces \ref tags::epsilon as the width of the time window of node events processed in parallel by each update,
+ * and every node processes all of its events within the window in time order. It requires a deterministic \ref simulated_connector
+ * sending messages with delays not below the lookahead (checked by assertions): then the parallel simulation is conservative,
+ * with the same outcome as a sequential one.
  */
 template <class... Ts>
 struct identifier {
@@ -152,6 +298,9 @@ struct identifier {
     //! @brief Whether new values are pushed to aggregators or pulled when needed.
     constexpr static bool synchronised = common::option_flag<tags::synchronised, FCPP_SYNCHRONISED, Ts...>;
 
+    //! @brief Whether node events are ordered through a calendar queue.
+    constexpr static bool calendar = common::option_flag<tags::calendar, false, Ts...>;
+
     /**
      * @brief The actual component.
      *
@@ -178,14 +327,14 @@ struct identifier {
             using node_type = typename F::node;
 
             //! @brief The map type used internally for storing nodes.
-            using map_type = common::random_access_map<device_t, node_type>;
+            using map_type = common::slab_map<device_t, node_type>;
 
             //! @brief The type of node locks.
             using lock_type = common::unique_lock<parallel>;
 
             //! @brief Constructor from a tagged tuple.
             template <typename S, typename T>
-            explicit net(common::tagged_tuple<S,T> const& t) : P::net(t), m_next_uid(0), m_epsilon(common::get_or<tags::epsilon>(t, FCPP_TIME_EPSILON)), m_threads(common::get_or<tags::threads>(t, FCPP_THREADS)) {}
+            explicit net(common::tagged_tuple<S,T> const& t) : P::net(t), m_next_uid(0), m_epsilon(common::get_or<tags::epsilon>(t, FCPP_TIME_EPSILON)), m_lookahead(common::get_or<tags::lookahead>(t, 0)), m_threads(common::get_or<tags::threads>(t, FCPP_THREADS)) {}
 
             /**
              * @brief Returns next event to schedule for the net component.
@@ -193,18 +342,25 @@ struct identifier {
              * Should correspond to the next time also during updates.
              */
             times_t next() const {
-                return std::min(m_queue.next(), P::net::next());
+                return std::min(node_next(), P::net::next());
             }
 
             //! @brief Updates the internal status of net component.
             void update() {
-                if (m_queue.next() < P::net::next()) {
-                    std::vector<device_t> nv = m_queue.pop(m_queue.next() + m_epsilon);
-                    common::parallel_for(common::tags::general_execution<parallel>(m_threads), nv.size(), [&nv,this](size_t i, size_t){
+                if (node_next() < P::net::next()) {
+                    std::vector<device_t> nv;
+                    times_t end = lookahead_end();
+                    if (m_lookahead > 0) {
+                        pop_window();
+                        nv.swap(m_window);
+                    } else nv = m_queue.pop(m_queue.next() + m_epsilon);
+                    if (parallel and m_threads > 1 and nv.size() > 1) sort_by_locality(nv);
+                    common::parallel_for(common::tags::general_stealing_execution<parallel>(m_threads), nv.size(), [&nv,end,this](size_t i, size_t){
                         if (m_nodes.count(nv[i]) > 0) {
                             node_type& n = m_nodes.at(nv[i]);
                             common::lock_guard<parallel> device_lock(n.mutex);
-                            n.update();
+                            if (m_lookahead > 0) while (n.next() < end) n.update();
+                            else n.update();
                         }
                     });
                     for (device_t uid : nv) if (m_nodes.count(uid) > 0) {
@@ -215,6 +371,28 @@ struct identifier {
                 } else P::net::update();
             }
 
+            //! @brief Returns the time of the next node update.
+            inline times_t node_next() const {
+                return m_window.empty() ? m_queue.next() : m_window_next;
+            }
+
+            //! @brief Returns the lookahead for processing node events in parallel.
+            inline times_t lookahead() const {
+                return m_lookahead;
+            }
+
+            //! @brief Returns the time before which node events are processed by the next node update (equal to `node_next()` if there is no lookahead).
+            inline times_t lookahead_end() const {
+                if (not m_window.empty()) return m_window_end;
+                return std::max(m_queue.next(), std::min(m_queue.next() + m_lookahead, P::net::next()));
+            }
+
+            //! @brief Identifiers of the nodes with events before `lookahead_end()`, to be processed by the next node update.
+            std::vector<device_t> const& node_window() {
+                pop_window();
+                return m_window;
+            }
+
             //! @brief Returns the total number of nodes.
             inline size_t node_size() const {
                 return m_nodes.size();
@@ -278,6 +456,27 @@ struct identifier {
             }
 
           private: // implementation details
+            //! @brief Pops the nodes with events before `lookahead_end()` from the queue into the window (if not already there).
+            void pop_window() {
+                if (not m_window.empty()) return;
+                times_t next = m_queue.next();
+                times_t end = lookahead_end();
+                while (m_queue.next() < end) {
+                    std::vector<device_t> v = m_queue.pop(m_queue.next());
+                    m_window.insert(m_window.end(), v.begin(), v.end());
+                }
+                m_window_next = next;
+                m_window_end = end;
+            }
+
+            //! @brief Sorts a batch of node identifiers so that nodes likely to interact are close.
+            void sort_by_locality(std::vector<device_t>& nv) {
+                m_keys.clear();
+                for (device_t uid : nv) m_keys.emplace_back(m_nodes.count(uid) > 0 ? m_nodes.at(uid).locality() : 0, uid);
+                std::sort(m_keys.begin(), m_keys.end());
+                for (size_t i = 0; i < nv.size(); ++i) nv[i] = m_keys[i].second;
+            }
+
             //! @brief Returns the next device UID to be created (without request).
             template <typename T>
             inline auto push_uid(T const& t, common::type_sequence<>) {
@@ -299,14 +498,26 @@ struct identifier {
             map_type m_nodes;
 
             //! @brief The queue of identifiers by next event.
-            details::times_queue<synchronised> m_queue;
+            std::conditional_t<calendar, details::calendar_queue, details::times_queue<synchronised>> m_queue;
+
+            //! @brief Identifiers popped from the queue for the next lookahead window.
+            std::vector<device_t> m_window;
+
+            //! @brief The first event time and the end of the lookahead window (if not empty).
+            times_t m_window_next, m_window_end;
 
             //! @brief The next free identifier.
             device_t m_next_uid;
 
+            //! @brief Locality keys of the nodes in a batch (reused across updates).
+            std::vector<std::pair<size_t, device_t>> m_keys;
+
             //! @brief The time sensitivity.
             times_t const m_epsilon;
 
+            //! @brief The lookahead for processing node events in parallel.
+            times_t const m_lookahead;
+
             //! @brief The number of threads to be used.
             size_t const m_threads;
         };
@@ -103,7 +103,7 @@ struct timer {
             void update() {
                 m_prev = m_cur;
                 m_cur = next();
-                fcpp::details::self(m_neigh, P::node::uid) = m_prev;
+                m_neigh.insert(P::node::uid, m_prev);
                 if (m_next < TIME_MAX) {
                     // next round was planned
                     m_next = TIME_MAX;
@@ -117,14 +117,14 @@ struct timer {
             //! @brief Performs computations at round start with current time `t`.
             void round_start(times_t t) {
                 P::node::round_start(t);
-                maybe_align_inplace(m_neigh, has_calculus<P>{});
+                maybe_align_inplace(m_neigh.build(), has_calculus<P>{});
             }
 
             //! @brief Receives an incoming message (possibly reading values from sensors).
             template <typename S, typename T>
             void receive(times_t t, device_t d, common::tagged_tuple<S,T> const& m) {
                 P::node::receive(t, d, m);
-                fcpp::details::self(m_neigh, d) = t;
+                m_neigh.insert(d, t);
             }
 
             //! @brief Returns the time of the second most recent round (previous during rounds).
@@ -157,13 +157,23 @@ struct timer {
             }
 
             //! @brief Returns the time stamps of the most recent messages from neighbours.
-            field<times_t> const& message_time() const {
-                return m_neigh;
+            field<times_t> const& message_time() {
+                return m_neigh.build();
+            }
+
+            //! @brief Returns the time stamps of the most recent messages from neighbours (const access, by copy).
+            field<times_t> message_time() const {
+                return m_neigh.merged();
             }
 
             //! @brief Returns the time difference with neighbours.
+            field<times_t> nbr_lag() {
+                return m_cur - m_neigh.build();
+            }
+
+            //! @brief Returns the time difference with neighbours (const access).
             field<times_t> nbr_lag() const {
-                return m_cur - m_neigh;
+                return m_cur - m_neigh.merged();
             }
 
             //! @brief Returns the warping factor applied to following schedulers.
@@ -181,7 +191,7 @@ struct timer {
             //! @brief Changes the domain of a field-like structure to match the domain of the neightbours ids.
             template <typename A>
             void maybe_align_inplace(field<A>& x, std::true_type) {
-                align_inplace(x, std::vector<device_t>(fcpp::details::get_ids(P::node::nbr_uid())));
+                align_inplace(x, fcpp::details::get_ids(P::node::nbr_uid()));
             }
 
             //! @brief Does not perform any alignment
@@ -192,7 +202,7 @@ struct timer {
             times_t m_prev, m_cur, m_next;
 
             //! @brief Times of neighbours.
-            field<times_t> m_neigh;
+            fcpp::details::field_builder<times_t> m_neigh;
 
             //! @brief Offset between the following schedule and actual times.
             times_t m_offs;
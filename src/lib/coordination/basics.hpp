@@ -197,7 +197,7 @@ size_t count_hood(node_t& node, trace_t call_point) {
 template <typename node_t>
 field<device_t> nbr_uid(node_t& node, trace_t call_point) {
     auto ctx = node.void_context(call_point);
-    std::vector<device_t> ids = ctx.align();
+    fcpp::details::domain ids = ctx.align();
     std::vector<device_t> vals;
     vals.emplace_back();
     vals.insert(vals.end(), ids.begin(), ids.end());
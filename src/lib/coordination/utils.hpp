@@ -230,77 +230,59 @@ namespace coordination {
 //! @brief Reduces a field to a single value by logical and.
 template <typename node_t, typename A>
 inline to_local<A> all_hood(node_t& node, trace_t call_point, A const& a) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return x and y;
-    }, a);
+    return fold_hood(node, call_point, fcpp::details::fold_all<to_local<A>>{}, a);
 }
 
 //! @brief Reduces a field to a single value by logical and, with a given value for self.
 template <typename node_t, typename A, typename B>
 inline to_local<A> all_hood(node_t& node, trace_t call_point, A const& a, B const& b) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return x and y;
-    }, a, b);
+    return fold_hood(node, call_point, fcpp::details::fold_all<to_local<A>>{}, a, b);
 }
 
 
 //! @brief Reduces a field to a single value by logical or.
 template <typename node_t, typename A>
 inline to_local<A> any_hood(node_t& node, trace_t call_point, A const& a) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return x or y;
-    }, a);
+    return fold_hood(node, call_point, fcpp::details::fold_any<to_local<A>>{}, a);
 }
 
 //! @brief Reduces a field to a single value by logical or, with a given value for self.
 template <typename node_t, typename A, typename B>
 inline to_local<A> any_hood(node_t& node, trace_t call_point, A const& a, B const& b) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return x or y;
-    }, a, b);
+    return fold_hood(node, call_point, fcpp::details::fold_any<to_local<A>>{}, a, b);
 }
 
 
 //! @brief Reduces a field to a single value by minimum.
 template <typename node_t, typename A>
 inline to_local<A> min_hood(node_t& node, trace_t call_point, A const& a) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return std::min(x, y);
-    }, a);
+    return fold_hood(node, call_point, fcpp::details::fold_min<to_local<A>>{}, a);
 }
 
 //! @brief Reduces a field to a single value by minimum with a given value for self.
 template <typename node_t, typename A, typename B>
 inline to_local<A> min_hood(node_t& node, trace_t call_point, A const& a, B const& b) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return std::min(x, y);
-    }, a, b);
+    return fold_hood(node, call_point, fcpp::details::fold_min<to_local<A>>{}, a, b);
 }
 
 
 //! @brief Reduces a field to a single value by maximum.
 template <typename node_t, typename A>
 inline to_local<A> max_hood(node_t& node, trace_t call_point, A const& a) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return std::max(x, y);
-    }, a);
+    return fold_hood(node, call_point, fcpp::details::fold_max<to_local<A>>{}, a);
 }
 
 //! @brief Reduces a field to a single value by maximum with a given value for self.
 template <typename node_t, typename A, typename B>
 inline to_local<A> max_hood(node_t& node, trace_t call_point, A const& a, B const& b) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return std::max(x, y);
-    }, a, b);
+    return fold_hood(node, call_point, fcpp::details::fold_max<to_local<A>>{}, a, b);
 }
 
 
 //! @brief Reduces a field to a single value by addition.
 template <typename node_t, typename A>
 inline to_local<A> sum_hood(node_t& node, trace_t call_point, A const& a) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return x + y;
-    }, a);
+    return fold_hood(node, call_point, fcpp::details::fold_sum<to_local<A>>{}, a);
 }
 
 //! @brief Reduces a field to a single value by addition with a given value for self.
@@ -315,9 +297,7 @@ inline auto sum_hood(node_t& node, trace_t call_point, A const& a, B const& b) {
 //! @brief Reduces a field to a single value by averaging.
 template <typename node_t, typename A>
 inline to_local<A> mean_hood(node_t& node, trace_t call_point, A const& a) {
-    return fold_hood(node, call_point, [] (to_local<A> const& x, to_local<A> const& y) {
-        return x + y;
-    }, a) / count_hood(node, call_point);
+    return fold_hood(node, call_point, fcpp::details::fold_sum<to_local<A>>{}, a) / count_hood(node, call_point);
 }
 
 //! @brief Reduces a field to a single value by averaging with a given value for self.
@@ -11,6 +11,11 @@
 #include <cassert>
 
 #include <algorithm>
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "lib/settings.hpp"
@@ -56,6 +61,127 @@ using field_result = field<local_result<F, A...>>;
 //! @}
 
 
+//! @cond INTERNAL
+namespace details {
+    /**
+     * @brief Immutable reference-counted sequence of ordered device identifiers, representing the domain of a field.
+     *
+     * Copies share the same identifiers, so that fields with a common domain can be recognised
+     * by pointer equality (see `same`) without comparing identifiers. Domains built through
+     * `stamp` carry a version number unique within the process, while other domains have version zero.
+     * Modifications go through `edit`, which detaches the domain from its copies.
+     */
+    class domain {
+        //! @brief The shared content of a domain.
+        struct data {
+            //! @brief Ordered identifiers.
+            std::vector<device_t> ids;
+            //! @brief Version stamp (zero if unstamped).
+            size_t version;
+        };
+
+      public:
+        //! @brief The type of the identifiers.
+        using value_type = device_t;
+
+        //! @brief Const iterator type.
+        using const_iterator = std::vector<device_t>::const_iterator;
+
+        //! @brief Iterator type (identifiers are immutable).
+        using iterator = const_iterator;
+
+        //! @brief Empty domain.
+        domain() = default;
+
+        //! @brief Domain from a sequence of ordered identifiers (moving).
+        domain(std::vector<device_t>&& ids) : m_data(ids.empty() ? nullptr : std::make_shared<data>(data{std::move(ids), 0})) {}
+
+        //! @brief Domain from a sequence of ordered identifiers (copying).
+        domain(std::vector<device_t> const& ids) : domain(std::vector<device_t>(ids)) {}
+
+        //! @brief Domain from a list of ordered identifiers.
+        domain(std::initializer_list<device_t> ids) : domain(std::vector<device_t>(ids)) {}
+
+        //! @brief Domain with a fresh version stamp.
+        static domain stamp(std::vector<device_t>&& ids) {
+            static std::atomic<size_t> counter{0};
+            domain d;
+            d.m_data = std::make_shared<data>(data{std::move(ids), ++counter});
+            return d;
+        }
+
+        //! @brief Number of identifiers.
+        inline size_t size() const {
+            return m_data ? m_data->ids.size() : 0;
+        }
+
+        //! @brief Whether there are no identifiers.
+        inline bool empty() const {
+            return size() == 0;
+        }
+
+        //! @brief Access to the i-th identifier.
+        inline device_t operator[](size_t i) const {
+            return m_data->ids[i];
+        }
+
+        //! @brief Iterator to the first identifier.
+        inline const_iterator begin() const {
+            return ids().begin();
+        }
+
+        //! @brief Iterator past the last identifier.
+        inline const_iterator end() const {
+            return ids().end();
+        }
+
+        //! @brief Access to the underlying sequence of identifiers.
+        inline std::vector<device_t> const& ids() const {
+            static std::vector<device_t> const none;
+            return m_data ? m_data->ids : none;
+        }
+
+        //! @brief Implicit conversion to the underlying sequence of identifiers.
+        inline operator std::vector<device_t> const&() const {
+            return ids();
+        }
+
+        //! @brief Version stamp of the domain (zero if unstamped).
+        inline size_t version() const {
+            return m_data ? m_data->version : 0;
+        }
+
+        //! @brief Whether the identifiers are shared with another domain (implies equality).
+        inline bool same(domain const& d) const {
+            return m_data == d.m_data;
+        }
+
+        //! @brief Modifiable access to the identifiers, detaching them from other copies (and dropping the stamp).
+        std::vector<device_t>& edit() {
+            if (not m_data) m_data = std::make_shared<data>(data{{}, 0});
+            else if (m_data.use_count() > 1) m_data = std::make_shared<data>(data{m_data->ids, 0});
+            else m_data->version = 0;
+            return m_data->ids;
+        }
+
+        //! @brief Equality operator.
+        friend bool operator==(domain const& x, domain const& y) {
+            return x.same(y) or x.ids() == y.ids();
+        }
+
+        //! @brief Inequality operator.
+        friend bool operator!=(domain const& x, domain const& y) {
+            return not (x == y);
+        }
+
+      private:
+        //! @brief The shared content (null if empty).
+        std::shared_ptr<data> m_data;
+    };
+}
+//! @endcond
+
+
 //! @cond INTERNAL
 //! @brief Forward declarations for enabling friendships.
 namespace details {
@@ -66,14 +192,14 @@ namespace details {
     struct field_base {};
 
     template <typename A>
-    field<A> make_field(std::vector<device_t>&&, std::vector<A>&&);
+    field<A> make_field(domain, std::vector<A>&&);
 
     template <typename A>
-    std::vector<device_t>& get_ids(field<A>&);
+    domain& get_ids(field<A>&);
     template <typename A>
-    std::vector<device_t> get_ids(field<A>&&);
+    domain get_ids(field<A>&&);
     template <typename A>
-    std::vector<device_t> const& get_ids(field<A> const&);
+    domain const& get_ids(field<A> const&);
 
     template <typename A>
     std::vector<A>& get_vals(field<A>&);
@@ -97,20 +223,20 @@ namespace details {
     to_local<A&&> self(A&&, device_t);
 
     template <typename A, typename = if_local<A>>
-    inline A align(A&&, std::vector<device_t> const&);
+    inline A align(A&&, domain const&);
     template <typename A>
-    field<A>& align(field<A>&, std::vector<device_t> const&);
+    field<A>& align(field<A>&, domain const&);
     template <typename A>
-    field<A> align(field<A>&&, std::vector<device_t> const&);
+    field<A> align(field<A>&&, domain const&);
     template <typename A>
-    field<A> align(field<A> const&, std::vector<device_t> const&);
+    field<A> align(field<A> const&, domain const&);
     template <typename A, typename = if_field<A>, typename = common::if_class_template<tuple, A>>
-    decltype(auto) align(A&&, std::vector<device_t> const&);
+    decltype(auto) align(A&&, domain const&);
 
     template <typename A>
-    field<A>& align_inplace(field<A>&, std::vector<device_t>&&);
+    field<A>& align_inplace(field<A>&, domain);
     template <typename... A>
-    tuple<A...>& align_inplace(tuple<A...>&, std::vector<device_t>&&);
+    tuple<A...>& align_inplace(tuple<A...>&, domain);
 }
 //! @endcond
 
@@ -133,14 +259,14 @@ class field : public details::field_base<std::is_same<T, bool>::value> {
     //! @brief Function friendships
     //! @{
     template <typename A>
-    friend field<A> details::make_field(std::vector<device_t>&&, std::vector<A>&&);
+    friend field<A> details::make_field(details::domain, std::vector<A>&&);
 
     template <typename A>
-    friend std::vector<device_t>& details::get_ids(field<A>&);
+    friend details::domain& details::get_ids(field<A>&);
     template <typename A>
-    friend std::vector<device_t> details::get_ids(field<A>&&);
+    friend details::domain details::get_ids(field<A>&&);
     template <typename A>
-    friend std::vector<device_t> const& details::get_ids(field<A> const&);
+    friend details::domain const& details::get_ids(field<A> const&);
 
     template <typename A>
     friend std::vector<A>& details::get_vals(field<A>&);
@@ -188,11 +314,13 @@ class field : public details::field_base<std::is_same<T, bool>::value> {
     //! @brief Implicit conversion copy constructor from field-like structures.
     template <typename A, typename = std::enable_if_t<std::is_convertible<to_local<A>,T>::value and (not common::is_class_template<fcpp::field,A>) and not std::is_convertible<A,T>::value>>
     field(A const& f) {
+        std::vector<device_t> ids;
         m_vals.push_back(details::other(f));
         for (details::field_iterator<A const, void> it(f); not it.end(); ++it) {
-            m_ids.push_back(it.id());
+            ids.push_back(it.id());
             m_vals.push_back(it.value());
         }
+        m_ids = std::move(ids);
     }
     //! @}
 
@@ -234,10 +362,11 @@ class field : public details::field_base<std::is_same<T, bool>::value> {
     common::isstream& serialize(common::isstream& s) {
         device_t size = 0;
         s.read(size);
-        m_ids.resize(size);
+        std::vector<device_t> ids(size);
         m_vals.resize(size+1);
-        for (size_t i = 0; i < m_ids.size(); ++i)
-            s >> m_ids[i];
+        for (size_t i = 0; i < ids.size(); ++i)
+            s >> ids[i];
+        m_ids = std::move(ids);
         serialize_vals(s, std::is_same<T, bool>{});
         return s;
     }
@@ -287,14 +416,14 @@ class field : public details::field_base<std::is_same<T, bool>::value> {
         if (m_vals.size() % 8 != 0) s << c;
     }
 
-    //! @brief Ordered IDs of exceptions.
-    std::vector<device_t> m_ids;
+    //! @brief Ordered IDs of exceptions (possibly shared with other fields).
+    details::domain m_ids;
 
     //! @brief Corresponding values of exceptions (default value in position 0).
     std::vector<T> m_vals;
 
     //! @brief Member constructor, for internal use only.
-    field(std::vector<device_t>&& ids, std::vector<T>&& vals) : m_ids(std::move(ids)), m_vals(std::move(vals)) {}
+    field(details::domain ids, std::vector<T>&& vals) : m_ids(std::move(ids)), m_vals(std::move(vals)) {}
 };
 
 
@@ -312,22 +441,22 @@ namespace details {
 
     //! @brief Builds a field from member values.
     template <typename A>
-    field<A> make_field(std::vector<device_t>&& ids, std::vector<A>&& vals) {
+    field<A> make_field(domain ids, std::vector<A>&& vals) {
         return {std::move(ids), std::move(vals)};
     }
 
     //! @brief Accesses the private field `m_ids` of a field.
     //! @{
     template <typename A>
-    std::vector<device_t>& get_ids(field<A>& f) {
+    domain& get_ids(field<A>& f) {
         return f.m_ids;
     }
     template <typename A>
-    std::vector<device_t> get_ids(field<A>&& f) {
+    domain get_ids(field<A>&& f) {
         return std::move(f.m_ids);
     }
     template <typename A>
-    std::vector<device_t> const& get_ids(field<A> const& f) {
+    domain const& get_ids(field<A> const& f) {
         return f.m_ids;
     }
     //! @}
@@ -393,7 +522,8 @@ namespace details {
 
     template <typename A>
     to_local<field<A>&> maybe_emplace(field<A>& f, device_t i, size_t pos) {
-        get_ids(f).insert(get_ids(f).begin() + pos, i);
+        std::vector<device_t>& ids = get_ids(f).edit();
+        ids.insert(ids.begin() + pos, i);
         get_vals(f).insert(get_vals(f).begin() + pos+1, get_vals(f)[0]);
         return get_vals(f)[pos+1];
     }
@@ -436,38 +566,41 @@ namespace details {
     //! @{
     //! @brief align of locals.
     template <typename A, typename>
-    inline A align(A&& x, std::vector<device_t> const&) {
+    inline A align(A&& x, domain const&) {
         return x;
     }
 
     //! @brief align of fields.
     template <typename A>
-    field<A>& align(field<A>& x, std::vector<device_t> const& s) {
+    field<A>& align(field<A>& x, domain const& s) {
+        if (get_ids(x).same(s)) return x;
         size_t rx = 0, wx = 0, ks = 0;
         while (ks < s.size() and rx < get_ids(x).size()) {
             if      (s[ks] < get_ids(x)[rx]) ++ks;
             else if (s[ks] > get_ids(x)[rx]) ++rx;
             else {
-                if (rx > wx) {
-                    get_ids(x)[wx] = get_ids(x)[rx];
-                    get_vals(x)[wx+1] = std::move(get_vals(x)[rx+1]);
-                }
+                if (rx > wx) get_vals(x)[wx+1] = std::move(get_vals(x)[rx+1]);
                 ++ks, ++rx, ++wx;
             }
         }
-        if (wx < get_ids(x).size()) {
-            get_ids(x).resize(wx);
-            get_vals(x).resize(wx+1);
+        if (wx == s.size()) get_ids(x) = s;
+        else if (wx < get_ids(x).size()) {
+            std::vector<device_t> ids;
+            ids.reserve(wx);
+            std::set_intersection(get_ids(x).begin(), get_ids(x).end(), s.begin(), s.end(), std::back_inserter(ids));
+            get_ids(x) = std::move(ids);
         }
+        if (wx+1 < get_vals(x).size()) get_vals(x).resize(wx+1);
         return x;
     }
     template <typename A>
-    field<A> align(field<A>&& x, std::vector<device_t> const& s) {
+    field<A> align(field<A>&& x, domain const& s) {
         align(x, s);
         return x;
     }
     template <typename A>
-    field<A> align(field<A> const& x, std::vector<device_t> const& s) {
+    field<A> align(field<A> const& x, domain const& s) {
+        if (get_ids(x).same(s)) return x;
         std::vector<device_t> ids;
         std::vector<A> vals;
         ids.reserve(get_ids(x).size());
@@ -483,26 +616,27 @@ namespace details {
                 ++ks, ++rx;
             }
         }
+        if (ids.size() == s.size()) return make_field(s, std::move(vals));
         return make_field(std::move(ids), std::move(vals));
     }
 
     //! @brief align of tuples.
     template <typename... A, size_t... is>
-    tuple<A...>& align(tuple<A...>& x, std::vector<device_t> const& s, std::index_sequence<is...>) {
+    tuple<A...>& align(tuple<A...>& x, domain const& s, std::index_sequence<is...>) {
         common::ignore_args(align(get<is>(x), s)...);
         return x;
     }
     template <typename... A, size_t... is>
-    tuple<A...> align(tuple<A...>&& x, std::vector<device_t> const& s, std::index_sequence<is...>) {
+    tuple<A...> align(tuple<A...>&& x, domain const& s, std::index_sequence<is...>) {
         common::ignore_args(align(get<is>(x), s)...);
         return x;
     }
     template <typename... A, size_t... is>
-    tuple<A...> align(tuple<A...> const& x, std::vector<device_t> const& s, std::index_sequence<is...>) {
+    tuple<A...> align(tuple<A...> const& x, domain const& s, std::index_sequence<is...>) {
         return {align(get<is>(x), s)...};
     }
     template <typename A, typename, typename>
-    decltype(auto) align(A&& x, std::vector<device_t> const& s) {
+    decltype(auto) align(A&& x, domain const& s) {
         return align(std::forward<A>(x), s, std::make_index_sequence<common::template_args<A>::size>{});
     }
     //! @}
@@ -630,7 +764,8 @@ namespace details {
             if (id() == i) {
                 get_vals(m_ref)[m_i+1] = std::move(v);
             } else {
-                get_ids(m_ref).insert(get_ids(m_ref).begin() + m_i, i);
+                std::vector<device_t>& ids = get_ids(m_ref).edit();
+                ids.insert(ids.begin() + m_i, i);
                 get_vals(m_ref).insert(get_vals(m_ref).begin() + m_i+1, std::move(v));
             }
             return *this;
@@ -868,7 +1003,8 @@ namespace details {
     //! @{
     //! @brief Field case.
     template <typename A>
-    field<A>& align_inplace(field<A>& x, std::vector<device_t>&& s) {
+    field<A>& align_inplace(field<A>& x, domain s) {
+        if (get_ids(x).same(s)) return x;
         std::vector<A> vals;
         vals.reserve(s.size()+1);
         vals.push_back(other(x));
@@ -883,21 +1019,21 @@ namespace details {
     }
     //! @brief Indexed structures case.
     template <typename A, size_t i, size_t... is>
-    A& align_inplace(A& x, std::vector<device_t>&& s, std::index_sequence<i, is...>) {
-        common::ignore_args(align_inplace(get<is>(x), std::vector<device_t>{s})...);
+    A& align_inplace(A& x, domain s, std::index_sequence<i, is...>) {
+        common::ignore_args(align_inplace(get<is>(x), s)...);
         align_inplace(get<i>(x), std::move(s));
         return x;
     }
     //! @brief Tuple case.
     template <typename... A>
-    tuple<A...>& align_inplace(tuple<A...>& x, std::vector<device_t>&& s) {
+    tuple<A...>& align_inplace(tuple<A...>& x, domain s) {
         return align_inplace(x, std::move(s), std::make_index_sequence<sizeof...(A)>{});
     }
     //! @{
 
     //! @brief Returns a fully aligned field with the default value modified.
     template <typename A, typename B>
-    to_field<A> mod_other(A const& x, B const& y, std::vector<device_t>&& s) {
+    to_field<A> mod_other(A const& x, B const& y, domain s) {
         std::vector<to_local<A>> vals;
         vals.reserve(s.size()+1);
         vals.push_back(other(y));
@@ -944,26 +1080,58 @@ namespace details {
     //! @}
 
     /**
-     * @name fold_hood
+     * @name fold operators
      *
-     * Reduces the values in a part of a field (determined by domain) to a single value through a binary operation.
+     * Common reduction operators, recognised by `fold_hood` to select dedicated kernels.
+     */
+    //! @{
+    //! @brief Folding by minimum.
+    template <typename T>
+    struct fold_min {
+        T operator()(T const& x, T const& y) const {
+            return std::min(x, y);
+        }
+    };
+    //! @brief Folding by maximum.
+    template <typename T>
+    struct fold_max {
+        T operator()(T const& x, T const& y) const {
+            return std::max(x, y);
+        }
+    };
+    //! @brief Folding by addition.
+    template <typename T>
+    struct fold_sum {
+        T operator()(T const& x, T const& y) const {
+            return x + y;
+        }
+    };
+    //! @brief Folding by logical and.
+    template <typename T>
+    struct fold_all {
+        T operator()(T const& x, T const& y) const {
+            return x and y;
+        }
+    };
+    //! @brief Folding by logical or.
+    template <typename T>
+    struct fold_any {
+        T operator()(T const& x, T const& y) const {
+            return x or y;
+        }
+    };
+    //! @}
+
+    /**
+     * @name fold_merge
+     *
+     * Reduces the values of a field-like structure on a domain to a single value, iterating through both.
      */
     //! @{
-    //! @brief Inclusive folding (optimization for locals).
-    template <typename F, typename A>
-    if_local<A, local_result<F,A const&,A const&>>
-    fold_hood(F&& op, A const& x, std::vector<device_t> const& dom) {
-        assert(dom.size() > 0);
-        size_t n = dom.size();
-        local_result<F,A const&,A const&> res = x;
-        for (--n; n>0; --n) res = op(x, res);
-        return res;
-    }
     //! @brief Inclusive folding.
     template <typename F, typename A>
-    if_field<A, local_result<F,A const&,A const&>>
-    fold_hood(F&& op, A const& f, std::vector<device_t> const& dom) {
-        assert(dom.size() > 0);
+    local_result<F,A const&,A const&>
+    fold_merge(F&& op, A const& f, domain const& dom) {
         field_iterator<A const> it(f);
         while (it.id() < dom[0]) ++it;
         local_result<F,A const&,A const&> res = it.value(dom[0]);
@@ -975,9 +1143,8 @@ namespace details {
     }
     //! @brief Inclusive folding with ids.
     template <typename F, typename A>
-    if_field<A, local_result<F,device_t,A const&,A const&>>
-    fold_hood(F&& op, A const& f, std::vector<device_t> const& dom) {
-        assert(dom.size() > 0);
+    local_result<F,device_t,A const&,A const&>
+    fold_merge(F&& op, A const& f, domain const& dom) {
         field_iterator<A const> it(f);
         while (it.id() < dom[0]) ++it;
         local_result<F,device_t,A const&,A const&> res = it.value(dom[0]);
@@ -987,20 +1154,10 @@ namespace details {
         }
         return res;
     }
-    //! @brief Exclusive folding (optimization for locals).
-    template <typename F, typename A, typename B>
-    if_local<A, local_result<F,A const&,B const&>>
-    fold_hood(F&& op, A const& x, B const& b, std::vector<device_t> const& dom, device_t i) {
-        assert(std::binary_search(dom.begin(), dom.end(), i));
-        local_result<F,A const&,B const&> res = details::self(b, i);
-        for (size_t n = dom.size(); n>1; --n) res = op(x, res);
-        return res;
-     }
     //! @brief Exclusive folding.
     template <typename F, typename A, typename B>
-    if_field<A, local_result<F,A const&,B const&>>
-    fold_hood(F&& op, A const& f, B const& b, std::vector<device_t> const& dom, device_t i) {
-        assert(std::binary_search(dom.begin(), dom.end(), i));
+    local_result<F,A const&,B const&>
+    fold_merge(F&& op, A const& f, B const& b, domain const& dom, device_t i) {
         local_result<F,A const&,B const&> res = self(b, i);
         field_iterator<A const> it(f);
         for (size_t k=0; k<dom.size(); ++k) if (dom[k] != i) {
@@ -1011,9 +1168,8 @@ namespace details {
     }
     //! @brief Exclusive folding with ids.
     template <typename F, typename A, typename B>
-    if_field<A, local_result<F,device_t,A const&,B const&>>
-    fold_hood(F&& op, A const& f, B const& b, std::vector<device_t> const& dom, device_t i) {
-        assert(std::binary_search(dom.begin(), dom.end(), i));
+    local_result<F,device_t,A const&,B const&>
+    fold_merge(F&& op, A const& f, B const& b, domain const& dom, device_t i) {
         local_result<F,device_t,A const&,B const&> res = self(b, i);
         field_iterator<A const> it(f);
         for (size_t k=0; k<dom.size(); ++k) if (dom[k] != i) {
@@ -1023,6 +1179,292 @@ namespace details {
         return res;
     }
     //! @}
+
+    /**
+     * @name fold_range
+     *
+     * Folds a range of values of a field into an accumulator.
+     */
+    //! @{
+    //! @brief Kernel tag for sequential folding.
+    struct fold_sequential {};
+    //! @brief Kernel tag for folding through independent partial results.
+    struct fold_lanes {};
+    //! @brief Kernel tag for folding through independent partial results in unsigned arithmetic.
+    struct fold_unsigned_lanes {};
+    //! @brief Kernel tag for folding booleans by logical and.
+    struct fold_find_false {};
+    //! @brief Kernel tag for folding booleans by logical or.
+    struct fold_find_true {};
+
+    //! @brief Selects the kernel folding values of type `T` into a result of type `R` by `F`.
+    template <typename F, typename T, typename R>
+    struct fold_kernel {
+        using type = fold_sequential;
+    };
+    //! @brief Minimum of integral values does not depend on the order of folding.
+    template <typename T>
+    struct fold_kernel<fold_min<T>, T, T> {
+        using type = std::conditional_t<std::is_same<T, bool>::value, fold_find_false, std::conditional_t<std::is_integral<T>::value, fold_lanes, fold_sequential>>;
+    };
+    //! @brief Maximum of integral values does not depend on the order of folding.
+    template <typename T>
+    struct fold_kernel<fold_max<T>, T, T> {
+        using type = std::conditional_t<std::is_same<T, bool>::value, fold_find_true, std::conditional_t<std::is_integral<T>::value, fold_lanes, fold_sequential>>;
+    };
+    //! @brief Sum of integral values does not depend on the order of folding (modulo wrap-around).
+    template <typename T>
+    struct fold_kernel<fold_sum<T>, T, T> {
+        using type = std::conditional_t<std::is_same<T, bool>::value, fold_find_true, std::conditional_t<std::is_integral<T>::value, fold_unsigned_lanes, fold_sequential>>;
+    };
+    //! @brief Logical and of integral values does not depend on the order of folding.
+    template <typename T>
+    struct fold_kernel<fold_all<T>, T, T> {
+        using type = std::conditional_t<std::is_same<T, bool>::value, fold_find_false, std::conditional_t<std::is_integral<T>::value, fold_lanes, fold_sequential>>;
+    };
+    //! @brief Logical or of integral values does not depend on the order of folding.
+    template <typename T>
+    struct fold_kernel<fold_any<T>, T, T> {
+        using type = std::conditional_t<std::is_same<T, bool>::value, fold_find_true, std::conditional_t<std::is_integral<T>::value, fold_lanes, fold_sequential>>;
+    };
+
+    //! @brief Sequential folding (in the same order as merged folding).
+    template <typename F, typename T, typename R>
+    R fold_range(F& op, std::vector<T> const& v, size_t b, size_t e, R res, fold_sequential) {
+        for (; b < e; ++b) res = op(v[b], res);
+        return res;
+    }
+    //! @brief Folding through eight independent partial results (allowing for vectorisation).
+    template <typename F, typename T>
+    T fold_range(F& op, T const* x, size_t b, size_t e, T res, fold_lanes) {
+        constexpr size_t lanes = 8;
+        if (b + 2*lanes <= e) {
+            T r[lanes];
+            for (size_t l = 0; l < lanes; ++l) r[l] = x[b+l];
+            for (b += lanes; b + lanes <= e; b += lanes)
+                for (size_t l = 0; l < lanes; ++l) r[l] = op(x[b+l], r[l]);
+            for (size_t l = 0; l < lanes; ++l) res = op(r[l], res);
+        }
+        for (; b < e; ++b) res = op(x[b], res);
+        return res;
+    }
+    //! @brief Folding through eight independent partial results (allowing for vectorisation).
+    template <typename F, typename T>
+    T fold_range(F& op, std::vector<T> const& v, size_t b, size_t e, T res, fold_lanes) {
+        return fold_range(op, v.data(), b, e, std::move(res), fold_lanes{});
+    }
+    //! @brief Summing through independent partial results, wrapping around as unsigned values.
+    template <typename F, typename T>
+    T fold_range(F&, std::vector<T> const& v, size_t b, size_t e, T res, fold_unsigned_lanes) {
+        using U = std::make_unsigned_t<T>;
+        fold_sum<U> op;
+        return T(fold_range(op, reinterpret_cast<U const*>(v.data()), b, e, U(res), fold_lanes{}));
+    }
+    //! @brief Folding booleans by logical and, looking for the first false value.
+    template <typename F>
+    bool fold_range(F&, std::vector<bool> const& v, size_t b, size_t e, bool res, fold_find_false) {
+        return res and std::find(v.begin()+b, v.begin()+e, false) == v.begin()+e;
+    }
+    //! @brief Folding booleans by logical or, looking for the first true value.
+    template <typename F>
+    bool fold_range(F&, std::vector<bool> const& v, size_t b, size_t e, bool res, fold_find_true) {
+        return res or std::find(v.begin()+b, v.begin()+e, true) != v.begin()+e;
+    }
+    //! @brief Folding with the kernel best suited to the operator and types.
+    template <typename F, typename T, typename R>
+    R fold_range(F& op, std::vector<T> const& v, size_t b, size_t e, R res) {
+        return fold_range(op, v, b, e, std::move(res), typename fold_kernel<std::remove_const_t<F>, T, R>::type{});
+    }
+    //! @}
+
+    /**
+     * @name fold_hood
+     *
+     * Reduces the values in a part of a field (determined by domain) to a single value through a binary operation.
+     * Fields sharing the given domain are folded directly on their values, without merging domains.
+     */
+    //! @{
+    //! @brief Inclusive folding (optimization for locals).
+    template <typename F, typename A>
+    if_local<A, local_result<F,A const&,A const&>>
+    fold_hood(F&& op, A const& x, domain const& dom) {
+        assert(dom.size() > 0);
+        size_t n = dom.size();
+        local_result<F,A const&,A const&> res = x;
+        for (--n; n>0; --n) res = op(x, res);
+        return res;
+    }
+    //! @brief Inclusive folding.
+    template <typename F, typename A>
+    if_field<A, local_result<F,A const&,A const&>>
+    fold_hood(F&& op, A const& f, domain const& dom) {
+        assert(dom.size() > 0);
+        return fold_merge(op, f, dom);
+    }
+    //! @brief Inclusive folding (optimization for fields).
+    template <typename F, typename T>
+    local_result<F,T const&,T const&>
+    fold_hood(F&& op, field<T> const& f, domain const& dom) {
+        using R = local_result<F,T const&,T const&>;
+        assert(dom.size() > 0);
+        if (not get_ids(f).same(dom)) return fold_merge(op, f, dom);
+        return fold_range(op, get_vals(f), 2, dom.size()+1, R(get_vals(f)[1]));
+    }
+    //! @brief Inclusive folding with ids.
+    template <typename F, typename A>
+    if_field<A, local_result<F,device_t,A const&,A const&>>
+    fold_hood(F&& op, A const& f, domain const& dom) {
+        assert(dom.size() > 0);
+        return fold_merge(op, f, dom);
+    }
+    //! @brief Inclusive folding with ids (optimization for fields).
+    template <typename F, typename T>
+    local_result<F,device_t,T const&,T const&>
+    fold_hood(F&& op, field<T> const& f, domain const& dom) {
+        assert(dom.size() > 0);
+        if (not get_ids(f).same(dom)) return fold_merge(op, f, dom);
+        local_result<F,device_t,T const&,T const&> res = get_vals(f)[1];
+        for (size_t k=1; k<dom.size(); ++k)
+            res = op(dom[k], get_vals(f)[k+1], res);
+        return res;
+    }
+    //! @brief Exclusive folding (optimization for locals).
+    template <typename F, typename A, typename B>
+    if_local<A, local_result<F,A const&,B const&>>
+    fold_hood(F&& op, A const& x, B const& b, domain const& dom, device_t i) {
+        assert(std::binary_search(dom.begin(), dom.end(), i));
+        local_result<F,A const&,B const&> res = details::self(b, i);
+        for (size_t n = dom.size(); n>1; --n) res = op(x, res);
+        return res;
+     }
+    //! @brief Exclusive folding.
+    template <typename F, typename A, typename B>
+    if_field<A, local_result<F,A const&,B const&>>
+    fold_hood(F&& op, A const& f, B const& b, domain const& dom, device_t i) {
+        assert(std::binary_search(dom.begin(), dom.end(), i));
+        return fold_merge(op, f, b, dom, i);
+    }
+    //! @brief Exclusive folding (optimization for fields).
+    template <typename F, typename T, typename B>
+    local_result<F,T const&,B const&>
+    fold_hood(F&& op, field<T> const& f, B const& b, domain const& dom, device_t i) {
+        using R = local_result<F,T const&,B const&>;
+        assert(std::binary_search(dom.begin(), dom.end(), i));
+        if (not get_ids(f).same(dom)) return fold_merge(op, f, b, dom, i);
+        size_t j = std::lower_bound(dom.begin(), dom.end(), i) - dom.begin() + 1;
+        R res = fold_range(op, get_vals(f), 1, j, R(self(b, i)));
+        return fold_range(op, get_vals(f), j+1, dom.size()+1, std::move(res));
+    }
+    //! @brief Exclusive folding with ids.
+    template <typename F, typename A, typename B>
+    if_field<A, local_result<F,device_t,A const&,B const&>>
+    fold_hood(F&& op, A const& f, B const& b, domain const& dom, device_t i) {
+        assert(std::binary_search(dom.begin(), dom.end(), i));
+        return fold_merge(op, f, b, dom, i);
+    }
+    //! @brief Exclusive folding with ids (optimization for fields).
+    template <typename F, typename T, typename B>
+    local_result<F,device_t,T const&,B const&>
+    fold_hood(F&& op, field<T> const& f, B const& b, domain const& dom, device_t i) {
+        assert(std::binary_search(dom.begin(), dom.end(), i));
+        if (not get_ids(f).same(dom)) return fold_merge(op, f, b, dom, i);
+        local_result<F,device_t,T const&,B const&> res = self(b, i);
+        for (size_t k=0; k<dom.size(); ++k) if (dom[k] != i)
+            res = op(dom[k], get_vals(f)[k+1], res);
+        return res;
+    }
+    //! @}
+}
+//! @endcond
+
+
+//! @cond INTERNAL
+namespace details {
+    /**
+     * @brief Builder of a field from values set for individual devices.
+     *
+     * Values are appended unsorted in constant amortised time, and merged into the field
+     * (sorting them once) only when the field is accessed through `build`. The const accessors
+     * `merged` and `self` are pure reads, which include the pending values without merging them.
+     */
+    template <typename T>
+    class field_builder {
+      public:
+        //! @brief The type of the content.
+        using value_type = T;
+
+        //! @brief Builder of a constant field.
+        field_builder(T const& def = T()) : m_field(def) {}
+
+        //! @brief Sets the value for a device (overriding previous ones).
+        void insert(device_t d, T v) {
+            m_pending.emplace_back(d, std::move(v));
+        }
+
+        //! @brief Number of values not yet merged into the field.
+        size_t pending() const {
+            return m_pending.size();
+        }
+
+        //! @brief Accesses the field, merging the pending values into it.
+        field<T>& build() {
+            merge();
+            return m_field;
+        }
+
+        //! @brief Copy of the field with the pending values merged (leaving the builder unchanged).
+        field<T> merged() const {
+            field_builder<T> b(*this);
+            return std::move(b.build());
+        }
+
+        //! @brief Value for a device, including pending values (leaving the builder unchanged).
+        T self(device_t d) const {
+            for (auto it = m_pending.rbegin(); it != m_pending.rend(); ++it)
+                if (it->first == d) return it->second;
+            return details::self(m_field, d);
+        }
+
+      private:
+        //! @brief Merges the pending values into the field.
+        void merge() {
+            if (m_pending.empty()) return;
+            std::stable_sort(m_pending.begin(), m_pending.end(), [](std::pair<device_t, T> const& x, std::pair<device_t, T> const& y) {
+                return x.first < y.first;
+            });
+            domain const& ids = get_ids(m_field);
+            std::vector<T>& vals = get_vals(m_field);
+            std::vector<device_t> rids;
+            std::vector<T> rvals;
+            rids.reserve(ids.size() + m_pending.size());
+            rvals.reserve(ids.size() + m_pending.size() + 1);
+            rvals.push_back(std::move(vals[0]));
+            size_t i = 0;
+            for (size_t k = 0; k < m_pending.size(); ++k) {
+                device_t d = m_pending[k].first;
+                if (k+1 < m_pending.size() and m_pending[k+1].first == d) continue;
+                for (; i < ids.size() and ids[i] < d; ++i) {
+                    rids.push_back(ids[i]);
+                    rvals.push_back(std::move(vals[i+1]));
+                }
+                if (i < ids.size() and ids[i] == d) ++i;
+                rids.push_back(d);
+                rvals.push_back(std::move(m_pending[k].second));
+            }
+            for (; i < ids.size(); ++i) {
+                rids.push_back(ids[i]);
+                rvals.push_back(std::move(vals[i+1]));
+            }
+            m_field = make_field(std::move(rids), std::move(rvals));
+            m_pending.clear();
+        }
+
+        //! @brief The field with values merged so far.
+        field<T> m_field;
+
+        //! @brief Values set after the last merge, in order of insertion.
+        std::vector<std::pair<device_t, T>> m_pending;
+    };
 }
 //! @endcond
 
@@ -1037,10 +1479,12 @@ namespace details {
 template <typename F, typename... A, typename = if_field<tuple<A...>>>
 field_result<F,A...> map_hood(F&& op, A const&... a) {
     field_result<F,A...> r(op(details::other(a)...));
+    std::vector<device_t> ids;
     for (details::field_iterator<tuple<A...> const> it(a...); not it.end(); ++it) {
-        details::get_ids(r).push_back(it.id());
+        ids.push_back(it.id());
         details::get_vals(r).push_back(it.apply(op));
     }
+    details::get_ids(r) = std::move(ids);
     return r;
 }
 //! @brief Optimisation for all local arguments.
@@ -1108,29 +1552,40 @@ field_result<F,A,B,field<T>,L...> map_hood(F&& op, A&& a, B&& b, field<T> const&
             details::get_vals(r)[i] = op(a, b, details::get_vals(f)[i], l...);
     return r;
 }
-//! @brief Optimisation for two field arguments in starting position.
+//! @brief Optimisation for two field arguments in starting position (not merging domains if shared).
 template <typename F, typename T, typename U, typename... L, typename = if_local<tuple<L...>>>
 field_result<F,field<T>,field<U>,L...> map_hood(F&& op, field<T> const& f, field<U> const& g, L&&... l) {
     field_result<F,field<T>,field<U>,L...> r;
-    details::get_ids(r).reserve(details::get_ids(f).size() + details::get_ids(g).size());
+    if (details::get_ids(f).same(details::get_ids(g))) {
+        details::get_ids(r) = details::get_ids(f);
+        details::get_vals(r).resize(details::get_vals(f).size());
+        for (size_t i = 0; i < details::get_vals(f).size(); ++i)
+            details::get_vals(r)[i] = op(details::get_vals(f)[i], details::get_vals(g)[i], l...);
+        return r;
+    }
+    std::vector<device_t> ids;
+    ids.reserve(details::get_ids(f).size() + details::get_ids(g).size());
     details::get_vals(r).reserve(details::get_ids(f).size() + details::get_ids(g).size() + 1);
     details::get_vals(r).push_back(op(details::get_vals(f)[0], details::get_vals(g)[0], l...));
     size_t i = 0, j = 0;
     while (i < details::get_ids(f).size() or j < details::get_ids(g).size()) {
         if (i == details::get_ids(f).size()) {
-            details::get_ids(r).push_back(details::get_ids(g)[j]);
+            ids.push_back(details::get_ids(g)[j]);
             details::get_vals(r).push_back(op(details::get_vals(f)[0], details::get_vals(g)[++j], l...));
         } else if (j == details::get_ids(g).size() or details::get_ids(f)[i] < details::get_ids(g)[j]) {
-            details::get_ids(r).push_back(details::get_ids(f)[i]);
+            ids.push_back(details::get_ids(f)[i]);
             details::get_vals(r).push_back(op(details::get_vals(f)[++i], details::get_vals(g)[0], l...));
         } else if (details::get_ids(f)[i] > details::get_ids(g)[j]) {
-            details::get_ids(r).push_back(details::get_ids(g)[j]);
+            ids.push_back(details::get_ids(g)[j]);
             details::get_vals(r).push_back(op(details::get_vals(f)[0], details::get_vals(g)[++j], l...));
         } else {
-            details::get_ids(r).push_back(details::get_ids(f)[i]);
+            ids.push_back(details::get_ids(f)[i]);
             details::get_vals(r).push_back(op(details::get_vals(f)[++i], details::get_vals(g)[++j], l...));
         }
     }
+    if (ids.size() == details::get_ids(f).size()) details::get_ids(r) = details::get_ids(f);
+    else if (ids.size() == details::get_ids(g).size()) details::get_ids(r) = details::get_ids(g);
+    else details::get_ids(r) = std::move(ids);
     return r;
 }
 //! @}
@@ -1160,6 +1615,19 @@ if_local<tuple<L...>, field<A>&> mod_hood(F&& op, field<A>& a, L const&... l) {
     for (typename std::vector<A>::reference x : details::get_vals(a)) x = op(x, l...);
     return a;
 }
+//! @brief Optimisation for two field arguments (not merging domains if shared).
+template <typename F, typename A, typename B>
+field<A>& mod_hood(F&& op, field<A>& a, field<B> const& b) {
+    if (details::get_ids(a).same(details::get_ids(b))) {
+        for (size_t i = 0; i < details::get_vals(a).size(); ++i)
+            details::get_vals(a)[i] = op(details::get_vals(a)[i], details::get_vals(b)[i]);
+        return a;
+    }
+    for (details::field_iterator<tuple<field<A>,field<B> const>> it(a,b); not it.end(); ++it)
+        get<0>(it).emplace(it.id(), it.apply(op));
+    details::other(a) = op(details::other(a), details::other(b));
+    return a;
+}
 //! @}
 
 
@@ -1181,14 +1649,15 @@ field<A> operator op(field<A> const& x) {
 }                                                                                   \
 template <typename A>                                                               \
 field<A> operator op(field<A>&& x) {                                                \
-    mod_hood([] (A const& a) {return op std::move(a);}, x);                         \
-    return x;                                                                       \
+    return std::move(mod_hood([] (A const& a) {return op std::move(a);}, x));       \
 }
 
 /**
  * @brief Overloads binary operators for fields.
  *
  * Used to overload every operator available for the base type.
+ * Temporary field operands are updated in-place whenever the result type allows it,
+ * so that chained expressions reuse the storage of their intermediate results.
  * Macro not available outside of the scope of this file.
  */
 #define _DEF_BOP(op)                                                                                    \
@@ -1199,7 +1668,8 @@ _BOP_TYPE(field<A>,op,B) operator op(field<A> const& x, B const& y) {
 template <typename A, typename B>                                                                       \
 std::enable_if_t<std::is_same<_BOP_TYPE(field<A>,op,B), field<A>>::value, field<A>>                     \
 operator op(field<A>&& x, B const& y) {                                                                 \
-    return mod_hood([](A const& a, to_local<B> const& b) { return std::move(a) op b; }, x, y);          \
+    return std::move(mod_hood([](A const& a, to_local<B> const& b)                                      \
+        { return std::move(a) op b; }, x, y));                                                          \
 }                                                                                                       \
 template <typename A, typename B>                                                                       \
 std::enable_if_t<not std::is_same<_BOP_TYPE(field<A>,op,B), field<A>>::value, _BOP_TYPE(field<A>,op,B)> \
@@ -1211,6 +1681,28 @@ common::ifn_class_template<field, A, _BOP_TYPE(A,op,field<B>)>
 operator op(A const& x, field<B> const& y) {                                                            \
     return map_hood([](to_local<A> const& a, B const& b) { return a op b; }, x, y);                     \
 }                                                                                                       \
+template <typename A, typename B>                                                                       \
+std::enable_if_t<std::is_same<_BOP_TYPE(A,op,field<B>), field<B>>::value, field<B>>                     \
+operator op(A const& x, field<B>&& y) {                                                                 \
+    return std::move(mod_hood([](B const& b, to_local<A> const& a)                                      \
+        { return a op std::move(b); }, y, x));                                                          \
+}                                                                                                       \
+template <typename A, typename B>                                                                       \
+std::enable_if_t<not std::is_same<_BOP_TYPE(A,op,field<B>), field<B>>::value, _BOP_TYPE(A,op,field<B>)> \
+operator op(A const& x, field<B>&& y) {                                                                 \
+    return map_hood([](to_local<A> const& a, B const& b) { return a op b; }, x, y);                     \
+}                                                                                                       \
+template <typename A, typename B>                                                                       \
+std::enable_if_t<std::is_same<_BOP_TYPE(field<A>,op,field<B>), field<A>>::value, field<A>>              \
+operator op(field<A>&& x, field<B>&& y) {                                                               \
+    return std::move(mod_hood([](A const& a, B const& b) { return std::move(a) op b; }, x, y));         \
+}                                                                                                       \
+template <typename A, typename B>                                                                       \
+std::enable_if_t<not std::is_same<_BOP_TYPE(field<A>,op,field<B>), field<A>>::value,                    \
+                 _BOP_TYPE(field<A>,op,field<B>)>                                                       \
+operator op(field<A>&& x, field<B>&& y) {                                                               \
+    return static_cast<field<A> const&>(x) op std::move(y);                                             \
+}                                                                                                       \
 
 /**
  * @brief Overloads composite assignment operators for fields.
@@ -1266,7 +1758,7 @@ _BOP_TYPE(field<A>,<<,B) operator<<(field<A> const& x, B const& y) {
 }
 template <typename A, typename B>
 _BOP_TYPE(field<A>,<<,B) operator<<(field<A>&& x, B const& y) {
-    return mod_hood([](A const& a, to_local<B> const& b) { return std::move(a) << b; }, x, y);
+    return std::move(mod_hood([](A const& a, to_local<B> const& b) { return std::move(a) << b; }, x, y));
 }
 template <typename A, typename B>
 std::enable_if_t<
@@ -16,6 +16,7 @@
 #include "lib/deployment/hardware_logger.hpp"
 #include "lib/deployment/os.hpp"
 #include "lib/deployment/persister.hpp"
+#include "lib/deployment/udp_transceiver.hpp"
 
 
 /**
@@ -34,6 +34,10 @@ namespace component {
 
 // Namespace of tags to be used for initialising components.
 namespace tags {
+    //! @brief Declaration flag associating to whether messages and snapshots are serialised in compact encoding, shrinking small integers while keeping trace keys at full width (defaults to false).
+    template <bool b>
+    struct compact_encoding {};
+
     //! @brief Declaration tag associating to a connector class (defaults to \ref os::async_retry_network "os::async_retry_network<message_push>").
     template <typename T>
     struct connector;
@@ -66,6 +70,7 @@ namespace tags {
  * - \ref tags::delay defines the delay generator for sending messages after rounds (defaults to zero delay through \ref distribution::constant_n "distribution::constant_n<times_t, 0>").
  *
  * <b>Declaration flags:</b>
+ * - \ref tags::compact_encoding defines whether messages are serialised in compact encoding (defaults to false).
  * - \ref tags::message_push defines whether incoming messages are pushed or pulled (defaults to \ref FCPP_MESSAGE_PUSH).
  * - \ref tags::parallel defines whether parallelism is enabled (defaults to \ref FCPP_PARALLEL).
  *
@@ -80,6 +85,9 @@ struct hardware_connector {
     //! @brief Whether parallelism is enabled.
     constexpr static bool parallel = common::option_flag<tags::parallel, FCPP_PARALLEL, Ts...>;
 
+    //! @brief The wire encoding of messages.
+    constexpr static common::encoding wire_encoding = common::option_flag<tags::compact_encoding, false, Ts...> ? common::encoding::compact : common::encoding::plain;
+
     //! @brief Delay generator for sending messages after rounds.
     using delay_type = common::option_type<tags::delay, distribution::constant_n<times_t, 0>, Ts...>;
 
@@ -117,7 +125,7 @@ struct hardware_connector {
              * @param t A `tagged_tuple` gathering initialisation values.
              */
             template <typename S, typename T>
-            node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), m_delay(get_generator(has_randomizer<P>{}, *this),t), m_send(TIME_MAX), m_nbr_dist(INF), m_nbr_msg_size(0), m_network(*this, common::get_or<tags::connection_data>(t, connection_data_type{})) {}
+            node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), m_delay(get_generator(has_randomizer<P>{}, *this),t), m_send(TIME_MAX), m_nbr_dist(INF), m_nbr_msg_size(0), m_buffer(wire_encoding), m_network(*this, common::get_or<tags::connection_data>(t, connection_data_type{})) {}
 
             //! @brief Connector data.
             connection_data_type& connector_data() {
@@ -157,11 +165,14 @@ struct hardware_connector {
             void update() {
                 if (m_send < P::node::next()) {
                     PROFILE_COUNT("connector");
-                    common::osstream os;
                     typename F::node::message_t m;
-                    os << P::node::as_final().send(m_send, m);
-                    fcpp::details::self(m_nbr_msg_size, P::node::uid) = os.size();
-                    m_network.send(std::move(os));
+                    P::node::as_final().send(m_send, m);
+                    m_buffer.clear();
+                    // one more byte for the timestamp appended by the network
+                    m_buffer.reserve(common::serialized_size_of(m, wire_encoding) + 1);
+                    m_buffer << m;
+                    m_nbr_msg_size.insert(P::node::uid, m_buffer.size());
+                    m_network.send(m_buffer.data());
                     P::node::as_final().receive(m_send, P::node::uid, m);
                     m_send = TIME_MAX;
                 } else P::node::update();
@@ -176,8 +187,8 @@ struct hardware_connector {
                     for (message_type& m : mv) receive(m);
                 }
                 P::node::round_start(t);
-                maybe_align_inplace(m_nbr_dist, has_calculus<P>{});
-                maybe_align_inplace(m_nbr_msg_size, has_calculus<P>{});
+                maybe_align_inplace(m_nbr_dist.build(), has_calculus<P>{});
+                maybe_align_inplace(m_nbr_msg_size.build(), has_calculus<P>{});
             }
 
             //! @brief Receives an incoming message (possibly reading values from sensors).
@@ -187,9 +198,9 @@ struct hardware_connector {
             void receive(message_type& m) {
                 PROFILE_COUNT("connector");
                 common::lock_guard<parallel> l(P::node::mutex);
-                fcpp::details::self(m_nbr_dist, m.device) = m.power;
-                fcpp::details::self(m_nbr_msg_size, m.device) = m.content.size();
-                common::isstream is(std::move(m.content));
+                m_nbr_dist.insert(m.device, m.power);
+                m_nbr_msg_size.insert(m.device, m.content.size());
+                common::isstream is(m.content.data(), m.content.size(), wire_encoding);
                 typename F::node::message_t mt;
 #ifndef FCPP_DISABLE_EXCEPTIONS
                 try {
@@ -203,18 +214,33 @@ struct hardware_connector {
             }
 
             //! @brief Perceived distances from neighbours.
-            field<real_t> const& nbr_dist() const {
-                return m_nbr_dist;
+            field<real_t> const& nbr_dist() {
+                return m_nbr_dist.build();
+            }
+
+            //! @brief Perceived distances from neighbours (const access, by copy).
+            field<real_t> nbr_dist() const {
+                return m_nbr_dist.merged();
             }
 
             //! @brief Size of last message sent.
+            size_t msg_size() {
+                return fcpp::details::self(m_nbr_msg_size.build(), P::node::uid);
+            }
+
+            //! @brief Size of last message sent (const access).
             size_t msg_size() const {
-                return fcpp::details::self(m_nbr_msg_size, P::node::uid);
+                return m_nbr_msg_size.self(P::node::uid);
             }
 
             //! @brief Sizes of messages received from neighbours.
-            field<size_t> const& nbr_msg_size() const {
-                return m_nbr_msg_size;
+            field<size_t> const& nbr_msg_size() {
+                return m_nbr_msg_size.build();
+            }
+
+            //! @brief Sizes of messages received from neighbours (const access, by copy).
+            field<size_t> nbr_msg_size() const {
+                return m_nbr_msg_size.merged();
             }
 
           private: // implementation details
@@ -233,7 +259,7 @@ struct hardware_connector {
             //! @brief Changes the domain of a field-like structure to match the domain of the neightbours ids.
             template <typename A>
             void maybe_align_inplace(field<A>& x, std::true_type) {
-                align_inplace(x, std::vector<device_t>(fcpp::details::get_ids(P::node::nbr_uid())));
+                align_inplace(x, fcpp::details::get_ids(P::node::nbr_uid()));
             }
 
             //! @brief Does not perform any alignment
@@ -247,10 +273,13 @@ struct hardware_connector {
             times_t m_send;
 
             //! @brief Perceived distances from neighbours.
-            field<real_t> m_nbr_dist;
+            fcpp::details::field_builder<real_t> m_nbr_dist;
 
             //! @brief Sizes of messages received from neighbours.
-            field<size_t> m_nbr_msg_size;
+            fcpp::details::field_builder<size_t> m_nbr_msg_size;
+
+            //! @brief Buffer for serialising outgoing messages (reused across sends).
+            common::osstream m_buffer;
 
             //! @brief Backend regulating and performing the connection.
             connector_type m_network;
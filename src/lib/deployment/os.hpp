@@ -11,7 +11,11 @@
 #include <cassert>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <thread>
 #include <vector>
 
 #include "lib/settings.hpp"
@@ -51,17 +55,34 @@ device_t uid();
  *
  * It should have the following minimal public interface:
  * ~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
- * struct data_type;                            // default-constructible type for settings
- * data_type data;                              // network settings
- * transceiver(data_type);                      // constructor with settings
- * bool send(device_t, std::vector<char>, int); // broadcasts a message after given attemps
- * message_type receive(int);                   // listens for messages after given failed sends
+ * struct data_type;                                   // default-constructible type for settings
+ * data_type data;                                     // network settings
+ * transceiver(data_type);                             // constructor with settings
+ * bool send(device_t, std::vector<char> const&, int); // broadcasts a message after given attemps
+ * message_type receive(int);                          // listens for messages after given failed sends
  * ~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 struct transceiver;
 
 /**
  * @brief Wrapper for the default network connector
+ *
+ * Messages are handled by a dedicated thread, which sleeps while there is nothing to do:
+ * it is woken up by new messages to send, retries failed sends with exponential backoff,
+ * and polls the transceiver for incoming messages at most once per \ref idle_period,
+ * unless the transceiver receive blocks waiting for messages (for at least \ref block_period).
+ * Thus with a non-blocking transceiver (whose receive returns immediately when there are no
+ * messages), a message may be received up to \ref idle_period (16ms) after it arrives; transceivers
+ * waiting for incoming messages within receive (as \ref udp_transceiver) are polled again
+ * right away, and do not add this latency.
+ * A message scheduled for sending replaces any previous message not yet sent, since the
+ * newest message supersedes the older ones.
+ *
+ * Messages are exchanged with the caller by swapping buffers, and handed to the transceiver
+ * by reference, so that no message is copied or allocated in a steady state.
+ * Thus `network::send` takes its argument by non-const reference: callers passing
+ * temporaries (as in `send(std::move(v))`) should pass a named buffer instead.
+ *
  * @param push Whether incoming messages should be immediately pushed to the node.
  * @param transceiver_t The transceiver type.
  */
@@ -82,6 +103,18 @@ class network {
     //! @brief Default-constructible type for network settings.
     using data_type = typename transceiver_t::data_type;
 
+    //! @brief Minimum duration of an iteration of the network thread in which no message is received.
+    constexpr static std::chrono::milliseconds idle_period{16};
+
+    //! @brief Minimum duration of an empty receive for the transceiver to be considered as blocking (so that the idle period is skipped).
+    constexpr static std::chrono::milliseconds block_period{1};
+
+    //! @brief Waiting time before the first retry of a failed send (doubling at every further failure).
+    constexpr static std::chrono::milliseconds retry_period{1};
+
+    //! @brief Maximum waiting time before retrying a failed send.
+    constexpr static std::chrono::milliseconds retry_max_period{128};
+
     //! @brief Constructor with default settings.
     network(N& n) : m_node(n), m_transceiver({}), m_manager(std::mem_fn(&network::manage), this) {}
 
@@ -89,7 +122,11 @@ class network {
     network(N& n, data_type d) : m_node(n), m_transceiver(d), m_manager(std::mem_fn(&network::manage), this) {}
 
     ~network() {
-        m_running = false;
+        {
+            common::lock_guard<true> l(m_send_mutex);
+            m_running = false;
+        }
+        m_wake.notify_one();
         m_manager.join();
     }
 
@@ -103,12 +140,16 @@ class network {
         return m_transceiver.data;
     }
 
-    //! @brief Schedules the broadcast of a message.
-    void send(std::vector<char> m) {
-        common::lock_guard<true> l(m_send_mutex);
-        m_send = std::move(m);
-        m_send_time = m_node.net.internal_time();
-        m_attempt = 0;
+    //! @brief Schedules the broadcast of a message, handing back a previous buffer for reuse in `m`.
+    void send(std::vector<char>& m) {
+        {
+            common::lock_guard<true> l(m_send_mutex);
+            m_send.swap(m);
+            m_send_time = m_node.net.internal_time();
+            m_attempt = 0;
+            m_retry = clock_type::time_point::min();
+        }
+        m_wake.notify_one();
     }
 
     //! @brief Retrieves the collection of incoming messages.
@@ -122,24 +163,29 @@ class network {
     }
 
   private:
+    //! @brief The clock type used for timing network operations.
+    using clock_type = std::chrono::steady_clock;
+
     //! @brief Manages the send and receive of messages.
     void manage() {
         while (m_running) {
+            clock_type::time_point start = clock_type::now();
             {
                 common::lock_guard<true> l(m_send_mutex);
-                if (not m_send.empty()) {
+                if (not m_send.empty() and m_retry <= start) {
                     m_send.push_back((char)std::min((m_node.net.internal_time() - m_send_time)*128, times_t{255}));
                     // sending
                     if (m_transceiver.send(m_node.uid, m_send, m_attempt))
                         m_send.clear();
                     else {
                         m_send.pop_back();
+                        m_retry = clock_type::now() + std::min<clock_type::duration>(retry_period * (1LL << std::min(m_attempt, 16)), retry_max_period);
                         ++m_attempt;
                     }
                 }
             }
-            std::this_thread::yield();
             // receiving
+            clock_type::time_point polled = clock_type::now();
             message_type m = m_transceiver.receive(m_attempt);
             if (not m.content.empty()) {
                 m.time = m_node.net.internal_time() - m.content.back() / times_t{128};
@@ -149,8 +195,17 @@ class network {
                     common::lock_guard<true> l(m_receive_mutex);
                     m_receive.push_back(std::move(m));
                 }
+                continue;
             }
-            std::this_thread::yield();
+            // a blocking receive already waited for incoming messages
+            if (clock_type::now() - polled >= block_period) continue;
+            // waiting for a new message to send, a retry or the next poll
+            common::unique_lock<true> l(m_send_mutex);
+            clock_type::time_point wake = start + idle_period;
+            if (not m_send.empty()) wake = std::min(wake, m_retry);
+            m_wake.wait_until(l, wake, [this,wake] {
+                return not m_running or (not m_send.empty() and m_retry < wake);
+            });
         }
     }
 
@@ -163,8 +218,11 @@ class network {
     //! @brief A mutex for regulating network operations.
     common::mutex<true> m_send_mutex, m_receive_mutex;
 
+    //! @brief Condition variable waking the network thread.
+    std::condition_variable_any m_wake;
+
     //! @brief Whether the object is alive and running.
-    bool m_running = true;
+    std::atomic<bool> m_running{true};
 
     //! @brief Collection of received messages.
     std::vector<message_type> m_receive;
@@ -178,12 +236,33 @@ class network {
     //! @brief Number of attempts failed for a send.
     int m_attempt = 0;
 
+    //! @brief Earliest time for the next attempt of a send.
+    clock_type::time_point m_retry;
+
     //! @brief Thread managing send and receive of messages.
     std::thread m_manager;
 };
 
 };
 
+//! @cond INTERNAL
+template <bool push, typename transceiver_t>
+template <typename N>
+constexpr std::chrono::milliseconds async_retry_network<push, transceiver_t>::network<N>::idle_period;
+
+template <bool push, typename transceiver_t>
+template <typename N>
+constexpr std::chrono::milliseconds async_retry_network<push, transceiver_t>::network<N>::block_period;
+
+template <bool push, typename transceiver_t>
+template <typename N>
+constexpr std::chrono::milliseconds async_retry_network<push, transceiver_t>::network<N>::retry_period;
+
+template <bool push, typename transceiver_t>
+template <typename N>
+constexpr std::chrono::milliseconds async_retry_network<push, transceiver_t>::network<N>::retry_max_period;
+//! @endcond
+
 }
 
 
@@ -30,6 +30,10 @@ namespace component {
 
 // Namespace of tags to be used for initialising components.
 namespace tags {
+    //! @brief Declaration flag associating to whether messages and snapshots are serialised in compact encoding, shrinking small integers while keeping trace keys at full width (defaults to false).
+    template <bool b>
+    struct compact_encoding;
+
     //! @brief Declaration tag associating to the input/output stream type to be used (defaults to `std::fstream`).
     template <typename T>
     struct stream_type {};
@@ -45,6 +49,9 @@ namespace tags {
  * <b>Declaration tags:</b>
  * - \ref tags::stream_type defines the input/output stream type to be used (defaults to `std::fstream`).
  *
+ * <b>Declaration flags:</b>
+ * - \ref tags::compact_encoding defines whether snapshots are serialised in compact encoding (defaults to false).
+ *
  * <b>Node initialisation tags:</b>
  * - \ref tags::persistence_path associates to a path for persistence (defaults to no persistence).
  */
@@ -53,6 +60,9 @@ struct persister {
     //! @brief The input/output stream type to be used.
     using stream_type = common::option_type<tags::stream_type, std::fstream, Ts ...>;
 
+    //! @brief The encoding of snapshots.
+    constexpr static common::encoding snapshot_encoding = common::option_flag<tags::compact_encoding, false, Ts...> ? common::encoding::compact : common::encoding::plain;
+
     /**
      * @brief The actual component.
      *
@@ -87,25 +97,22 @@ struct persister {
                     char c;
                     while (in >> c) v.push_back(c);
                     if (v.size()) {
-                        common::isstream is(std::move(v));
+                        common::isstream is(std::move(v), snapshot_encoding);
                         is >> P::node::storage_tuple();
                         is >> fcpp::details::get_context(*this);
                         is >> fcpp::details::get_export(*this);
-                        size_t l = is.size();
-                        v = std::move(is.data());
-                        v.erase(v.begin(), v.begin() + (v.size() - l));
-                        m_is.data() = std::move(v);
+                        m_is = std::move(is);
                     }
                 }
             }
 
             //! @brief Performs computations at round start with current time `t`.
             void round_start(times_t t) {
-                if (m_is.data().size() > 0) {
+                if (m_is.size() > 0) {
                     typename F::node::message_t m;
                     m_is >> m;
                     P::node::receive(t, P::node::uid, m);
-                    m_is.data().clear();
+                    m_is = common::isstream({});
                 }
                 P::node::round_start(t);
             }
@@ -115,7 +122,7 @@ struct persister {
                 P::node::round_end(t);
                 if (m_path.size()) {
                     stream_type out(m_path, std::ios_base::out);
-                    common::osstream os;
+                    common::osstream os(snapshot_encoding);
                     os << P::node::storage_tuple();
                     os << fcpp::details::get_context(*this);
                     os << fcpp::details::get_export(*this);
@@ -0,0 +1,345 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file udp_transceiver.hpp
+ * @brief Implementation of a transceiver through UDP broadcast or multicast on Linux.
+ */
+
+#ifndef FCPP_DEPLOYMENT_UDP_TRANSCEIVER_H_
+#define FCPP_DEPLOYMENT_UDP_TRANSCEIVER_H_
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lib/settings.hpp"
+#include "lib/deployment/os.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Namespace containing OS-dependent functionalities.
+namespace os {
+
+
+/**
+ * @brief Transceiver exchanging messages as UDP datagrams, broadcast or multicast to a group of devices (Linux only).
+ *
+ * Satisfies the interface of \ref transceiver, and can be used with \ref async_retry_network
+ * (as in `tags::connector<os::async_retry_network<push, os::udp_transceiver>>`).
+ * Messages longer than a datagram are split into fragments, which are sent together through
+ * a single `sendmmsg` call, and reassembled by receivers. Incoming datagrams are read in batches
+ * through `recvmmsg` into buffers allocated once at construction. Sockets are non-blocking:
+ * a receive waits for incoming datagrams through `poll` for at most `data_type::timeout`.
+ *
+ * Every datagram starts with a header of \ref header_size bytes in network byte order, so that
+ * devices with different architectures can communicate. Messages needing more than `UINT16_MAX`
+ * fragments cannot be sent: they are discarded and counted by \ref dropped, since retrying them
+ * would never succeed.
+ *
+ * The default settings broadcast on the loopback interface, so that several devices can
+ * exchange messages within a single machine. Devices sharing a group should have different
+ * identifiers (messages with the identifier of the receiver are discarded as self-messages).
+ */
+class udp_transceiver {
+  public:
+    //! @brief Settings of the transceiver.
+    struct data_type {
+        //! @brief Destination address (IPv4 broadcast or multicast address).
+        std::string address = "127.255.255.255";
+        //! @brief Address of the local interface used for multicast.
+        std::string interface = "127.0.0.1";
+        //! @brief The UDP port shared by the group of devices.
+        uint16_t port = 47001;
+        //! @brief Maximum size of a datagram (including the fragment header).
+        size_t datagram_size = 1472;
+        //! @brief Maximum number of datagrams received with a single system call.
+        size_t batch_size = 64;
+        //! @brief Maximum waiting time for incoming datagrams in a receive (in milliseconds).
+        int timeout = 4;
+        //! @brief Signal power reported for received messages.
+        real_t power = 1;
+    };
+
+    //! @brief Size of the header preceding the content of every datagram.
+    constexpr static size_t header_size = 22;
+
+    //! @brief Network settings.
+    data_type data;
+
+    //! @brief Constructor with settings.
+    udp_transceiver(data_type d) : data(d) {
+        if (data.datagram_size <= header_size or data.batch_size == 0)
+            throw std::invalid_argument("udp_transceiver: invalid datagram or batch size");
+        m_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        if (m_socket < 0) fail("socket");
+        int one = 1;
+        ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        ::setsockopt(m_socket, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+        std::memset(&m_target, 0, sizeof(m_target));
+        m_target.sin_family = AF_INET;
+        m_target.sin_port = htons(data.port);
+        if (::inet_pton(AF_INET, data.address.c_str(), &m_target.sin_addr) != 1) fail("address");
+        if (IN_MULTICAST(ntohl(m_target.sin_addr.s_addr))) {
+            ip_mreq group;
+            group.imr_multiaddr = m_target.sin_addr;
+            if (::inet_pton(AF_INET, data.interface.c_str(), &group.imr_interface) != 1) fail("interface");
+            if (::setsockopt(m_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) fail("multicast membership");
+            ::setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_IF, &group.imr_interface, sizeof(group.imr_interface));
+            ::setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_LOOP, &one, sizeof(one));
+        }
+        sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(data.port);
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (::bind(m_socket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) fail("bind");
+        // preallocated receive buffers
+        m_buffer.resize(data.batch_size * data.datagram_size);
+        m_recv_iov.resize(data.batch_size);
+        m_recv_msg.resize(data.batch_size);
+        for (size_t i = 0; i < data.batch_size; ++i) {
+            m_recv_iov[i].iov_base = m_buffer.data() + i * data.datagram_size;
+            m_recv_iov[i].iov_len = data.datagram_size;
+            std::memset(&m_recv_msg[i], 0, sizeof(mmsghdr));
+            m_recv_msg[i].msg_hdr.msg_iov = &m_recv_iov[i];
+            m_recv_msg[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    //! @brief Deleted copy constructor.
+    udp_transceiver(udp_transceiver const&) = delete;
+
+    //! @brief Destructor closing the socket.
+    ~udp_transceiver() {
+        ::close(m_socket);
+    }
+
+    //! @brief Broadcasts a message after given failed attempts, returning whether it succeeded.
+    bool send(device_t uid, std::vector<char> const& m, int attempt) {
+        m_uid = uid;
+        if (attempt == 0) ++m_seq;
+        size_t payload = data.datagram_size - header_size;
+        size_t n = std::max<size_t>((m.size() + payload - 1) / payload, 1);
+        if (n > UINT16_MAX or m.size() > UINT32_MAX) {
+            ++m_dropped;
+            return true; // retrying would never succeed
+        }
+        m_headers.resize(n);
+        m_send_iov.resize(2 * n);
+        m_send_msg.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            header_type h{uid, uint32_t(m.size()), uint32_t(i * payload), m_seq, uint16_t(i), uint16_t(n)};
+            h.write(m_headers[i].data());
+            m_send_iov[2*i].iov_base = m_headers[i].data();
+            m_send_iov[2*i].iov_len = header_size;
+            m_send_iov[2*i+1].iov_base = const_cast<char*>(m.data()) + h.offset;
+            m_send_iov[2*i+1].iov_len = std::min(payload, m.size() - h.offset);
+            std::memset(&m_send_msg[i], 0, sizeof(mmsghdr));
+            m_send_msg[i].msg_hdr.msg_name = &m_target;
+            m_send_msg[i].msg_hdr.msg_namelen = sizeof(m_target);
+            m_send_msg[i].msg_hdr.msg_iov = &m_send_iov[2*i];
+            m_send_msg[i].msg_hdr.msg_iovlen = 2;
+        }
+        size_t sent = 0;
+        while (sent < n) {
+            int r = ::sendmmsg(m_socket, m_send_msg.data() + sent, n - sent, 0);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            sent += r;
+        }
+        return true;
+    }
+
+    //! @brief Listens for messages after given failed sends.
+    message_type receive(int) {
+        if (m_ready.empty() and fetch() == 0 and data.timeout > 0) {
+            pollfd p{m_socket, POLLIN, 0};
+            if (::poll(&p, 1, data.timeout) > 0) fetch();
+        }
+        message_type m;
+        if (not m_ready.empty()) {
+            m = std::move(m_ready.front());
+            m_ready.pop_front();
+        }
+        return m;
+    }
+
+    //! @brief Number of messages discarded as too large to be sent.
+    size_t dropped() const {
+        return m_dropped;
+    }
+
+  private:
+    //! @brief Header preceding the content of every datagram.
+    struct header_type {
+        //! @brief The identifier of the sender.
+        device_t uid;
+        //! @brief The total size of the message.
+        uint32_t total;
+        //! @brief The position of the fragment within the message.
+        uint32_t offset;
+        //! @brief The sequence number of the message.
+        uint16_t seq;
+        //! @brief The index of the fragment.
+        uint16_t index;
+        //! @brief The number of fragments of the message.
+        uint16_t count;
+
+        //! @brief Writes the header in network byte order (the identifier takes 8 bytes).
+        void write(char* p) const {
+            put(p, uint64_t(uid));
+            put(p + 8, total);
+            put(p + 12, offset);
+            put(p + 16, seq);
+            put(p + 18, index);
+            put(p + 20, count);
+        }
+
+        //! @brief Reads a header in network byte order.
+        static header_type read(char const* p) {
+            return {device_t(get<uint64_t>(p)), get<uint32_t>(p + 8), get<uint32_t>(p + 12), get<uint16_t>(p + 16), get<uint16_t>(p + 18), get<uint16_t>(p + 20)};
+        }
+
+        //! @brief Writes an unsigned integer in network byte order (most significant byte first).
+        template <typename I>
+        static void put(char* p, I x) {
+            for (size_t i = sizeof(I); i-- > 0; x >>= 8) p[i] = char(x & 0xFF);
+        }
+
+        //! @brief Reads an unsigned integer in network byte order (most significant byte first).
+        template <typename I>
+        static I get(char const* p) {
+            I x = 0;
+            for (size_t i = 0; i < sizeof(I); ++i) x = I(x << 8) | (unsigned char)p[i];
+            return x;
+        }
+    };
+
+    //! @brief A message being reassembled from its fragments.
+    struct partial_type {
+        //! @brief The sequence number of the message.
+        uint16_t seq;
+        //! @brief The number of fragments still missing.
+        uint16_t missing;
+        //! @brief Which fragments have been received.
+        std::vector<bool> received;
+        //! @brief The content of the message.
+        std::vector<char> content;
+    };
+
+    //! @brief Throws an exception for a failed system call.
+    [[noreturn]] void fail(char const* what) {
+        std::string e = std::string("udp_transceiver: ") + what + " failed: " + std::strerror(errno);
+        if (m_socket >= 0) ::close(m_socket);
+        throw std::runtime_error(e);
+    }
+
+    //! @brief Reads the datagrams available, returning their number.
+    size_t fetch() {
+        int r;
+        do r = ::recvmmsg(m_socket, m_recv_msg.data(), m_recv_msg.size(), MSG_DONTWAIT, nullptr);
+        while (r < 0 and errno == EINTR);
+        if (r <= 0) return 0;
+        for (int i = 0; i < r; ++i) {
+            char const* p = static_cast<char const*>(m_recv_iov[i].iov_base);
+            size_t l = m_recv_msg[i].msg_len;
+            if (l < header_size) continue;
+            header_type h = header_type::read(p);
+            p += header_size;
+            l -= header_size;
+            if (h.uid == m_uid or h.index >= h.count or h.offset + l > h.total) continue;
+            if (h.count == 1) {
+                m_ready.push_back({0, h.uid, data.power, std::vector<char>(p, p + l)});
+                continue;
+            }
+            partial_type& q = m_partial[h.uid];
+            if (q.content.size() != h.total or q.seq != h.seq or q.received.size() != h.count) {
+                q.seq = h.seq;
+                q.missing = h.count;
+                q.received.assign(h.count, false);
+                q.content.resize(h.total);
+            }
+            if (q.received[h.index]) continue;
+            q.received[h.index] = true;
+            std::memcpy(q.content.data() + h.offset, p, l);
+            if (--q.missing == 0) {
+                m_ready.push_back({0, h.uid, data.power, std::move(q.content)});
+                m_partial.erase(h.uid);
+            }
+        }
+        return r;
+    }
+
+    //! @brief The socket descriptor.
+    int m_socket = -1;
+
+    //! @brief The destination address.
+    sockaddr_in m_target;
+
+    //! @brief The identifier of the device (learnt at the first send).
+    device_t m_uid = device_t(-1);
+
+    //! @brief The sequence number of the last message sent.
+    uint16_t m_seq = 0;
+
+    //! @brief Number of messages discarded as too large to be sent.
+    size_t m_dropped = 0;
+
+    //! @brief Headers of the fragments being sent (in network byte order).
+    std::vector<std::array<char, header_size>> m_headers;
+
+    //! @brief Scatter/gather vectors of the fragments being sent.
+    std::vector<iovec> m_send_iov;
+
+    //! @brief Descriptors of the fragments being sent.
+    std::vector<mmsghdr> m_send_msg;
+
+    //! @brief Buffer for datagrams received.
+    std::vector<char> m_buffer;
+
+    //! @brief Scatter/gather vectors of the datagrams received.
+    std::vector<iovec> m_recv_iov;
+
+    //! @brief Descriptors of the datagrams received.
+    std::vector<mmsghdr> m_recv_msg;
+
+    //! @brief Messages being reassembled, by sender.
+    std::unordered_map<device_t, partial_type> m_partial;
+
+    //! @brief Messages received and not yet returned.
+    std::deque<message_type> m_ready;
+};
+
+
+}
+
+
+}
+
+#endif // __linux__
+
+#endif // FCPP_DEPLOYMENT_UDP_TRANSCEIVER_H_
@@ -9,7 +9,9 @@
 #define FCPP_INTERNAL_H_
 
 #include "lib/internal/context.hpp"
+#include "lib/internal/export_codec.hpp"
 #include "lib/internal/flat_ptr.hpp"
+#include "lib/internal/recycler.hpp"
 #include "lib/internal/trace.hpp"
 #include "lib/internal/twin.hpp"
 
@@ -9,12 +9,16 @@
 #define FCPP_INTERNAL_CONTEXT_H_
 
 #include <algorithm>
+#include <cassert>
+#include <limits>
 #include <ostream>
-#include <queue>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "lib/common/flat_multitype_map.hpp"
 #include "lib/common/multitype_map.hpp"
 #include "lib/data/field.hpp"
 #include "lib/internal/flat_ptr.hpp"
@@ -42,6 +46,218 @@ class sstream;
 namespace internal {
 
 
+//! @cond INTERNAL
+namespace details {
+    /**
+     * @brief Inverted index of neighbours' exports by trace (disabled form).
+     *
+     * Never reports itself as built, so that queries are never redirected to it.
+     */
+    template <bool enabled, typename... Ts>
+    class export_index {
+      public:
+        //! @brief Whether the index has been built.
+        constexpr bool built() const {
+            return false;
+        }
+
+        //! @brief Empties the index.
+        void clear() {}
+
+        //! @brief Adds the export of a device to the index.
+        template <typename E>
+        void insert(device_t, E const&) {}
+
+        //! @brief Finalises the index after every export has been added.
+        void sort() {}
+
+        //! @brief Returns neighbours' values for a certain trace (never called).
+        template <typename A>
+        to_field<A> nbr(trace_t, A const&, device_t) const {
+            assert(false);
+            return {};
+        }
+
+        //! @brief Returns list of devices with specified trace (never called).
+        std::vector<device_t> align(trace_t, device_t) const {
+            assert(false);
+            return {};
+        }
+    };
+
+    /**
+     * @brief Inverted index of neighbours' exports by trace (enabled form).
+     *
+     * For every value type (and for void keys), holds an array of `(trace, device, value pointer)`
+     * entries sorted by trace and device, so that gathering the values for a trace from all neighbours
+     * is a single binary search followed by a linear copy. The index points into the exports
+     * of the context owning it, so it is built at every `freeze` and cleared at every `unfreeze`.
+     * Copies of an index are not built (and queries fall back to scanning exports).
+     */
+    template <typename... Ts>
+    class export_index<true, Ts...> {
+        //! @brief Checks whether a type is supported by the index.
+        template <typename A>
+        constexpr static bool type_supported = common::type_count<std::remove_reference_t<A>, Ts...> != 0;
+
+        //! @brief The type of index entries for a value type.
+        template <typename A>
+        using entry_type = std::tuple<trace_t, device_t, A const*>;
+
+        //! @brief List of value types (without repetitions).
+        using value_types = common::type_uniq<Ts...>;
+
+        //! @brief List of entry arrays types (without repetitions).
+        using entries_types = common::type_uniq<std::vector<entry_type<Ts>>...>;
+
+      public:
+        //! @brief Default constructor.
+        export_index() = default;
+
+        //! @brief Copy constructor (the copy is not built).
+        export_index(export_index const&) {}
+
+        //! @brief Move constructor.
+        export_index(export_index&&) = default;
+
+        //! @brief Copy assignment (the copy is not built).
+        export_index& operator=(export_index const&) {
+            clear();
+            return *this;
+        }
+
+        //! @brief Move assignment.
+        export_index& operator=(export_index&&) = default;
+
+        //! @brief Whether the index has been built.
+        bool built() const {
+            return m_built;
+        }
+
+        //! @brief Empties the index (keeping the allocated memory).
+        void clear() {
+            m_built = false;
+            m_keys.clear();
+            clear_entries(value_types{});
+        }
+
+        //! @brief Adds the export of a device to the index (devices are expected in increasing order).
+        template <typename E>
+        void insert(device_t d, E const& e) {
+            e.for_each_key([this,d](trace_t t){
+                m_keys.emplace_back(t, d);
+            });
+            insert_entries(d, e, value_types{});
+        }
+
+        //! @brief Finalises the index after every export has been added.
+        void sort() {
+            std::sort(m_keys.begin(), m_keys.end());
+            sort_entries(value_types{});
+            m_built = true;
+        }
+
+        //! @brief Returns neighbours' values for a certain trace (default from `def`, and also self if not present).
+        template <typename A>
+        to_field<A> nbr(trace_t trace, A const& def, device_t self) const {
+            return nbr(trace, def, self, common::number_sequence<type_supported<A>>{});
+        }
+
+        //! @brief Returns list of devices with specified trace.
+        std::vector<device_t> align(trace_t trace, device_t self) const {
+            assert(m_built);
+            auto it = std::lower_bound(m_keys.begin(), m_keys.end(), std::make_pair(trace, device_t(0)));
+            auto end = std::upper_bound(it, m_keys.end(), std::make_pair(trace, std::numeric_limits<device_t>::max()));
+            std::vector<device_t> v;
+            v.reserve(end - it + 1);
+            for (; it != m_keys.end() and it->first == trace and it->second < self; ++it)
+                v.push_back(it->second);
+            v.push_back(self);
+            if (it != m_keys.end() and it->first == trace and it->second == self) ++it;
+            for (; it != m_keys.end() and it->first == trace; ++it)
+                v.push_back(it->second);
+            return v;
+        }
+
+      private:
+        //! @brief Returns neighbours' values for a certain trace (unsupported type).
+        template <typename A>
+        to_field<A> nbr(trace_t, A const& def, device_t, common::number_sequence<false>) const {
+            std::vector<to_local<A>> vals;
+            vals.push_back(fcpp::details::other(def));
+            return fcpp::details::make_field(std::vector<device_t>{}, std::move(vals));
+        }
+
+        //! @brief Returns neighbours' values for a certain trace (supported type).
+        template <typename A>
+        to_field<A> nbr(trace_t trace, A const& def, device_t self, common::number_sequence<true>) const {
+            assert(m_built);
+            auto const& v = common::get<std::remove_reference_t<A>>(m_entries);
+            auto it = std::lower_bound(v.begin(), v.end(), trace, [](entry_type<A> const& x, trace_t t) {
+                return std::get<0>(x) < t;
+            });
+            auto end = it;
+            while (end != v.end() and std::get<0>(*end) == trace) ++end;
+            std::vector<device_t> ids;
+            std::vector<to_local<A>> vals;
+            ids.reserve(end - it);
+            vals.reserve(end - it + 1);
+            vals.push_back(fcpp::details::other(def));
+            for (; it != end; ++it) {
+                ids.push_back(std::get<1>(*it));
+                vals.push_back(fcpp::details::self(*std::get<2>(*it), self));
+            }
+            return fcpp::details::make_field(std::move(ids), std::move(vals));
+        }
+
+        //! @brief Empties the entry arrays (empty form).
+        inline void clear_entries(common::type_sequence<>) {}
+
+        //! @brief Empties the entry arrays (active form).
+        template <typename S, typename... Ss>
+        inline void clear_entries(common::type_sequence<S, Ss...>) {
+            common::get<S>(m_entries).clear();
+            clear_entries(common::type_sequence<Ss...>{});
+        }
+
+        //! @brief Adds the values of an export to the entry arrays (empty form).
+        template <typename E>
+        inline void insert_entries(device_t, E const&, common::type_sequence<>) {}
+
+        //! @brief Adds the values of an export to the entry arrays (active form).
+        template <typename E, typename S, typename... Ss>
+        inline void insert_entries(device_t d, E const& e, common::type_sequence<S, Ss...>) {
+            auto& v = common::get<S>(m_entries);
+            e.template for_each<S>([&v,d](trace_t t, S const& x){
+                v.emplace_back(t, d, &x);
+            });
+            insert_entries(d, e, common::type_sequence<Ss...>{});
+        }
+
+        //! @brief Sorts the entry arrays by trace and device (empty form).
+        inline void sort_entries(common::type_sequence<>) {}
+
+        //! @brief Sorts the entry arrays by trace and device (active form).
+        template <typename S, typename... Ss>
+        inline void sort_entries(common::type_sequence<S, Ss...>) {
+            auto& v = common::get<S>(m_entries);
+            std::sort(v.begin(), v.end(), [](entry_type<S> const& x, entry_type<S> const& y) {
+                return std::get<0>(x) < std::get<0>(y) or (std::get<0>(x) == std::get<0>(y) and std::get<1>(x) < std::get<1>(y));
+            });
+            sort_entries(common::type_sequence<Ss...>{});
+        }
+
+        //! @brief Whether the index reflects the current exports.
+        bool m_built = false;
+        //! @brief Sorted pairs of void keys and devices.
+        std::vector<std::pair<trace_t, device_t>> m_keys;
+        //! @brief Sorted entry arrays for each value type.
+        common::tagged_tuple<value_types, entries_types> m_entries;
+    };
+}
+//! @endcond
+
+
 /**
  * @brief Keeps associations between devices and export received.
  *
@@ -50,10 +266,12 @@ namespace internal {
  *
  * @param online Whether the number of stored exports should be kept cleaned as exports are inserted.
  * @param pointer Whether the exports should be stored in pointers or not.
+ * @param flat Whether the exports should be stored in flat arrays (@ref common::flat_multitype_map) or hash maps (@ref common::multitype_map).
+ * @param indexed Whether an inverted index of exports by trace should be built on freezing (speeding up `nbr` and `align` on large neighbourhoods).
  * @param M Type of the export metrics.
  * @param Ts Types included in the exports.
  */
-template <bool online, bool pointer, typename M, typename... Ts>
+template <bool online, bool pointer, bool flat, bool indexed, typename M, typename... Ts>
 class context;
 
 
@@ -62,11 +280,11 @@ class context;
  *
  * Specialisation for online cleaning of export as they are inserted.
  */
-template <bool pointer, typename M, typename... Ts>
-class context<true, pointer, M, Ts...> {
+template <bool pointer, bool flat, bool indexed, typename M, typename... Ts>
+class context<true, pointer, flat, indexed, M, Ts...> {
   public:
     //! @brief The type of the exports contained in the context.
-    typedef internal::flat_ptr<common::multitype_map<trace_t, Ts...>, not pointer> export_type;
+    typedef internal::flat_ptr<std::conditional_t<flat, common::flat_multitype_map<trace_t, Ts...>, common::multitype_map<trace_t, Ts...>>, not pointer> export_type;
 
     //! @brief The type of the metric on exports.
     typedef M metric_type;
@@ -88,75 +306,106 @@ class context<true, pointer, M, Ts...> {
 
     //! @brief Equality operator.
     bool operator==(context const& o) const {
-        return m_data == o.m_data && m_metrics == o.m_metrics;
+        if (m_heap.size() != o.m_heap.size()) return false;
+        for (data_type const& x : m_heap) {
+            auto it = o.m_pos.find(get<1>(x));
+            if (it == o.m_pos.end()) return false;
+            data_type const& y = o.m_heap[it->second];
+            if (get<0>(x) != get<0>(y) or not (get<2>(x) == get<2>(y))) return false;
+        }
+        return true;
     }
 
     //! @brief Number of exports contained.
     size_t size(device_t self) const {
-        return m_data.size() + 1-m_data.count(self);
+        return m_heap.size() + 1-m_pos.count(self);
+    }
+
+    //! @brief Whether an export for a device with a certain metric would be kept by `insert`.
+    bool accepts(device_t d, metric_type m, metric_type threshold, device_t hoodsize) const {
+        if (not (m <= threshold)) return false;
+        if (m_pos.count(d) or m_heap.size() < hoodsize) return true;
+        if (m_heap.empty()) return false;
+        data_type const& w = m_heap.front();
+        return get<0>(w) != m ? m < get<0>(w) : d < get<1>(w);
     }
 
     //! @brief Inserts an export for a device with a certain metric, possibly cleaning up.
     void insert(device_t d, export_type e, metric_type m, metric_type threshold, device_t hoodsize) {
         assert(m_sorted_data.size() == 0);
         if (m <= threshold) {
-            if (m_metrics.count(d) == 0 or m_metrics[d] != m)
-                m_queue.emplace(m, d);
-            m_metrics[d] = m;
-            m_data[d] = std::move(e);
-            if (m_data.size() > hoodsize) pop();
-            else clean();
+            auto it = m_pos.find(d);
+            if (it == m_pos.end() and m_heap.size() < hoodsize) {
+                m_heap.emplace_back(m, d, std::move(e));
+                sift_up(m_heap.size()-1);
+            } else if (it == m_pos.end()) {
+                // full context: the new export replaces the worst one, unless it is worse
+                data_type x(m, d, std::move(e));
+                if (m_heap.empty() or above(x, m_heap.front())) return;
+                m_pos.erase(get<1>(m_heap.front()));
+                m_heap.front() = std::move(x);
+                sift_down(0);
+            } else {
+                size_t i = it->second;
+                get<2>(m_heap[i]) = std::move(e);
+                if (get<0>(m_heap[i]) != m) {
+                    bool up = get<0>(m_heap[i]) < m;
+                    get<0>(m_heap[i]) = m;
+                    if (up) sift_up(i);
+                    else sift_down(i);
+                }
+            }
         }
     }
 
     //! @brief The worst export currently in context.
     device_t top() {
         assert(m_sorted_data.size() == 0);
-        clean();
-        return m_queue.top().second;
+        return get<1>(m_heap.front());
     }
 
     //! @brief Erases the worst export.
     void pop() {
         assert(m_sorted_data.size() == 0);
-        clean();
-        m_data.erase(m_queue.top().second);
-        m_metrics.erase(m_queue.top().second);
-        m_queue.pop();
+        erase(0);
     }
 
     //! @brief Changes the status of the context from "modify" to "query".
     void freeze(device_t, device_t) {
         assert(m_sorted_data.size() == 0);
-        for (auto const& x : m_data)
-            m_sorted_data.emplace_back(x.first, &x.second);
+        for (data_type const& x : m_heap)
+            m_sorted_data.emplace_back(get<1>(x), &get<2>(x));
         std::sort(m_sorted_data.begin(), m_sorted_data.end());
-        assert(m_sorted_data.size() == m_data.size());
+        assert(m_sorted_data.size() == m_heap.size());
+        for (auto const& x : m_sorted_data)
+            m_index.insert(x.first, **x.second);
+        m_index.sort();
     }
 
     //! @brief Changes the status of the context from "query" to "modify", updating metrics.
     template <typename N, typename T>
     void unfreeze(N const& node, T const& metric, metric_type threshold) {
-        assert(m_sorted_data.size() == m_data.size());
+        assert(m_sorted_data.size() == m_heap.size());
         m_sorted_data.clear();
-        m_queue = {};
-        for (auto it = m_metrics.begin(); it != m_metrics.end(); ) {
-            it->second = metric.update(it->second, node);
-            if (it->second > threshold) {
-                m_data.erase(it->first);
-                it = m_metrics.erase(it);
-            } else {
-                m_queue.emplace(it->second, it->first);
-                ++it;
-            }
+        m_index.clear();
+        size_t w = 0;
+        for (size_t r = 0; r < m_heap.size(); ++r) {
+            get<0>(m_heap[r]) = metric.update(get<0>(m_heap[r]), node);
+            if (get<0>(m_heap[r]) <= threshold) {
+                if (r > w) m_heap[w] = std::move(m_heap[r]);
+                ++w;
+            } else m_pos.erase(get<1>(m_heap[r]));
         }
+        m_heap.resize(w);
+        rebuild();
         assert(m_sorted_data.size() == 0);
     }
 
     //! @brief Returns list of all devices.
     std::vector<device_t> align(device_t self) const {
-        assert(m_sorted_data.size() == m_data.size());
+        assert(m_sorted_data.size() == m_heap.size());
         std::vector<device_t> v;
+        v.reserve(m_sorted_data.size() + 1);
         auto it = m_sorted_data.begin();
         for (; it != m_sorted_data.end() and it->first < self; ++it)
             v.push_back(it->first);
@@ -169,8 +418,10 @@ class context<true, pointer, M, Ts...> {
 
     //! @brief Returns list of devices with specified trace.
     std::vector<device_t> align(trace_t trace, device_t self) const {
-        assert(m_sorted_data.size() == m_data.size());
+        assert(m_sorted_data.size() == m_heap.size());
+        if (m_index.built()) return m_index.align(trace, self);
         std::vector<device_t> v;
+        v.reserve(m_sorted_data.size() + 1);
         auto it = m_sorted_data.begin();
         for (; it != m_sorted_data.end() and it->first < self; ++it)
             if ((*(it->second))->contains(trace)) {
@@ -188,18 +439,22 @@ class context<true, pointer, M, Ts...> {
     //! @brief Returns the old value for a certain trace (unaligned).
     template <typename A>
     A const& old(trace_t trace, A const& def, device_t self) const {
-        assert(m_sorted_data.size() == m_data.size() or m_data.size() == 1);
-        if (m_data.count(self) and m_data.at(self)->template count<A>(trace))
-            return m_data.at(self)->template at<A>(trace);
+        assert(m_sorted_data.size() == m_heap.size() or m_heap.size() == 1);
+        auto it = m_pos.find(self);
+        if (it != m_pos.end() and get<2>(m_heap[it->second])->template count<A>(trace))
+            return get<2>(m_heap[it->second])->template at<A>(trace);
         return def;
     }
 
     //! @brief Returns neighbours' values for a certain trace (default from `def`, and also self if not present).
     template <typename A>
     to_field<A> nbr(trace_t trace, A const& def, device_t self) const {
-        assert(m_sorted_data.size() == m_data.size());
+        assert(m_sorted_data.size() == m_heap.size());
+        if (m_index.built()) return m_index.nbr(trace, def, self);
         std::vector<device_t> ids;
         std::vector<to_local<A>> vals;
+        ids.reserve(m_sorted_data.size());
+        vals.reserve(m_sorted_data.size() + 1);
         vals.push_back(fcpp::details::other(def));
         for (auto const& x : m_sorted_data)
             if ((*x.second)->template count<A>(trace)) {
@@ -213,42 +468,93 @@ class context<true, pointer, M, Ts...> {
     template <typename O>
     void print(O& o) const {
         bool first = true;
-        for (auto const& x : m_metrics) {
+        for (data_type const& x : m_heap) {
             if (first) first = false;
             else o << ", ";
-            o << x.first << ":" << m_data.at(x.first) << "@" << 0+x.second;
+            o << get<1>(x) << ":" << get<2>(x) << "@" << 0+get<0>(x);
         }
     }
 
     //! @brief Serialises the content from/to a given input/output stream.
     common::sstream<false>& serialize(common::sstream<false>& s) {
-        s >> m_data >> m_metrics;
+        s >> m_heap;
         m_sorted_data.clear();
-        for (auto const& x : m_metrics)
-            m_queue.emplace(x.second, x.first);
+        m_index.clear();
+        m_pos.clear();
+        rebuild();
         return s;
     }
 
     //! @brief Serialises the content from/to a given input/output stream (const overload).
     common::sstream<true>& serialize(common::sstream<true>& s) const {
-        return s << m_data << m_metrics;
+        return s << m_heap;
     }
 
   private:
-    //! @brief Erases invalid values from the queue.
-    void clean() {
-        while (m_metrics.count(m_queue.top().second) == 0 or m_metrics.at(m_queue.top().second) != m_queue.top().first)
-            m_queue.pop();
-    }
-
-    //! @brief Map associating devices to exports.
-    std::unordered_map<device_t, export_type> m_data;
-    //! @brief Map associating devices to metric results.
-    std::unordered_map<device_t, metric_type> m_metrics;
-    //! @brief Exports ordered by metric results.
-    std::priority_queue<std::pair<metric_type, device_t>> m_queue;
+    //! @brief The type of elements stored.
+    using data_type = std::tuple<metric_type, device_t, export_type>;
+
+    //! @brief Whether an element should stay above another in the heap (worst metric first).
+    static inline bool above(data_type const& x, data_type const& y) {
+        if (get<0>(x) != get<0>(y)) return get<0>(y) < get<0>(x);
+        return get<1>(y) < get<1>(x);
+    }
+
+    //! @brief Moves an element into a position of the heap, keeping positions updated.
+    inline void place(size_t i, data_type&& x) {
+        m_heap[i] = std::move(x);
+        m_pos[get<1>(m_heap[i])] = i;
+    }
+
+    //! @brief Moves an element up the heap until in place.
+    void sift_up(size_t i) {
+        data_type x = std::move(m_heap[i]);
+        for (; i > 0 and above(x, m_heap[(i-1)/2]); i = (i-1)/2)
+            place(i, std::move(m_heap[(i-1)/2]));
+        place(i, std::move(x));
+    }
+
+    //! @brief Moves an element down the heap until in place.
+    void sift_down(size_t i) {
+        data_type x = std::move(m_heap[i]);
+        while (2*i+1 < m_heap.size()) {
+            size_t j = 2*i+1;
+            if (j+1 < m_heap.size() and above(m_heap[j+1], m_heap[j])) ++j;
+            if (not above(m_heap[j], x)) break;
+            place(i, std::move(m_heap[j]));
+            i = j;
+        }
+        place(i, std::move(x));
+    }
+
+    //! @brief Erases the element at a position of the heap.
+    void erase(size_t i) {
+        m_pos.erase(get<1>(m_heap[i]));
+        if (i+1 < m_heap.size()) {
+            m_heap[i] = std::move(m_heap.back());
+            m_heap.pop_back();
+            if (i > 0 and above(m_heap[i], m_heap[(i-1)/2])) sift_up(i);
+            else sift_down(i);
+        } else m_heap.pop_back();
+    }
+
+    //! @brief Restores the heap property and positions after arbitrary metric changes (in linear time).
+    void rebuild() {
+        std::make_heap(m_heap.begin(), m_heap.end(), [](data_type const& x, data_type const& y){
+            return above(y, x);
+        });
+        for (size_t i = 0; i < m_heap.size(); ++i)
+            m_pos[get<1>(m_heap[i])] = i;
+    }
+
+    //! @brief Exports as a binary heap by metric results (worst first).
+    std::vector<data_type> m_heap;
+    //! @brief Map associating devices to their position in the heap.
+    std::unordered_map<device_t, size_t> m_pos;
     //! @brief Exports ordered by device.
     std::vector<std::pair<device_t, export_type const*>> m_sorted_data;
+    //! @brief Inverted index of exports by trace.
+    details::export_index<indexed, Ts...> m_index;
 };
 
 
@@ -257,11 +563,11 @@ class context<true, pointer, M, Ts...> {
  *
  * Specialisation for cleaning of exports only at round start.
  */
-template <bool pointer, typename M, typename... Ts>
-class context<false, pointer, M, Ts...> {
+template <bool pointer, bool flat, bool indexed, typename M, typename... Ts>
+class context<false, pointer, flat, indexed, M, Ts...> {
   public:
     //! @brief The type of the exports contained in the context.
-    typedef internal::flat_ptr<common::multitype_map<trace_t, Ts...>, not pointer> export_type;
+    typedef internal::flat_ptr<std::conditional_t<flat, common::flat_multitype_map<trace_t, Ts...>, common::multitype_map<trace_t, Ts...>>, not pointer> export_type;
 
     //! @brief The type of the metric on exports.
     typedef M metric_type;
@@ -291,6 +597,11 @@ class context<false, pointer, M, Ts...> {
         return m_data.size() + (m_self == m_data.size() or get<0>(m_data[m_self]) != self);
     }
 
+    //! @brief Whether an export for a device with a certain metric would be kept by `insert`.
+    bool accepts(device_t, metric_type m, metric_type threshold, device_t) const {
+        return m <= threshold;
+    }
+
     //! @brief Inserts an export for a device with a certain metric, possibly cleaning up.
     void insert(device_t d, export_type e, metric_type m, metric_type threshold, device_t) {
         if (m <= threshold) {
@@ -332,11 +643,15 @@ class context<false, pointer, M, Ts...> {
         m_self = std::lower_bound(m_data.begin(), m_data.end(), data_type{self, metric_type{}, export_type{}}, [](data_type const& x, data_type const& y) {
             return get<0>(x) < get<0>(y);
         }) - m_data.begin();
+        for (auto const& x : m_data)
+            m_index.insert(get<0>(x), *get<2>(x));
+        m_index.sort();
     }
 
     //! @brief Changes the status of the context from "query" to "modify", updating metrics.
     template <typename N, typename T>
     void unfreeze(N const& node, T const& metric, metric_type threshold) {
+        m_index.clear();
         size_t w = 0;
         for (size_t r = 0; r < m_data.size(); ++r) {
             get<1>(m_data[r]) = metric.update(get<1>(m_data[r]), node);
@@ -351,6 +666,7 @@ class context<false, pointer, M, Ts...> {
     //! @brief Returns list of all devices.
     std::vector<device_t> align(device_t self) const {
         std::vector<device_t> v;
+        v.reserve(m_data.size() + 1);
         size_t i = 0;
         for (; i < m_self; ++i)
             v.push_back(get<0>(m_data[i]));
@@ -363,7 +679,9 @@ class context<false, pointer, M, Ts...> {
 
     //! @brief Returns list of devices with specified trace.
     std::vector<device_t> align(trace_t trace, device_t self) const {
+        if (m_index.built()) return m_index.align(trace, self);
         std::vector<device_t> v;
+        v.reserve(m_data.size() + 1);
         size_t i = 0;
         for (; i < m_self; ++i)
             if (get<2>(m_data[i])->contains(trace))
@@ -387,8 +705,11 @@ class context<false, pointer, M, Ts...> {
     //! @brief Returns neighbours' values for a certain trace (default from `def`, and also self if not present).
     template <typename A>
     to_field<A> nbr(trace_t trace, A const& def, device_t self) const {
+        if (m_index.built()) return m_index.nbr(trace, def, self);
         std::vector<device_t> ids;
         std::vector<to_local<A>> vals;
+        ids.reserve(m_data.size());
+        vals.reserve(m_data.size() + 1);
         vals.push_back(fcpp::details::other(def));
         for (auto const& x : m_data)
             if (get<2>(x)->template count<A>(trace)) {
@@ -412,6 +733,7 @@ class context<false, pointer, M, Ts...> {
     //! @brief Serialises the content from/to a given input/output stream.
     template <typename S>
     S& serialize(S& s) {
+        m_index.clear();
         return s & m_data & m_self;
     }
 
@@ -430,26 +752,29 @@ class context<false, pointer, M, Ts...> {
 
     //! @brief Index of self in @ref m_data.
     size_t m_self;
+
+    //! @brief Inverted index of exports by trace.
+    details::export_index<indexed, Ts...> m_index;
 };
 
 
 //! @cond INTERNAL
 namespace details {
     // General form.
-    template <bool online, bool pointer, typename M, typename T>
+    template <bool online, bool pointer, bool flat, bool indexed, typename M, typename T>
     struct context_t;
 
     // Unpacking form.
-    template <bool online, bool pointer, typename M, typename... Ts>
-    struct context_t<online, pointer, M, common::type_sequence<Ts...>> {
-        using type = context<online, pointer, M, Ts...>;
+    template <bool online, bool pointer, bool flat, bool indexed, typename M, typename... Ts>
+    struct context_t<online, pointer, flat, indexed, M, common::type_sequence<Ts...>> {
+        using type = context<online, pointer, flat, indexed, M, Ts...>;
     };
 }
 //! @endcond
 
 //! @brief Context built with a type sequence of types.
-template <bool online, bool pointer, typename M, typename T>
-using context_t = typename details::context_t<online,pointer,M,T>::type;
+template <bool online, bool pointer, bool flat, bool indexed, typename M, typename T>
+using context_t = typename details::context_t<online,pointer,flat,indexed,M,T>::type;
 
 
 }
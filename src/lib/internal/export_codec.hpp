@@ -0,0 +1,396 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file export_codec.hpp
+ * @brief Implementation of the `export_codec<E, period>` class template for delta-encoding exports in messages.
+ */
+
+#ifndef FCPP_INTERNAL_EXPORT_CODEC_H_
+#define FCPP_INTERNAL_EXPORT_CODEC_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "lib/settings.hpp"
+#include "lib/common/serialize.hpp"
+#include "lib/common/traits.hpp"
+#include "lib/internal/trace.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Namespace containing objects of internal use.
+namespace internal {
+
+
+/**
+ * @brief Difference between consecutive exports of a device, as sent in messages.
+ *
+ * A delta with sequence number `n` applies to the export with sequence number `n-1`, unless it is a keyframe
+ * (sharing the whole export). Traces listed as removed are erased for every type, and every current entry
+ * for such traces is included among the values.
+ *
+ * @param E The export type (a @ref flat_ptr to a multitype map).
+ */
+template <typename E>
+class export_delta {
+  public:
+    //! @brief The type of the exports.
+    typedef E export_type;
+
+    //! @brief The type of the export maps.
+    typedef typename E::value_type map_type;
+
+    //! @brief Default constructor (creating an empty keyframe).
+    export_delta() = default;
+
+    //! @brief Equality operator.
+    bool operator==(export_delta const& o) const {
+        return m_seq == o.m_seq and m_keyframe == o.m_keyframe and m_removed == o.m_removed and values() == o.values();
+    }
+
+    //! @brief Sequence number of the export.
+    uint32_t seq() const {
+        return m_seq;
+    }
+
+    //! @brief Whether the delta contains the whole export.
+    bool keyframe() const {
+        return m_keyframe;
+    }
+
+    //! @brief Traces removed since the previous export (sorted).
+    std::vector<trace_t> const& removed() const {
+        return m_removed;
+    }
+
+    //! @brief Entries added or changed since the previous export (the whole export for keyframes).
+    map_type const& values() const {
+        return m_keyframe ? *m_frame : m_values;
+    }
+
+    //! @brief The whole export (for keyframes).
+    E const& frame() const {
+        assert(m_keyframe);
+        return m_frame;
+    }
+
+    //! @brief Builds the delta between two consecutive exports.
+    void encode(uint32_t seq, map_type const& prev, map_type const& curr) {
+        common::osstream lhs, rhs;
+        encode(seq, prev, curr, lhs, rhs);
+    }
+
+    //! @brief Builds the delta between two consecutive exports, given buffers for comparing serialisations of values.
+    void encode(uint32_t seq, map_type const& prev, map_type const& curr, common::osstream& lhs, common::osstream& rhs) {
+        m_seq = seq;
+        m_keyframe = false;
+        m_removed.clear();
+        m_values = map_type{};
+        prev.for_each_key([&](trace_t t){
+            if (not curr.contains(t)) m_removed.push_back(t);
+        });
+        find_removed(prev, curr, typename map_type::value_types{});
+        std::sort(m_removed.begin(), m_removed.end());
+        m_removed.erase(std::unique(m_removed.begin(), m_removed.end()), m_removed.end());
+        curr.for_each_key([&](trace_t t){
+            if (not prev.contains(t) or is_removed(t)) m_values.insert(t);
+        });
+        find_changed(prev, curr, lhs, rhs, typename map_type::value_types{});
+        compact(m_values, 0);
+    }
+
+    //! @brief Builds a keyframe sharing the whole current export.
+    void encode(uint32_t seq, E const& curr) {
+        m_seq = seq;
+        m_keyframe = true;
+        m_removed.clear();
+        m_values = map_type{};
+        m_frame = curr;
+    }
+
+    //! @brief Applies the delta to the previous export.
+    void patch(map_type& prev) const {
+        assert(not m_keyframe);
+        for (trace_t t : m_removed) {
+            prev.remove(t);
+            erase_all(prev, t, typename map_type::value_types{});
+        }
+        m_values.for_each_key([&](trace_t t){
+            prev.insert(t);
+        });
+        insert_all(prev, typename map_type::value_types{});
+        compact(prev, 0);
+    }
+
+    //! @brief Serialises the content from/to a given input/output stream.
+    template <typename S>
+    S& serialize(S& s) {
+        s & m_seq & m_keyframe & m_removed;
+        return m_keyframe ? s & m_frame : s & m_values;
+    }
+
+    //! @brief Serialises the content from/to a given input/output stream (const overload).
+    template <typename S>
+    S& serialize(S& s) const {
+        s << m_seq << m_keyframe << m_removed;
+        return m_keyframe ? s << m_frame : s << m_values;
+    }
+
+  private:
+    //! @brief Compacts a map after insertions (for maps supporting it).
+    template <typename M>
+    static inline auto compact(M& m, int) -> decltype(m.compact()) {
+        m.compact();
+    }
+
+    //! @brief Compacts a map after insertions (for maps not supporting it).
+    template <typename M>
+    static inline void compact(M&, long) {}
+
+    //! @brief Whether a trace is among the removed ones.
+    inline bool is_removed(trace_t t) const {
+        return std::binary_search(m_removed.begin(), m_removed.end(), t);
+    }
+
+    //! @brief Collects traces missing from the current export (empty form).
+    inline void find_removed(map_type const&, map_type const&, common::type_sequence<>) {}
+
+    //! @brief Collects traces missing from the current export (active form).
+    template <typename A, typename... As>
+    inline void find_removed(map_type const& prev, map_type const& curr, common::type_sequence<A, As...>) {
+        prev.template for_each<A>([&](trace_t t, A const&){
+            if (not curr.template count<A>(t)) m_removed.push_back(t);
+        });
+        find_removed(prev, curr, common::type_sequence<As...>{});
+    }
+
+    //! @brief Collects entries added or changed in the current export (empty form).
+    inline void find_changed(map_type const&, map_type const&, common::osstream&, common::osstream&, common::type_sequence<>) {}
+
+    //! @brief Collects entries added or changed in the current export (active form).
+    template <typename A, typename... As>
+    inline void find_changed(map_type const& prev, map_type const& curr, common::osstream& lhs, common::osstream& rhs, common::type_sequence<A, As...>) {
+        curr.template for_each<A>([&](trace_t t, A const& x){
+            if (not prev.template count<A>(t) or not identical(prev.template at<A>(t), x, lhs, rhs) or is_removed(t))
+                m_values.template insert<A>(t, x);
+        });
+        find_changed(prev, curr, lhs, rhs, common::type_sequence<As...>{});
+    }
+
+    //! @brief Whether two arithmetic values are identical.
+    template <typename A>
+    static inline std::enable_if_t<std::is_arithmetic<A>::value, bool> identical(A const& x, A const& y, common::osstream&, common::osstream&) {
+        return x == y;
+    }
+
+    //! @brief Whether two values are identical, comparing their serialisations (as `==` may be pointwise, e.g. on fields).
+    template <typename A>
+    static inline std::enable_if_t<not std::is_arithmetic<A>::value, bool> identical(A const& x, A const& y, common::osstream& lhs, common::osstream& rhs) {
+        lhs << x;
+        rhs << y;
+        bool same = lhs.data() == rhs.data();
+        lhs.clear();
+        rhs.clear();
+        return same;
+    }
+
+    //! @brief Erases a trace for every type (empty form).
+    static inline void erase_all(map_type&, trace_t, common::type_sequence<>) {}
+
+    //! @brief Erases a trace for every type (active form).
+    template <typename A, typename... As>
+    static inline void erase_all(map_type& m, trace_t t, common::type_sequence<A, As...>) {
+        m.template erase<A>(t);
+        erase_all(m, t, common::type_sequence<As...>{});
+    }
+
+    //! @brief Inserts the delta values overwriting existing ones (empty form).
+    inline void insert_all(map_type&, common::type_sequence<>) const {}
+
+    //! @brief Inserts the delta values overwriting existing ones (active form).
+    template <typename A, typename... As>
+    inline void insert_all(map_type& m, common::type_sequence<A, As...>) const {
+        m_values.template for_each<A>([&](trace_t t, A const& x){
+            m.template insert<A>(t, x);
+        });
+        insert_all(m, common::type_sequence<As...>{});
+    }
+
+    //! @brief Sequence number of the export.
+    uint32_t m_seq = 0;
+    //! @brief Whether the delta contains the whole export.
+    bool m_keyframe = true;
+    //! @brief Traces removed since the previous export.
+    std::vector<trace_t> m_removed;
+    //! @brief Entries added or changed since the previous export.
+    map_type m_values;
+    //! @brief The whole export (for keyframes).
+    E m_frame;
+};
+
+
+/**
+ * @brief Class converting exports into messages and back.
+ *
+ * With a positive `period`, messages carry an @ref export_delta from the previous export of the sender,
+ * with a keyframe every `period` exports. Receivers patch the last export they decoded from the sender,
+ * discarding deltas which do not apply to it (e.g. after a message loss) until the next keyframe.
+ * The export of a sender is forgotten once no message has come from it for `period` times the interval
+ * between its last two messages, so that senders slower than the receiver keep their exports.
+ * Non-arithmetic values are compared through their serialisations, so that a field is unchanged
+ * only if its whole content is: export types need to be serialisable, and both sides of every
+ * non-arithmetic entry are serialised on every export.
+ *
+ * Keyframes share the export of the sender, which receivers copy once before patching it.
+ * Later deltas of messages that are accepted patch the decoded export in place: the export previously
+ * returned for the sender is updated as well, hence its holders (e.g. the neighbours' context) see the
+ * newest export. Deltas of rejected messages patch a copy, leaving the previous export to its holders.
+ *
+ * @param E The export type (a @ref flat_ptr to a multitype map).
+ * @param period The number of exports between keyframes (zero for sending whole exports).
+ */
+template <typename E, intmax_t period>
+class export_codec {
+    static_assert(period > 0, "the keyframe period of delta exports cannot be negative");
+
+  public:
+    //! @brief The type of the exports.
+    typedef E export_type;
+
+    //! @brief The type of messages.
+    typedef export_delta<E> message_type;
+
+    //! @brief Updates the message to be sent with a new export.
+    void encode(E const& e) {
+        ++m_seq;
+        if ((m_seq - 1) % period == 0) m_delta.encode(m_seq, e);
+        else m_delta.encode(m_seq, *m_prev, *e, m_lhs, m_rhs);
+        m_prev = e;
+    }
+
+    //! @brief The message to be sent for an export (which should be the last encoded).
+    message_type const& message(E const&) const {
+        return m_delta;
+    }
+
+    /**
+     * @brief Decodes a message from a device sent at time `t`, returning the export (or `nullptr` if the message cannot be decoded).
+     *
+     * If `accept` is false, the message is not going to be stored by the caller: the export previously
+     * returned for the device is then left unchanged.
+     */
+    E const* decode(device_t d, message_type const& m, times_t t, bool accept = true) {
+        auto it = m_bases.find(d);
+        if (it == m_bases.end()) it = m_bases.emplace(d, base_type{}).first;
+        base_type& b = it->second;
+        if (b.time < t) {
+            b.gap = t - b.time;
+            m_gap = std::max(m_gap, b.gap);
+        }
+        b.time = t;
+        if (m.keyframe()) {
+            b.data = m.frame();
+            b.valid = true;
+            b.owned = false;
+        } else if (not b.valid) {
+            return nullptr;
+        } else if (b.seq + 1 == m.seq()) {
+            // keyframes may be shared with the sender, and exports of previous messages with their holders
+            if (not b.data.unique() and not (b.owned and accept)) b.data = E(*b.data);
+            b.owned = true;
+            m.patch(*b.data);
+        } else if (b.seq != m.seq()) {
+            // a message has been lost, so deltas do not apply until the next keyframe
+            b.valid = false;
+            return nullptr;
+        }
+        b.seq = m.seq();
+        return &b.data;
+    }
+
+    //! @brief Forgets about devices from which no message has come for `period` times their interval between messages, at time `t`.
+    void prune(times_t t) {
+        for (auto it = m_bases.begin(); it != m_bases.end(); ) {
+            // the interval of devices heard once is estimated as the largest one seen
+            times_t gap = it->second.gap < TIME_MAX ? it->second.gap : m_gap;
+            if (gap > 0 and t - it->second.time > period * gap) it = m_bases.erase(it);
+            else ++it;
+        }
+    }
+
+  private:
+    //! @brief The last export decoded from a device.
+    struct base_type {
+        //! @brief Sequence number of the export.
+        uint32_t seq = 0;
+        //! @brief Time of the last message from the device.
+        times_t time = TIME_MAX;
+        //! @brief Interval between the last two messages from the device (`TIME_MAX` if unknown).
+        times_t gap = TIME_MAX;
+        //! @brief Whether following deltas apply to the export.
+        bool valid = false;
+        //! @brief Whether the export has been copied from the keyframe it was decoded from.
+        bool owned = false;
+        //! @brief The export.
+        E data;
+    };
+
+    //! @brief Sequence number of the last export encoded.
+    uint32_t m_seq = 0;
+    //! @brief The largest interval between messages from a device.
+    times_t m_gap = 0;
+    //! @brief The last export encoded.
+    E m_prev;
+    //! @brief The message to be sent.
+    message_type m_delta;
+    //! @brief Buffers for comparing serialisations of values (reused across encodings).
+    common::osstream m_lhs, m_rhs;
+    //! @brief The last export decoded from every device.
+    std::unordered_map<device_t, base_type> m_bases;
+};
+
+
+//! @brief Class converting exports into messages and back (sending whole exports).
+template <typename E>
+class export_codec<E, 0> {
+  public:
+    //! @brief The type of the exports.
+    typedef E export_type;
+
+    //! @brief The type of messages.
+    typedef E message_type;
+
+    //! @brief Updates the message to be sent with a new export.
+    void encode(E const&) {}
+
+    //! @brief The message to be sent for an export.
+    message_type const& message(E const& e) const {
+        return e;
+    }
+
+    //! @brief Decodes a message from a device sent at a given time, returning the export.
+    E const* decode(device_t, message_type const& m, times_t, bool = true) {
+        return &m;
+    }
+
+    //! @brief Forgets about devices from which no message has been received recently.
+    void prune(times_t) {}
+};
+
+
+}
+
+
+}
+
+#endif // FCPP_INTERNAL_EXPORT_CODEC_H_
@@ -9,6 +9,7 @@
 #define FCPP_INTERNAL_FLAT_PTR_H_
 
 #include <memory>
+#include <utility>
 
 
 /**
@@ -38,19 +39,13 @@ class flat_ptr<T, false> {
     //! @{
 
     //! @brief Default constructor.
-    flat_ptr() {
-        m_data.reset(new T());
-    }
+    flat_ptr() : m_data(std::make_shared<T>()) {}
 
     //! @brief Default copying constructor.
-    flat_ptr(T const& d) {
-        m_data.reset(new T(d));
-    }
+    flat_ptr(T const& d) : m_data(std::make_shared<T>(d)) {}
 
     //! @brief Default moving constructor.
-    flat_ptr(T&& d) {
-        m_data.reset(new T(d));
-    }
+    flat_ptr(T&& d) : m_data(std::make_shared<T>(std::move(d))) {}
 
     //! @brief Copy constructor.
     flat_ptr(flat_ptr const&) = default;
@@ -64,13 +59,13 @@ class flat_ptr<T, false> {
 
     //! @brief Default copying assignment.
     flat_ptr& operator=(T const& d) {
-        m_data.reset(new T(d));
+        m_data = std::make_shared<T>(d);
         return *this;
     }
 
     //! @brief Default moving assignment.
     flat_ptr& operator=(T&& d) {
-        m_data.reset(new T(d));
+        m_data = std::make_shared<T>(std::move(d));
         return *this;
     }
 
@@ -91,6 +86,11 @@ class flat_ptr<T, false> {
         return *m_data == *(o.m_data);
     }
 
+    //! @brief Whether the content is not shared with other pointers.
+    bool unique() const {
+        return m_data.use_count() == 1;
+    }
+
     //! @brief Access to the content.
     T& operator*() {
         return *m_data.get();
@@ -146,7 +146,7 @@ class flat_ptr<T, true> {
     flat_ptr(T const& d) : m_data(d) {}
 
     //! @brief Default moving constructor.
-    flat_ptr(T&& d) : m_data(d) {}
+    flat_ptr(T&& d) : m_data(std::move(d)) {}
 
     //! @brief Copy constructor.
     flat_ptr(flat_ptr const&) = default;
@@ -166,7 +166,7 @@ class flat_ptr<T, true> {
 
     //! @brief Default moving assignment.
     flat_ptr& operator=(T&& d) {
-        m_data = d;
+        m_data = std::move(d);
         return *this;
     }
 
@@ -188,6 +188,11 @@ class flat_ptr<T, true> {
         return m_data == o.m_data;
     }
 
+    //! @brief Whether the content is not shared with other pointers (always true).
+    constexpr bool unique() const {
+        return true;
+    }
+
     //! @brief Access to the content.
     T& operator*() {
         return m_data;
@@ -0,0 +1,105 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+/**
+ * @file recycler.hpp
+ * @brief Implementation of the `recycler` class for reusing the memory of objects managed by a `flat_ptr`.
+ */
+
+#ifndef FCPP_INTERNAL_RECYCLER_H_
+#define FCPP_INTERNAL_RECYCLER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "lib/internal/flat_ptr.hpp"
+
+
+/**
+ * @brief Namespace containing all the objects in the FCPP library.
+ */
+namespace fcpp {
+
+
+//! @brief Namespace containing objects of internal use.
+namespace internal {
+
+
+//! @cond INTERNAL
+template <typename T, bool is_flat>
+class recycler;
+//! @endcond
+
+
+/**
+ * @brief Class resetting `flat_ptr` objects to empty content, reusing their memory.
+ *
+ * Specialisation for flat data, which is cleared in place (the content type `T` needs a `clear()` method).
+ * With a @ref common::flat_multitype_map content, the arrays of keys and values keep their capacity.
+ */
+template <typename T>
+class recycler<T, true> {
+  public:
+    //! @brief Resets the content of a pointer to empty.
+    void reset(flat_ptr<T, true>& p) {
+        p->clear();
+    }
+};
+
+
+/**
+ * @brief Class resetting `flat_ptr` objects to empty content, reusing their memory.
+ *
+ * Specialisation for shared data. Contents still shared with other pointers are retired into a small pool,
+ * and reused once every other pointer has released them. Thus in a steady state (where contents are shared
+ * for a bounded number of resets) the shared object is never reallocated. The content type `T` needs a `clear()` method.
+ *
+ * How much memory is actually reused depends on `T`: a @ref common::flat_multitype_map keeps the capacity
+ * of its arrays, while a @ref common::multitype_map only keeps its bucket arrays (its nodes are freed by clearing).
+ * Thus refilling a reset content performs no allocation only for flat maps (that is, with flat exports),
+ * while hash maps reallocate a node per entry on every reset. The values stored are destroyed in any case,
+ * so that the memory of fields is not reused.
+ */
+template <typename T>
+class recycler<T, false> {
+  public:
+    //! @brief Maximum number of retired contents waiting to be released.
+    static constexpr size_t pool_size = 4;
+
+    //! @brief Resets the content of a pointer to empty.
+    void reset(flat_ptr<T, false>& p) {
+        if (released(p)) {
+            p->clear();
+            return;
+        }
+        for (flat_ptr<T, false>& q : m_pool)
+            if (released(q)) {
+                q->clear();
+                p.swap(q);
+                return;
+            }
+        if (m_pool.size() < pool_size)
+            m_pool.push_back(p);
+        p = flat_ptr<T, false>();
+    }
+
+  private:
+    //! @brief Whether the content of a pointer has been released by every other pointer.
+    static inline bool released(flat_ptr<T, false> const& p) {
+        if (not p.unique()) return false;
+        // synchronises with the release of the content by other threads
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    //! @brief Retired contents.
+    std::vector<flat_ptr<T, false>> m_pool;
+};
+
+
+}
+
+
+}
+
+#endif // FCPP_INTERNAL_RECYCLER_H_
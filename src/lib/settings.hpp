@@ -184,6 +184,24 @@
 #endif
 
 
+#ifndef FCPP_EXPORT_FLAT
+    //! @brief Setting defining whether exports should be stored in flat sorted arrays (true) or hash maps (false, default).
+    #define FCPP_EXPORT_FLAT false
+#endif
+
+
+#ifndef FCPP_EXPORT_DELTA
+    //! @brief Setting defining the number of rounds between full exports, sending only changes in between (0 for always sending full exports, default).
+    #define FCPP_EXPORT_DELTA 0
+#endif
+
+
+#ifndef FCPP_EXPORT_INDEX
+    //! @brief Setting defining whether neighbours' exports should be indexed by trace on every round (true) or scanned on every access (false, default).
+    #define FCPP_EXPORT_INDEX false
+#endif
+
+
 #ifndef FCPP_WARNING_TRACE
     //! @brief Setting defining whether hash colliding of code points is admissible.
     #define FCPP_WARNING_TRACE false
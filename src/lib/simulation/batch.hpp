@@ -739,7 +739,7 @@ namespace details {
                 P q;
                 MPI_Recv(buf, max_size, MPI_CHAR, MPI_ANY_SOURCE, 1, MPI_COMM_WORLD, &status);
                 MPI_Get_count(&status, MPI_CHAR, &size);
-                common::isstream is({buf, buf+size});
+                common::isstream is(buf, size);
                 is >> q;
                 p += q;
             }
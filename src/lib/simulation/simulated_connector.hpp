@@ -8,13 +8,16 @@
 #ifndef FCPP_SIMULATION_SIMULATED_CONNECTOR_H_
 #define FCPP_SIMULATION_SIMULATED_CONNECTOR_H_
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 
+#include <memory>
 #include <type_traits>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
+#include "lib/common/algorithm.hpp"
 #include "lib/common/option.hpp"
 #include "lib/common/serialize.hpp"
 #include "lib/component/base.hpp"
@@ -44,10 +47,21 @@ namespace tags {
     template <typename T>
     struct delay {};
 
+    //! @brief Declaration flag associating to whether messages should be delivered independently of thread scheduling (defaults to false).
+    template <bool b>
+    struct deterministic {};
+
     //! @brief Declaration tag associating to the dimensionality of the space (defaults to 2).
     template <intmax_t n>
     struct dimension;
 
+    //! @brief Declaration flag associating to whether messages should be delivered through lock-free inboxes, processed by receivers at their next event (defaults to false).
+    template <bool b>
+    struct inbox {};
+
+    //! @brief Net initialisation tag associating to a lower bound on the delay between a round and the sending of its messages, used as lookahead for processing node events in parallel (defaults to zero, a positive value requires a \ref simulated_connector with `deterministic<true>` and delays not below it).
+    struct lookahead;
+
     //! @brief Declaration flag associating to whether message sizes should be emulated (defaults to false).
     template <bool b>
     struct message_size {};
@@ -61,13 +75,16 @@ namespace tags {
 
     //! @brief Initialisation tag associating to the time sensitivity, allowing indeterminacy below it (defaults to \ref FCPP_TIME_EPSILON).
     struct epsilon;
+
+    //! @brief Net initialisation tag associating to the number of threads that can be created (defaults to \ref FCPP_THREADS).
+    struct threads;
 }
 
 
 //! @cond INTERNAL
 namespace details {
-    //! @brief A cell of space, containing nodes and linking to neighbour cells.
-    template <bool parallel, typename N>
+    //! @brief A cell of space with identifier of type `I`, containing nodes (stored contiguously) and linking to neighbour cells.
+    template <bool parallel, typename N, typename I = int>
     class cell {
       public:
         //! @brief Default constructors.
@@ -77,16 +94,33 @@ namespace details {
         cell& operator=(cell const&) = delete;
         cell& operator=(cell&&) = delete;
 
+        //! @brief Constructor with a given identifier.
+        explicit cell(I const& id) : m_id(id) {}
+
+        //! @brief The identifier of the cell.
+        I const& id() const {
+            return m_id;
+        }
+
         //! @brief Inserts a node in the cell.
         void insert(N& n) {
             common::exclusive_guard<parallel> l(m_mutex);
-            m_contents.insert(&n);
+            if (m_index.emplace(&n, m_contents.size()).second)
+                m_contents.push_back(&n);
         }
 
-        //! @brief Removes a node from the cell.
+        //! @brief Removes a node from the cell (moving the last node in its place).
         void erase(N& n) {
             common::exclusive_guard<parallel> l(m_mutex);
-            m_contents.erase(&n);
+            auto it = m_index.find(&n);
+            if (it == m_index.end()) return;
+            size_t i = it->second;
+            m_index.erase(it);
+            if (i + 1 < m_contents.size()) {
+                m_contents[i] = m_contents.back();
+                m_index[m_contents[i]] = i;
+            }
+            m_contents.pop_back();
         }
 
         //! @brief Links a new cell.
@@ -102,15 +136,39 @@ namespace details {
             return m_linked;
         }
 
-        std::conditional_t<parallel, std::unordered_set<N*>, std::unordered_set<N*> const&>
+        //! @brief Gives const access to the nodes in the cell.
+        std::conditional_t<parallel, std::vector<N*>, std::vector<N*> const&>
         content() const {
             common::shared_guard<parallel> l(m_mutex);
             return m_contents;
         }
 
+        //! @brief Appends the nodes in the cell to a given vector.
+        void gather(std::vector<N*>& v) const {
+            common::shared_guard<parallel> l(m_mutex);
+            v.insert(v.end(), m_contents.begin(), m_contents.end());
+        }
+
+        //! @brief Appends the nodes in the linked cells whose identifiers pass a given filter to a given vector.
+        template <typename G>
+        void gather_linked(std::vector<N*>& v, G&& filter) const {
+            common::shared_guard<parallel> l(m_mutex);
+            for (cell const* c : m_linked) {
+                if (not filter(c->m_id)) continue;
+                if (c == this) v.insert(v.end(), m_contents.begin(), m_contents.end());
+                else c->gather(v);
+            }
+        }
+
       private:
+        //! @brief The identifier of the cell.
+        I m_id = {};
+
         //! @brief The content of the cell.
-        std::unordered_set<N*> m_contents;
+        std::vector<N*> m_contents;
+
+        //! @brief The position of every node in `m_contents`.
+        std::unordered_map<N*, size_t> m_index;
 
         //! @brief The linked cells.
         std::vector<cell const*> m_linked;
@@ -135,6 +193,8 @@ namespace details {
  * - \ref tags::dimension defines the dimensionality of the space (defaults to 2).
  *
  * <b>Declaration flags:</b>
+ * - \ref tags::deterministic defines whether messages should be delivered independently of thread scheduling (defaults to false).
+ * - \ref tags::inbox defines whether messages should be delivered through lock-free inboxes, processed by receivers at their next event (defaults to false).
  * - \ref tags::message_size defines whether message sizes should be emulated (defaults to false).
  * - \ref tags::parallel defines whether parallelism is enabled (defaults to \ref FCPP_PARALLEL).
  *
@@ -142,7 +202,10 @@ namespace details {
  * - \ref tags::connection_data associates to communication power (defaults to `connector_type::data_type{}`).
  * - \ref tags::epsilon associates to the time sensitivity, allowing indeterminacy below it (defaults to \ref FCPP_TIME_EPSILON).
  *
- * Net initialisation tags (such as \ref tags::radius) are forwarded to connector classes.
+ * <b>Net initialisation tags:</b>
+ * - \ref tags::threads associates to the number of threads that can be created (defaults to \ref FCPP_THREADS).
+ *
+ * Other net initialisation tags (such as \ref tags::radius) are forwarded to connector classes.
  * Connector classes should have the following members (see \ref connect for a list of available ones):
  * ~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
  * using data_type = // type for connection power data on nodes
@@ -151,9 +214,29 @@ namespace details {
  * real_t maximum_radius() const;
  * bool operator()(data_type const& data1, position_type const& position1, data_type const& data2, position_type const& position2) const;
  * ~~~~~~~~~~~~~~~~~~~~~~~~~
+ * With the plain \ref connect::clique connector, nodes are kept in a flat array instead of cells
+ * and messages are delivered to all of them without evaluating the connector, splitting the
+ * deliveries among up to \ref tags::threads threads for large networks if \ref tags::parallel is true.
+ *
+ * If \ref tags::inbox is true, senders do not lock receivers: they push messages (together with their
+ * position and connection data) into the inboxes of potential receivers, which check the connector and
+ * process the messages by increasing time and sender identifier at the start of their next event.
+ * If \ref tags::deterministic is also true, messages sent in a batch of concurrent events are only
+ * pushed into inboxes once the batch is over (provided that an \ref identifier is a parent component),
+ * so that the outcome of a parallel simulation does not depend on the number of threads.
+ * In this case, if the \ref identifier has a positive \ref tags::lookahead not exceeding the minimum delay, the messages
+ * sent within the lookahead window are sent before the window is processed, since they only depend on rounds before it:
+ * then the parallel simulation has the same outcome as a sequential one (messages are received at the first event of
+ * the receiver not preceding their sending time).
  */
 template <class... Ts>
 struct simulated_connector {
+    //! @brief Whether messages should be delivered independently of thread scheduling.
+    constexpr static bool deterministic = common::option_flag<tags::deterministic, false, Ts...>;
+
+    //! @brief Whether messages should be delivered through lock-free inboxes.
+    constexpr static bool inbox = common::option_flag<tags::inbox, false, Ts...> or deterministic;
+
     //! @brief Whether message sizes should be emulated.
     constexpr static bool message_size = common::option_flag<tags::message_size, false, Ts...>;
 
@@ -175,6 +258,9 @@ struct simulated_connector {
     //! @brief The type of settings data regulating connection.
     using connection_data_type = typename connector_type::data_type;
 
+    //! @brief Whether every pair of nodes is connected (so that messages can be broadcast without checking the connector).
+    constexpr static bool all_to_all = std::is_same<connector_type, connect::clique<dimension>>::value;
+
     //! @brief Delay generator for sending messages after rounds.
     using delay_type = common::option_type<tags::delay, distribution::constant_n<times_t, 0>, Ts...>;
 
@@ -198,6 +284,16 @@ struct simulated_connector {
         CHECK_COMPONENT(calculus);
         //! @endcond
 
+        //! @brief A message waiting in an inbox, together with the sending time, device, position, connection data and serialised size.
+        struct letter_type {
+            times_t time;
+            device_t uid;
+            position_type position;
+            connection_data_type data;
+            std::shared_ptr<void const> message;
+            size_t size;
+        };
+
         //! @brief The local part of the component.
         class node : public P::node {
           public: // visible by net objects and the main program
@@ -212,7 +308,7 @@ struct simulated_connector {
              * @param t A `tagged_tuple` gathering initialisation values.
              */
             template <typename S, typename T>
-            node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), m_delay(get_generator(has_randomizer<P>{}, *this),t), m_data(common::get_or<tags::connection_data>(t, connection_data_type{})), m_nbr_msg_size(0) {
+            node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), m_delay(get_generator(has_randomizer<P>{}, *this),t), m_data(common::get_or<tags::connection_data>(t, connection_data_type{})), m_nbr_msg_size(0), m_incoming_size(no_size) {
                 m_send = m_leave = TIME_MAX;
                 m_epsilon = common::get_or<tags::epsilon>(t, FCPP_TIME_EPSILON);
                 P::node::net.cell_enter(P::node::as_final());
@@ -233,6 +329,19 @@ struct simulated_connector {
                 return m_data;
             }
 
+            //! @brief A key such that nodes likely to interact have close keys (the Z-order of the cell of the node).
+            size_t locality() const {
+                if (all_to_all) return P::node::locality();
+                position_type x = P::node::position();
+                real_t R = P::node::net.connection_radius();
+                size_t k = 0;
+                constexpr size_t bits = 8 * sizeof(size_t) / dimension;
+                for (size_t b = 0; b < bits; ++b)
+                    for (size_t i = 0; i < dimension; ++i)
+                        k |= (size_t(int(floor(x[i]/R))) >> b & 1) << (b * dimension + i);
+                return k;
+            }
+
             //! @brief Returns the time of the next sending of messages.
             times_t send_time() const {
                 return m_send;
@@ -249,8 +358,14 @@ struct simulated_connector {
             }
 
             //! @brief Size of last message sent (zero if `message_size` is false).
+            size_t msg_size() {
+                if (message_size) return fcpp::details::self(m_nbr_msg_size.front().build(), P::node::uid);
+                else return 0;
+            }
+
+            //! @brief Size of last message sent (zero if `message_size` is false, const access).
             size_t msg_size() const {
-                if (message_size) return fcpp::details::self(m_nbr_msg_size.front(), P::node::uid);
+                if (message_size) return m_nbr_msg_size.front().self(P::node::uid);
                 else return 0;
             }
 
@@ -259,6 +374,11 @@ struct simulated_connector {
              *
              * Returns a `field<size_t> const&` if `message_size` is true, otherwise it returns a `size_t` equal to zero.
              */
+            auto nbr_msg_size() {
+                return get_nbr_msg_size(common::number_sequence<message_size>{});
+            }
+
+            //! @brief Sizes of messages received from neighbours (const access, by copy).
             auto nbr_msg_size() const {
                 return get_nbr_msg_size(common::number_sequence<message_size>{});
             }
@@ -274,6 +394,7 @@ struct simulated_connector {
 
             //! @brief Updates the internal status of node component.
             void update() {
+                if (inbox) process_inbox(next());
                 times_t t = std::min(m_send, m_leave);
                 times_t pt = P::node::next();
                 if (t < pt) {
@@ -291,23 +412,46 @@ struct simulated_connector {
                         m_send = TIME_MAX;
                         typename F::node::message_t m;
                         P::node::as_final().send(t, m);
-                        P::node::as_final().receive(t, P::node::uid, m);
-                        common::unlock_guard<parallel> u(P::node::mutex);
-                        for (auto c : P::node::net.cell_of(P::node::as_final()).linked())
-                            for (typename F::node* n : c->content()) {
-                                common::lock_guard<parallel> l(n->mutex);
-                                if (n != this and P::node::net.connection_success(get_generator(has_randomizer<P>{}, *this), m_data, P::node::position(t), n->m_data, n->position(t))) {
-                                    n->receive(t, P::node::uid, m);
+                        size_t sz = send_size(common::number_sequence<message_size>{}, m);
+                        receive_sized(t, P::node::uid, m, sz);
+                        if (inbox) {
+                            letter_type l{t, P::node::uid, P::node::position(t), m_data, std::make_shared<typename F::node::message_t const>(std::move(m)), sz};
+                            if (deterministic) P::node::net.stage(all_to_all ? nullptr : &P::node::net.cell_of(P::node::as_final()), std::move(l));
+                            else if (all_to_all) P::node::net.broadcast(P::node::as_final(), [&l] (typename F::node& n) {
+                                n.post(l);
+                            });
+                            else {
+                                gather_receivers(l.position);
+                                for (typename F::node* n : m_receivers) if (n != this) n->post(l);
+                            }
+                        } else {
+                            common::unlock_guard<parallel> u(P::node::mutex);
+                            if (all_to_all) P::node::net.broadcast(P::node::as_final(), [this,t,&m,sz] (typename F::node& n) {
+                                common::lock_guard<parallel> l(n.mutex);
+                                n.receive_sized(t, P::node::uid, m, sz);
+                            });
+                            else {
+                                position_type p = P::node::position(t);
+                                gather_receivers(p);
+                                for (typename F::node* n : m_receivers) {
+                                    common::lock_guard<parallel> l(n->mutex);
+                                    if (n != this and P::node::net.connection_success(get_generator(has_randomizer<P>{}, *this), m_data, p, n->m_data, n->position(t))) {
+                                        n->receive_sized(t, P::node::uid, m, sz);
+                                    }
                                 }
                             }
+                        }
                     }
                 } else P::node::update();
             }
 
             //! @brief Performs computations at round start with current time `t`.
             void round_start(times_t t) {
-                m_send = t + m_delay(get_generator(has_randomizer<P>{}, *this), common::tagged_tuple_t<>{});
+                times_t d = m_delay(get_generator(has_randomizer<P>{}, *this), common::tagged_tuple_t<>{});
+                check_lookahead(has_identifier<P>{}, d);
+                m_send = t + d;
                 P::node::round_start(t);
+                for (auto& b : m_nbr_msg_size) b.build();
                 maybe_align_inplace_m_nbr_msg_size(common::number_sequence<has_calculus<P>::value and message_size>{});
             }
 
@@ -326,21 +470,75 @@ struct simulated_connector {
                 receive_size(common::number_sequence<message_size>{}, d, m);
             }
 
+            //! @brief Receives an incoming message, whose serialised size `sz` has been computed by the sender.
+            template <typename S, typename T>
+            inline void receive_sized(times_t t, device_t d, common::tagged_tuple<S,T> const& m, size_t sz) {
+                m_incoming_size = sz;
+                P::node::as_final().receive(t, d, m);
+                // reset also if the message did not reach this component
+                m_incoming_size = no_size;
+            }
+
+            //! @brief Stores a message in the inbox, to be received at the next event.
+            inline void post(letter_type const& l) {
+                m_inbox.push(l);
+            }
+
+            //! @brief Performs the connector events preceding both time `t` and the next event of the parent components.
+            void send_ahead(times_t t) {
+                while (std::min(m_send, m_leave) < std::min(t, P::node::next())) update();
+            }
+
           private: // implementation details
+            //! @brief Checks that a positive lookahead comes with deterministic delivery and does not exceed the delay `d`.
+            inline void check_lookahead(std::true_type, times_t d) const {
+                assert(P::node::net.lookahead() == 0 or (deterministic and d >= P::node::net.lookahead()));
+            }
+
+            //! @brief Does not check anything without an identifier.
+            inline void check_lookahead(std::false_type, times_t) const {}
+
+            //! @brief Collects the nodes in the cells linked to the current one, which may be in range of position `p`.
+            void gather_receivers(position_type const& p) {
+                m_receivers.clear();
+                P::node::net.gather_linked(P::node::net.cell_of(P::node::as_final()), p, m_receivers);
+            }
+
+            //! @brief Receives the messages sent up to time `t` which pass the connector check, by increasing time and sender.
+            void process_inbox(times_t t) {
+                if (not m_inbox.empty()) {
+                    m_inbox.pop(m_letters);
+                    std::sort(m_letters.begin(), m_letters.end(), [] (letter_type const& x, letter_type const& y) {
+                        return x.time < y.time or (x.time == y.time and x.uid < y.uid);
+                    });
+                }
+                size_t i = 0;
+                for (; i < m_letters.size() and m_letters[i].time <= t; ++i) {
+                    letter_type const& l = m_letters[i];
+                    if (P::node::net.connection_success(get_generator(has_randomizer<P>{}, *this), l.data, l.position, m_data, P::node::position(l.time)))
+                        receive_sized(l.time, l.uid, *static_cast<typename F::node::message_t const*>(l.message.get()), l.size);
+                }
+                m_letters.erase(m_letters.begin(), m_letters.begin() + i);
+            }
+
             //! @brief Sizes of messages received from neighbours (disabled).
             constexpr static size_t get_nbr_msg_size(common::number_sequence<false>) {
                 return 0;
             }
             //! @brief Sizes of messages received from neighbours (enabled).
-            field<size_t> const& get_nbr_msg_size(common::number_sequence<true>) const {
-                return m_nbr_msg_size.front();
+            field<size_t> const& get_nbr_msg_size(common::number_sequence<true>) {
+                return m_nbr_msg_size.front().build();
+            }
+            //! @brief Sizes of messages received from neighbours (enabled, const access).
+            field<size_t> get_nbr_msg_size(common::number_sequence<true>) const {
+                return m_nbr_msg_size.front().merged();
             }
 
             //! @brief Changes the domain of m_nbr_msg_size to match the domain of the neightbours ids (disabled).
             void maybe_align_inplace_m_nbr_msg_size(common::number_sequence<false>) {}
             //! @brief Changes the domain of m_nbr_msg_size to match the domain of the neightbours ids (enabled).
             void maybe_align_inplace_m_nbr_msg_size(common::number_sequence<true>) {
-                align_inplace(m_nbr_msg_size.front(), std::vector<device_t>(fcpp::details::get_ids(P::node::nbr_uid())));
+                align_inplace(m_nbr_msg_size.front().build(), fcpp::details::get_ids(P::node::nbr_uid()));
             }
 
             //! @brief Stores size of received message (disabled).
@@ -349,14 +547,25 @@ struct simulated_connector {
             //! @brief Stores size of received message (enabled).
             template <typename S, typename T>
             void receive_size(common::number_sequence<true>, device_t d, common::tagged_tuple<S,T> const& m) {
-                common::osstream os;
-                os << m;
-                fcpp::details::self(m_nbr_msg_size.front(), d) = os.size();
+                size_t sz = m_incoming_size == no_size ? common::serialized_size_of(m) : m_incoming_size;
+                m_nbr_msg_size.front().insert(d, sz);
+            }
+
+            //! @brief Size of a message to be sent (disabled).
+            template <typename S, typename T>
+            static constexpr size_t send_size(common::number_sequence<false>, common::tagged_tuple<S,T> const&) {
+                return no_size;
+            }
+            //! @brief Size of a message to be sent (enabled), computed once for all receivers.
+            template <typename S, typename T>
+            static size_t send_size(common::number_sequence<true>, common::tagged_tuple<S,T> const& m) {
+                return common::serialized_size_of(m);
             }
 
             //! @brief Checks when the node will leave the current cell.
             void set_leave_time(times_t t) {
                 m_leave = TIME_MAX;
+                if (all_to_all) return;
                 position_type x = P::node::position(t);
                 real_t R = P::node::net.connection_radius();
                 for (size_t i=0; i<dimension; ++i) {
@@ -390,14 +599,29 @@ struct simulated_connector {
             connection_data_type m_data;
 
             //! @brief Sizes of messages received from neighbours.
-            common::option<field<size_t>, message_size> m_nbr_msg_size;
+            common::option<fcpp::details::field_builder<size_t>, message_size> m_nbr_msg_size;
+
+            //! @brief Placeholder for message sizes not known in advance.
+            constexpr static size_t no_size = size_t(-1);
+
+            //! @brief Size of the message being received, if computed by the sender (`no_size` otherwise).
+            size_t m_incoming_size;
+
+            //! @brief Nodes in the cells linked to the current one (reused across sends).
+            std::vector<typename F::node*> m_receivers;
+
+            //! @brief Messages sent to the node and not yet received.
+            common::inbox<parallel, letter_type> m_inbox;
+
+            //! @brief Messages popped from the inbox and not yet received, sorted by time and sender.
+            std::vector<letter_type> m_letters;
         };
 
         //! @brief The global part of the component.
         class net : public P::net {
           public: // visible by node objects and the main program
             //! @brief The type of cells grouping nearby nodes.
-            using cell_type = details::cell<parallel, typename F::node>;
+            using cell_type = details::cell<parallel, typename F::node, cell_id_type>;
 
             //! @brief Type for representing a position.
             using position_type = simulated_connector<Ts...>::position_type;
@@ -407,20 +631,43 @@ struct simulated_connector {
 
             //! @brief Constructor from a tagged tuple.
             template <typename S, typename T>
-            explicit net(common::tagged_tuple<S,T> const& t) : P::net(t), m_connector(get_generator(has_randomizer<P>{}, *this),t) {}
+            explicit net(common::tagged_tuple<S,T> const& t) : P::net(t), m_connector(get_generator(has_randomizer<P>{}, *this),t), m_threads(common::get_or<tags::threads>(t, FCPP_THREADS)) {}
 
             //! @brief Destructor ensuring that nodes are deleted first.
             ~net() {
                 maybe_clear(has_identifier<P>{}, *this);
             }
 
+            //! @brief Updates the internal status of net component.
+            void update() {
+                if (deterministic) {
+                    post_staged();
+                    send_ahead(has_identifier<P>{}, *this);
+                }
+                P::net::update();
+            }
+
             //! @brief Inserts a new node into its cell.
             void cell_enter(typename F::node& n) {
-                cell_enter_impl<false>(n, n.position());
+                if (all_to_all) {
+                    common::exclusive_guard<parallel> l(m_node_mutex);
+                    m_index[n.uid] = m_all.size();
+                    m_all.push_back(&n);
+                } else cell_enter_impl<false>(n, n.position());
             }
 
             //! @brief Removes a node from all cells.
             void cell_leave(typename F::node& n) {
+                if (all_to_all) {
+                    common::exclusive_guard<parallel> l(m_node_mutex);
+                    auto it = m_index.find(n.uid);
+                    if (it == m_index.end()) return;
+                    m_all[it->second] = m_all.back();
+                    m_index[m_all.back()->uid] = it->second;
+                    m_all.pop_back();
+                    m_index.erase(it);
+                    return;
+                }
                 if (m_nodes.size() == 0) return;
                 common::exclusive_guard<parallel> l(m_node_mutex);
                 m_nodes.at(n.uid)->second.erase(n);
@@ -429,15 +676,53 @@ struct simulated_connector {
 
             //! @brief Moves a node across cells.
             void cell_move(typename F::node& n, times_t t) {
-                cell_enter_impl<true>(n, n.position(t));
+                if (not all_to_all) cell_enter_impl<true>(n, n.position(t));
             }
 
-            //! @brief Returns the cells in proximity of node `n`.
+            /**
+             * @brief Applies a delivery function to every node other than `n` (only if `all_to_all`).
+             *
+             * Deliveries are split across threads only if the sender is not already updated within a parallel loop.
+             */
+            template <typename G>
+            void broadcast(typename F::node& n, G&& deliver) {
+                common::shared_guard<parallel> l(m_node_mutex);
+                size_t chunks = (m_all.size() + broadcast_chunk - 1) / broadcast_chunk;
+                if (not parallel or m_threads <= 1 or chunks <= 1 or common::in_parallel()) {
+                    for (typename F::node* x : m_all) if (x != &n) deliver(*x);
+                    return;
+                }
+                common::parallel_for(common::tags::general_execution<parallel>(std::min(m_threads, chunks)), chunks, [&] (size_t c, size_t) {
+                    size_t e = std::min(m_all.size(), (c+1) * broadcast_chunk);
+                    for (size_t i = c * broadcast_chunk; i < e; ++i) if (m_all[i] != &n) deliver(*m_all[i]);
+                });
+            }
+
+            //! @brief Stores a message to be posted to the nodes linked to a cell (or to all nodes if null) at the next update.
+            void stage(cell_type const* c, letter_type l) {
+                m_staged.push(std::make_pair(c, std::move(l)));
+            }
+
+            //! @brief Returns the cells in proximity of node `n` (only if not `all_to_all`).
             cell_type const& cell_of(typename F::node const& n) const {
                 common::shared_guard<parallel> l(m_node_mutex);
                 return m_nodes.at(n.uid)->second;
             }
 
+            //! @brief Appends to a vector the nodes in the cells linked to a given cell, skipping cells out of range of position `p`.
+            void gather_linked(cell_type const& c, position_type const& p, std::vector<typename F::node*>& v) const {
+                real_t R = connection_radius();
+                c.gather_linked(v, [&p,R] (cell_id_type const& d) {
+                    // squared distance from `p` to the cell, in cell sides
+                    real_t dist = 0;
+                    for (size_t i=0; i<dimension; ++i) {
+                        real_t x = std::max(std::max(d[i] - p[i]/R, p[i]/R - d[i] - 1), real_t(0));
+                        dist += x*x;
+                    }
+                    return dist <= 1;
+                });
+            }
+
             //! @brief The maximum connection radius.
             inline real_t connection_radius() const {
                 return m_connector.maximum_radius();
@@ -450,6 +735,27 @@ struct simulated_connector {
             }
 
           private: // implementation details
+            //! @brief Number of consecutive nodes receiving a broadcast within the same thread.
+            constexpr static size_t broadcast_chunk = 1024;
+
+            //! @brief Posts the staged messages to the nodes in the cells linked to their senders' cells.
+            void post_staged() {
+                if (m_staged.empty()) return;
+                m_staged.pop(m_outgoing);
+                m_gathered.resize(std::max<size_t>(m_threads, 1));
+                common::parallel_for(common::tags::general_execution<parallel>(m_gathered.size()), m_outgoing.size(), [this] (size_t i, size_t th) {
+                    letter_type const& l = m_outgoing[i].second;
+                    std::vector<typename F::node*> const* v = &m_all;
+                    if (m_outgoing[i].first != nullptr) {
+                        m_gathered[th].clear();
+                        gather_linked(*m_outgoing[i].first, l.position, m_gathered[th]);
+                        v = &m_gathered[th];
+                    }
+                    for (typename F::node* n : *v) if (n->uid != l.uid) n->post(l);
+                });
+                m_outgoing.clear();
+            }
+
             //! @brief A custom hash for cell identifiers.
             struct cell_hasher {
                 size_t operator()(cell_id_type const& c) const {
@@ -482,7 +788,7 @@ struct simulated_connector {
                 }
                 if (create) {
                     common::exclusive_guard<parallel> l(m_cell_mutex);
-                    nit = m_cells.emplace(std::piecewise_construct, std::make_tuple(c), std::make_tuple()).first;
+                    nit = m_cells.emplace(std::piecewise_construct, std::make_tuple(c), std::make_tuple(c)).first;
                     nit->second.link(nit->second);
                     cell_id_type d;
                     for (size_t i=0; i<dimension; ++i) d[i] = c[i]-1;
@@ -538,15 +844,52 @@ struct simulated_connector {
             template <typename N>
             inline void maybe_clear(std::false_type, N&) {}
 
+            //! @brief Sends the messages of the lookahead window of the next node update, if it is next.
+            template <typename N>
+            void send_ahead(std::true_type, N& n) {
+                times_t t = n.lookahead_end();
+                if (n.next() < n.node_next() or t <= n.node_next()) return;
+                // only nodes with events within the window can send within it
+                std::vector<device_t> const& nv = n.node_window();
+                common::parallel_for(common::tags::general_execution<parallel>(m_threads), nv.size(), [&n,&nv,t] (size_t i, size_t) {
+                    if (n.node_count(nv[i]) == 0) return;
+                    typename N::lock_type l;
+                    n.node_at(nv[i], l).send_ahead(t);
+                });
+                post_staged();
+            }
+
+            //! @brief Does nothing otherwise.
+            template <typename N>
+            inline void send_ahead(std::false_type, N&) {}
+
             //! @brief The map from cell identifiers to cells.
             cell_map_type m_cells;
 
             //! @brief The map associating devices identifiers to their cell.
             std::unordered_map<device_t, typename cell_map_type::iterator> m_nodes;
 
+            //! @brief All nodes, if `all_to_all`.
+            std::vector<typename F::node*> m_all;
+
+            //! @brief The map associating devices identifiers to their position in `m_all`.
+            std::unordered_map<device_t, size_t> m_index;
+
             //! @brief The connector predicate.
             connector_type m_connector;
 
+            //! @brief The number of threads to be used.
+            size_t const m_threads;
+
+            //! @brief Messages sent during the last batch of events, with the cell of their sender.
+            common::inbox<parallel, std::pair<cell_type const*, letter_type>> m_staged;
+
+            //! @brief Messages being posted (reused across updates).
+            std::vector<std::pair<cell_type const*, letter_type>> m_outgoing;
+
+            //! @brief Receivers being gathered by each thread (reused across updates).
+            std::vector<std::vector<typename F::node*>> m_gathered;
+
             //! @brief The mutexes regulating access to maps.
             mutable common::shared_mutex<parallel> m_node_mutex, m_cell_mutex;
         };
@@ -121,8 +121,8 @@ struct simulated_positioner {
             node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), m_x(common::get_or<tags::x>(t, position_type{})), m_v(common::get_or<tags::v>(t, position_type{})), m_a(common::get_or<tags::a>(t, position_type{})), m_f(common::get_or<tags::f>(t, 0)), m_nbr_vec{details::nan_vec<dimension>()}, m_nbr_dist{INF} {
                 static_assert(common::tagged_tuple<S,T>::tags::template count<tags::x> >= 1, MISSING_TAG_MESSAGE);
                 m_last = TIME_MIN;
-                fcpp::details::self(m_nbr_vec, P::node::uid) = vec<dimension>();
-                fcpp::details::self(m_nbr_dist, P::node::uid) = 0;
+                m_nbr_vec.insert(P::node::uid, vec<dimension>());
+                m_nbr_dist.insert(P::node::uid, 0);
             }
 
             #undef MISSING_TAG_MESSAGE
@@ -277,6 +277,8 @@ struct simulated_positioner {
                     }
                 }
                 m_last = t;
+                m_nbr_vec.build();
+                m_nbr_dist.build();
             }
 
             //! @brief Receives an incoming message (possibly reading values from sensors).
@@ -285,8 +287,8 @@ struct simulated_positioner {
                 P::node::receive(t, d, m);
                 position_type v = common::get<positioner_tag>(m) - position(t);
                 if (d != P::node::uid) {
-                    fcpp::details::self(m_nbr_vec, d) = v;
-                    fcpp::details::self(m_nbr_dist, d) = norm(v);
+                    m_nbr_vec.insert(d, v);
+                    m_nbr_dist.insert(d, norm(v));
                 }
             }
 
@@ -299,13 +301,23 @@ struct simulated_positioner {
             }
 
             //! @brief Perceived positions of neighbours as difference vectors.
-            fcpp::field<position_type> const& nbr_vec() const {
-                return m_nbr_vec;
+            fcpp::field<position_type> const& nbr_vec() {
+                return m_nbr_vec.build();
+            }
+
+            //! @brief Perceived positions of neighbours as difference vectors (const access, by copy).
+            fcpp::field<position_type> nbr_vec() const {
+                return m_nbr_vec.merged();
             }
 
             //! @brief Perceived distances from neighbours.
-            fcpp::field<real_t> const& nbr_dist() const {
-                return m_nbr_dist;
+            fcpp::field<real_t> const& nbr_dist() {
+                return m_nbr_dist.build();
+            }
+
+            //! @brief Perceived distances from neighbours (const access, by copy).
+            fcpp::field<real_t> nbr_dist() const {
+                return m_nbr_dist.merged();
             }
 
             //! @brief Lags since most recent distance measurements.
@@ -349,10 +361,10 @@ struct simulated_positioner {
             real_t m_f;
 
             //! @brief Perceived positions of neighbours as difference vectors.
-            fcpp::field<position_type> m_nbr_vec;
+            fcpp::details::field_builder<position_type> m_nbr_vec;
 
             //! @brief Perceived distances from neighbours.
-            fcpp::field<real_t> m_nbr_dist;
+            fcpp::details::field_builder<real_t> m_nbr_dist;
 
             //! @brief Time of the last round happened.
             times_t m_last;
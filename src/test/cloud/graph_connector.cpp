@@ -1,12 +1,14 @@
 // Copyright © 2021 Giorgio Audrito. All Rights Reserved.
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
 
 #include "lib/component/base.hpp"
 #include "lib/component/identifier.hpp"
+#include "lib/component/randomizer.hpp"
 #include "lib/component/scheduler.hpp"
 #include "lib/cloud/graph_connector.hpp"
 
@@ -37,7 +39,7 @@ template <int O>
 using combo = component::combine_spec<
     exposer,
     component::scheduler<round_schedule<seq_per>>,
-    component::graph_connector<message_size<(O & 2) == 2>, parallel<(O & 1) == 1>, delay<distribution::constant_n<times_t, 1, 4>>>,
+    component::graph_connector<inbox<(O & 4) == 4>, message_size<(O & 2) == 2>, parallel<(O & 1) == 1>, delay<distribution::constant_n<times_t, 1, 4>>>,
     component::identifier<
         parallel<(O & 1) == 1>,
         synchronised<(O & 2) == 2>
@@ -45,7 +47,7 @@ using combo = component::combine_spec<
     component::base<parallel<(O & 1) == 1>>
 >;
 
-MULTI_TEST(GraphConnectorTest, Arcs, O, 2) {
+MULTI_TEST(GraphConnectorTest, Arcs, O, 3) {
     typename combo<O>::net  network{common::make_tagged_tuple<oth>("foo")};
     typename combo<O>::node d0{network, common::make_tagged_tuple<uid>(0)};
     typename combo<O>::node d1{network, common::make_tagged_tuple<uid>(1)};
@@ -63,7 +65,7 @@ MULTI_TEST(GraphConnectorTest, Arcs, O, 2) {
 
 }
 
-MULTI_TEST(GraphConnectorTest, Messages, O, 2) {
+MULTI_TEST(GraphConnectorTest, Messages, O, 3) {
     auto update = [](auto& node) {
         common::lock_guard<(O & 1) == 1> l(node.mutex);
         node.update();
@@ -110,3 +112,85 @@ MULTI_TEST(GraphConnectorTest, Messages, O, 2) {
     EXPECT_EQ(3.25, d3.next());
     EXPECT_EQ(3.25, d4.next());
 }
+
+// Component exposing node creation.
+struct emplacer {
+    template <typename F, typename P>
+    struct component : public P {
+        using node = typename P::node;
+        struct net : public P::net {
+            using P::net::net;
+            using P::net::node_emplace;
+        };
+    };
+};
+
+// Component mixing the values received into its own, depending on the order of messages.
+struct mixer {
+    template <typename F, typename P>
+    struct component : public P {
+        struct node : public P::node {
+            using message_t = typename P::node::message_t::template push_back<tag,size_t>;
+            template <typename S, typename T>
+            node(typename F::net& n, common::tagged_tuple<S,T> const& t) : P::node(n,t), value(P::node::uid) {}
+            template <typename S, typename T>
+            void receive(times_t t, device_t d, common::tagged_tuple<S,T> const& m) {
+                P::node::receive(t, d, m);
+                value = value * 31 + common::get<tag>(m) + d;
+            }
+            template <typename S, typename T>
+            common::tagged_tuple<S,T>& send(times_t t, common::tagged_tuple<S,T>& m) const {
+                P::node::send(t, m);
+                common::get<tag>(m) = value;
+                return m;
+            }
+            size_t value;
+        };
+        using net = typename P::net;
+    };
+};
+
+using rand_per = sequence::periodic<distribution::interval_n<times_t, 0, 1>, distribution::interval_n<times_t, 1, 3, 2>, distribution::constant_n<times_t, 20>>;
+
+template <int O>
+using deterministic_combo = component::combine_spec<
+    exposer,
+    emplacer,
+    mixer,
+    component::graph_connector<deterministic<true>, message_size<true>, parallel<true>, delay<distribution::interval_n<times_t, 0, 1, 4>>>,
+    component::scheduler<round_schedule<rand_per>>,
+    component::randomizer<>,
+    component::identifier<parallel<true>, synchronised<O == 1>>,
+    component::base<parallel<true>>
+>;
+
+// Runs a simulation on a grid graph, returning the mixed values and neighbours of every node.
+template <int O>
+std::vector<std::pair<size_t, std::vector<device_t>>> deterministic_run(size_t n) {
+    typename deterministic_combo<O>::net network{common::make_tagged_tuple<threads, epsilon, seed>(n, 0.25, 42)};
+    for (int i=0; i<200; ++i)
+        network.node_emplace(common::make_tagged_tuple<uid>(i));
+    auto link = [&](device_t i, device_t j) {
+        typename deterministic_combo<O>::net::lock_type l1, l2;
+        network.node_at(i, l1).connect(&network.node_at(j, l2));
+    };
+    for (device_t i=0; i<200; ++i)
+        for (device_t j : {i+1, i+15}) if (j < 200 and (j != i+1 or j%15 != 0)) {
+            link(i, j);
+            link(j, i);
+        }
+    network.run(15);
+    std::vector<std::pair<size_t, std::vector<device_t>>> res;
+    for (device_t i=0; i<200; ++i)
+        res.emplace_back(network.node_at(i).value, fcpp::details::get_ids(network.node_at(i).nbr_msg_size()));
+    return res;
+}
+
+MULTI_TEST(GraphConnectorTest, Deterministic, O, 1) {
+    std::vector<std::pair<size_t, std::vector<device_t>>> r1 = deterministic_run<O>(1);
+    size_t tot = 0;
+    for (auto const& p : r1) tot += p.second.size();
+    EXPECT_LT(700ULL, tot);
+    EXPECT_EQ(r1, deterministic_run<O>(3));
+    EXPECT_EQ(r1, deterministic_run<O>(8));
+}
@@ -1,5 +1,6 @@
 // Copyright © 2021 Giorgio Audrito. All Rights Reserved.
 
+#include <atomic>
 #include <queue>
 #include <random>
 
@@ -88,6 +89,43 @@ TEST(AlgorithmTest, ParallelFor) {
     common::parallel_for(common::tags::parallel_execution(4), N, [&v](size_t i, size_t) { ++v[i]; });
     for (size_t i=0; i<N; ++i)
         EXPECT_EQ(int(i+1), v[i]);
+    // many small calls, with nested calls
+    std::vector<std::atomic<int>> w(N);
+    for (int k=0; k<1000; ++k)
+        common::parallel_for(common::tags::dynamic_execution(4), N, [&w](size_t i, size_t) { ++w[i]; });
+    common::parallel_for(common::tags::parallel_execution(3), 3, [&w](size_t, size_t) {
+        common::parallel_for(common::tags::parallel_execution(2), N, [&w](size_t i, size_t) { ++w[i]; });
+    });
+    for (size_t i=0; i<N; ++i)
+        EXPECT_EQ(1003, w[i]);
+    // work stealing with unbalanced tasks
+    for (size_t k=0; k<100; ++k)
+        common::parallel_for(common::tags::stealing_execution(4, k%3+1), N, [&w](size_t i, size_t) {
+            int t = 0;
+            if (i < 10) workhard(t, 10);
+            ++w[i];
+        });
+    common::parallel_for(common::tags::general_stealing_execution<true>(8), 5, [&w](size_t i, size_t) { ++w[i]; });
+    common::parallel_for(common::tags::general_stealing_execution<false>(8), 5, [&w](size_t i, size_t) { ++w[i]; });
+    for (size_t i=0; i<N; ++i)
+        EXPECT_EQ(i < 5 ? 1105 : 1103, w[i]);
+    acc = 0;
+    common::parallel_for(common::tags::stealing_execution(4), N, worker);
+    EXPECT_NEQ(N, acc);
+}
+
+TEST(AlgorithmTest, InParallel) {
+    EXPECT_FALSE(common::in_parallel());
+    std::atomic<int> inside{0}, nested{0};
+    common::parallel_for(common::tags::parallel_execution(4), 8, [&](size_t, size_t) {
+        if (common::in_parallel()) ++inside;
+        common::parallel_for(common::tags::parallel_execution(4), 4, [&](size_t, size_t) {
+            if (common::in_parallel()) ++nested;
+        });
+    });
+    EXPECT_EQ(8, inside);
+    EXPECT_EQ(32, nested);
+    EXPECT_FALSE(common::in_parallel());
 }
 
 TEST(AlgorithmTest, ParallelWhile) {
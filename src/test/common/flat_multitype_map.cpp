@@ -0,0 +1,162 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+#include <sstream>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "lib/common/flat_multitype_map.hpp"
+#include "lib/common/ostream.hpp"
+#include "lib/common/serialize.hpp"
+
+using namespace fcpp;
+
+
+class FlatMultitypeMapTest : public ::testing::Test {
+  protected:
+    virtual void SetUp() {
+        data.insert(7, 'a');
+        data.insert<char>(7, 'b');
+        data.insert<char>(42, '+');
+        data.insert<int>(18, 31);
+        data.insert(18, 999);
+        data.insert(2);
+        data.insert(3);
+        data.insert(3);
+    }
+
+    common::flat_multitype_map<short, int, double, char> data;
+};
+
+
+TEST_F(FlatMultitypeMapTest, Operators) {
+    common::flat_multitype_map<short, int, double, char> x(data), y, z, a, b;
+    z = y;
+    y = x;
+    z = std::move(y);
+    EXPECT_EQ(data, z);
+    EXPECT_EQ(a, b);
+    swap(z, a);
+    EXPECT_EQ(data, a);
+    EXPECT_EQ(z, b);
+    a.compact();
+    EXPECT_EQ(data, a);
+}
+
+TEST_F(FlatMultitypeMapTest, Points) {
+    EXPECT_TRUE(data.contains(2));
+    EXPECT_TRUE(data.contains(3));
+    data.remove(3);
+    EXPECT_FALSE(data.contains(3));
+    EXPECT_FALSE(data.contains(0));
+    EXPECT_FALSE(data.contains(999));
+}
+
+TEST_F(FlatMultitypeMapTest, Values) {
+    EXPECT_TRUE(data.count<char>(42));
+    data.erase<char>(42);
+    EXPECT_FALSE(data.count<char>(42));
+    EXPECT_FALSE(data.count<double>(42));
+    EXPECT_EQ(999, data.at<int>(18));
+    EXPECT_EQ('b', data.at<char>(7));
+    EXPECT_EQ(nullptr, data.find<char>(42));
+    EXPECT_EQ('b', *data.find<char>(7));
+}
+
+TEST_F(FlatMultitypeMapTest, Clear) {
+    data.clear();
+    EXPECT_EQ((common::flat_multitype_map<short, int, double, char>{}), data);
+    EXPECT_FALSE(data.contains(2));
+    EXPECT_FALSE(data.count<char>(7));
+    data.insert(7, 'c');
+    EXPECT_EQ('c', data.at<char>(7));
+    for (int r = 0; r < 3; ++r) {
+        data.clear();
+        for (int i = 0; i < 40; ++i) data.insert(short((i * 17 + r) % 41), i);
+        data.compact();
+        short last = -1;
+        data.for_each<int>([&](short k, int v){
+            EXPECT_LT(last, k);
+            EXPECT_EQ(k, (v * 17 + r) % 41);
+            last = k;
+        });
+    }
+}
+
+TEST_F(FlatMultitypeMapTest, Insert) {
+    EXPECT_FALSE(data.count<char>(2));
+    EXPECT_FALSE(data.contains(17));
+    EXPECT_EQ(999, data.at<int>(18));
+    EXPECT_EQ('b', data.at<char>(7));
+    common::flat_multitype_map<short, int, double, char> newdata;
+    newdata.insert(7, 'x');
+    newdata.insert(2, '*');
+    newdata.insert(18, 0);
+    newdata.insert(3);
+    newdata.insert(17);
+    data.insert(newdata);
+    EXPECT_TRUE(data.count<char>(2));
+    EXPECT_TRUE(data.contains(17));
+    EXPECT_EQ(999, data.at<int>(18));
+    EXPECT_EQ('b', data.at<char>(7));
+    EXPECT_EQ('*', data.at<char>(2));
+}
+
+TEST_F(FlatMultitypeMapTest, Compact) {
+    common::flat_multitype_map<short, int, double, char> x, y;
+    for (short i = 0; i < 100; ++i) {
+        x.insert<int>((i * 37) % 100, i);
+        x.insert((i * 59) % 100);
+    }
+    for (short i = 99; i >= 0; --i) {
+        y.insert<int>((i * 37) % 100, i);
+        y.insert((i * 59) % 100);
+    }
+    EXPECT_EQ(x, y);
+    for (short i = 0; i < 100; ++i) {
+        EXPECT_EQ(i, x.at<int>((i * 37) % 100));
+        EXPECT_TRUE(x.contains(i));
+    }
+    x.compact();
+    EXPECT_EQ(x, y);
+    x.erase<int>(37);
+    x.remove(59);
+    EXPECT_FALSE(x.count<int>(37));
+    EXPECT_FALSE(x.contains(59));
+    EXPECT_EQ(2, x.at<int>(74));
+    EXPECT_TRUE(x.contains(18));
+}
+
+TEST_F(FlatMultitypeMapTest, ForEach) {
+    int sum = 0;
+    data.for_each<char>([&](short k, char c) {
+        sum += k * (c == 'b' ? 1 : 100);
+    });
+    EXPECT_EQ(4207, sum);
+    data.for_each<double>([&](short, double) {
+        sum = 0;
+    });
+    EXPECT_EQ(4207, sum);
+    sum = 0;
+    data.for_each_key([&](short k) {
+        sum += k;
+    });
+    EXPECT_EQ(5, sum);
+}
+
+TEST_F(FlatMultitypeMapTest, Serialize) {
+    common::osstream os;
+    os << data;
+    common::isstream is(os.data());
+    common::flat_multitype_map<short, int, double, char> x;
+    is >> x;
+    EXPECT_EQ(data, x);
+    EXPECT_EQ(999, x.at<int>(18));
+    EXPECT_TRUE(x.contains(3));
+}
+
+TEST_F(FlatMultitypeMapTest, Print) {
+    std::stringstream ss;
+    ss << data;
+    EXPECT_EQ("(int => {18:999}; double => {}; char => {7:'b', 42:'+'})", ss.str());
+}
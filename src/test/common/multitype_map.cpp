@@ -56,6 +56,15 @@ TEST_F(MultitypeMapTest, Values) {
     EXPECT_EQ('b', data.at<char>(7));
 }
 
+TEST_F(MultitypeMapTest, Clear) {
+    data.clear();
+    EXPECT_EQ((common::multitype_map<short, int, double, char>{}), data);
+    EXPECT_FALSE(data.contains(2));
+    EXPECT_FALSE(data.count<char>(7));
+    data.insert(7, 'c');
+    EXPECT_EQ('c', data.at<char>(7));
+}
+
 TEST_F(MultitypeMapTest, Insert) {
     EXPECT_FALSE(data.count<char>(2));
     EXPECT_FALSE(data.contains(17));
@@ -74,3 +83,20 @@ TEST_F(MultitypeMapTest, Insert) {
     EXPECT_EQ('b', data.at<char>(7));
     EXPECT_EQ('*', data.at<char>(2));
 }
+
+TEST_F(MultitypeMapTest, ForEach) {
+    int sum = 0;
+    data.for_each<char>([&](short k, char c) {
+        sum += k * (c == 'b' ? 1 : 100);
+    });
+    EXPECT_EQ(4207, sum);
+    data.for_each<double>([&](short, double) {
+        sum = 0;
+    });
+    EXPECT_EQ(4207, sum);
+    sum = 0;
+    data.for_each_key([&](short k) {
+        sum += k;
+    });
+    EXPECT_EQ(5, sum);
+}
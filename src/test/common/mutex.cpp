@@ -1,5 +1,8 @@
 // Copyright © 2021 Giorgio Audrito. All Rights Reserved.
 
+#include <algorithm>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "lib/common/algorithm.hpp"
@@ -121,3 +124,38 @@ TEST(MutexTest, Locking) {
         }
     }
 }
+
+template <bool enabled>
+void test_inbox() {
+    common::inbox<enabled, int> q;
+    EXPECT_TRUE(q.empty());
+    q.push(1);
+    q.push(2);
+    EXPECT_FALSE(q.empty());
+    std::vector<int> v{0};
+    q.pop(v);
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(std::vector<int>({0,1,2}), v);
+    common::parallel_for(common::tags::general_execution<enabled>(4), TRIES, [&q] (size_t i, size_t t) {
+        q.push(int(4*i + t));
+    });
+    v.clear();
+    q.pop(v);
+    EXPECT_TRUE(q.empty());
+    EXPECT_EQ(size_t(TRIES), v.size());
+    std::vector<int> w = v;
+    std::sort(w.begin(), w.end());
+    for (int i=0; i<TRIES; ++i) EXPECT_EQ(i, w[i]/4);
+    // values pushed by the same thread keep their order
+    std::vector<int> last(4, -1);
+    for (int x : v) {
+        EXPECT_LT(last[x % 4], x);
+        last[x % 4] = x;
+    }
+    q.push(3);
+}
+
+TEST(MutexTest, Inbox) {
+    test_inbox<false>();
+    test_inbox<true>();
+}
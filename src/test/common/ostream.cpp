@@ -5,6 +5,7 @@
 
 #include "gtest/gtest.h"
 
+#include "lib/common/flat_multitype_map.hpp"
 #include "lib/common/multitype_map.hpp"
 #include "lib/common/ostream.hpp"
 #include "lib/common/random_access_map.hpp"
@@ -47,17 +48,21 @@ TEST(OstreamTest, FCPP) {
     m.insert(42, 'x');
     m.insert(10, false);
     PRINT_EQ("(bool => {10:false}; char => {42:'x'})", m);
+    common::flat_multitype_map<trace_t,bool,char> fm;
+    fm.insert(42, 'x');
+    fm.insert(10, false);
+    PRINT_EQ("(bool => {10:false}; char => {42:'x'})", fm);
     PRINT_EQ("{42:\"hello world\"}", common::random_access_map<int, std::string>{{42, "hello world"}});
     PRINT_EQ("(void => 3; int& => 'x')", common::make_tagged_tuple<void,int&>(3, 'x'));
     PRINT_EQ("(2)", internal::twin<int,true>{2});
     PRINT_EQ("(2; 2)", internal::twin<int,false>{2});
     {
-        internal::context<true, true, int, bool, char> c;
+        internal::context<true, true, false, false, int, bool, char> c;
         c.insert(42, m, 0, 10, 10);
         PRINT_EQ("(42:(bool => {10:false}; char => {42:'x'})@0)", c);
     }
     {
-        internal::context<false, false, int, bool, char> c;
+        internal::context<false, false, false, true, int, bool, char> c;
         c.insert(42, m, 0, 10, 10);
         PRINT_EQ("(42:(bool => {10:false}; char => {42:'x'})@0)", c);
     }
@@ -1,7 +1,10 @@
 // Copyright © 2023 Giorgio Audrito. All Rights Reserved.
 
+#include <limits>
+
 #include "gtest/gtest.h"
 
+#include "lib/common/flat_multitype_map.hpp"
 #include "lib/common/multitype_map.hpp"
 #include "lib/common/ostream.hpp"
 #include "lib/common/plot.hpp"
@@ -30,6 +33,11 @@ void rebuilder(T& y, T&z) {
     EXPECT_EQ((std::vector<char>)os, (std::vector<char>)osx);
     common::isstream is(os);
     is >> z;
+    common::osstream oc(common::encoding::compact);
+    oc << z;
+    common::isstream ic(oc, common::encoding::compact);
+    ic >> z;
+    EXPECT_EQ(0ULL, ic.size());
 }
 
 template <typename T>
@@ -264,6 +272,139 @@ TEST(SerializeTest, Plots) {
     SERIALIZE_CHECK(split, {});
 }
 
+template <typename T>
+size_t serial_size(T const& x) {
+    common::osstream os;
+    os << x;
+    return os.size();
+}
+
+TEST(SerializeTest, Size) {
+    EXPECT_TRUE(bool(common::serialized_size<int>::fixed));
+    EXPECT_EQ(sizeof(int), size_t(common::serialized_size<int>::value));
+    EXPECT_TRUE(bool(common::serialized_size<std::tuple<int,char,std::array<short,3>>>::fixed));
+    EXPECT_EQ(11ULL, size_t(common::serialized_size<std::tuple<int,char,std::array<short,3>>>::value));
+    EXPECT_TRUE(bool(common::serialized_size<std::pair<std::tuple<>,double>>::fixed));
+    EXPECT_EQ(8ULL, size_t(common::serialized_size<std::pair<std::tuple<>,double>>::value));
+    EXPECT_TRUE(bool(common::serialized_size<common::tagged_tuple_t<tag,bool,gat,int>>::fixed));
+    EXPECT_EQ(5ULL, size_t(common::serialized_size<common::tagged_tuple_t<tag,bool,gat,int>>::value));
+    EXPECT_FALSE(bool(common::serialized_size<std::vector<int>>::fixed));
+    EXPECT_FALSE(bool(common::serialized_size<std::tuple<int,std::string>>::fixed));
+    EXPECT_FALSE(bool(common::serialized_size<common::tagged_tuple_t<tag,field<int>>>::fixed));
+    EXPECT_EQ(0ULL, size_t(common::serialized_size<common::tagged_tuple_t<tag,field<int>>>::value));
+    common::tagged_tuple_t<tag,bool,gat,int> tt{true,42};
+    EXPECT_EQ(serial_size(tt), common::serialized_size_of(tt));
+    std::vector<std::tuple<int,char>> v(300);
+    EXPECT_EQ(serial_size(v), common::serialized_size_of(v));
+    std::map<trace_t,std::string> m = {{4, "hello"}, {42, "world!"}};
+    EXPECT_EQ(serial_size(m), common::serialized_size_of(m));
+    std::unordered_map<int, std::pair<std::vector<char>, short>> u = {{2, {{}, 1}}, {3, {{2,3,4}, 2}}};
+    EXPECT_EQ(serial_size(u), common::serialized_size_of(u));
+    field<bool> g = details::make_field<bool>({2, 4}, {false, true, true});
+    common::tagged_tuple_t<tag,field<int>,gat,field<bool>> tf{details::make_field<int>({1,2}, {0,2,3}), g};
+    EXPECT_EQ(serial_size(tf), common::serialized_size_of(tf));
+    common::multitype_map<trace_t, bool, char, int> mm;
+    mm.insert(1, false);
+    mm.insert(4, 4242);
+    EXPECT_EQ(serial_size(mm), common::serialized_size_of(mm));
+    internal::flat_ptr<common::multitype_map<trace_t, double, field<bool>>, false> e;
+    e->insert(1, 4.2);
+    e->insert(3, g);
+    EXPECT_EQ(serial_size(e), common::serialized_size_of(e));
+    common::cstream cs;
+    cs << v << tf;
+    EXPECT_EQ(serial_size(v) + serial_size(tf), cs.size());
+}
+
+TEST(SerializeTest, Compact) {
+    std::tuple<trace_t, device_t, int, short, bool, double> x{300, 5, -3, -200, true, 4.2}, y;
+    common::osstream os(common::encoding::compact);
+    os << x;
+    EXPECT_EQ(2ULL + 1 + 1 + 2 + 1 + 8, os.size());
+    common::cstream cs(common::encoding::compact);
+    cs << x;
+    EXPECT_EQ(os.size(), cs.size());
+    EXPECT_EQ(os.size(), common::serialized_size_of(x, common::encoding::compact));
+    common::isstream is(os.data().data(), os.size(), common::encoding::compact);
+    is >> y;
+    EXPECT_EQ(x, y);
+    std::vector<int> v = {0, -1, 1, -64, 63, -65, 64, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()}, w;
+    common::osstream ov(common::encoding::compact);
+    ov << v;
+    EXPECT_EQ(1ULL + 1 + 1 + 1 + 1 + 1 + 2 + 2 + 5 + 5, ov.size());
+    common::isstream iv(ov.data().data(), ov.size(), common::encoding::compact);
+    iv >> w;
+    EXPECT_EQ(v, w);
+}
+
+TEST(SerializeTest, CompactKeys) {
+    // trace hashes span the whole range: as variable-length integers, they would grow beyond full width
+    constexpr size_t varint = (std::numeric_limits<trace_t>::digits + 6) / 7;
+    common::multitype_map<trace_t, bool, int> m, n;
+    common::flat_multitype_map<trace_t, bool, int> f, g;
+    for (int i = 0; i < 10; ++i) {
+        m.insert(std::numeric_limits<trace_t>::max() - i, i);
+        f.insert(std::numeric_limits<trace_t>::max() - i, i);
+    }
+    m.insert(std::numeric_limits<trace_t>::max() / 2 + 1);
+    f.insert(std::numeric_limits<trace_t>::max() / 2 + 1);
+    size_t full = 1 + 1 + 10 * (sizeof(trace_t) + 1) + 1 + sizeof(trace_t);
+    EXPECT_LT(full, 1 + 1 + 10 * (varint + 1) + 1 + varint);
+    EXPECT_LT(full, common::serialized_size_of(m));
+    common::osstream om(common::encoding::compact);
+    om << m;
+    EXPECT_EQ(full, om.size());
+    EXPECT_EQ(full, common::serialized_size_of(m, common::encoding::compact));
+    common::isstream im(om.data().data(), om.size(), common::encoding::compact);
+    im >> n;
+    EXPECT_EQ(m, n);
+    common::osstream of(common::encoding::compact);
+    of << f;
+    // flat tables prefix both keys and values with their size
+    EXPECT_EQ(full + 2, of.size());
+    EXPECT_EQ(full + 2, common::serialized_size_of(f, common::encoding::compact));
+    common::isstream is(of.data().data(), of.size(), common::encoding::compact);
+    is >> g;
+    EXPECT_EQ(f, g);
+}
+
+TEST(SerializeTest, Buffer) {
+    std::tuple<int, double> x{4, 2.4};
+    common::osstream os;
+    os.reserve(common::serialized_size_of(x));
+    size_t c = os.data().capacity();
+    EXPECT_LE(12ULL, c);
+    os << x;
+    EXPECT_EQ(12ULL, os.size());
+    EXPECT_EQ(c, os.data().capacity());
+    os.clear();
+    EXPECT_EQ(0ULL, os.size());
+    EXPECT_EQ(c, os.data().capacity());
+}
+
+TEST(SerializeTest, Borrowed) {
+    common::tagged_tuple_t<tag,std::string,gat,field<int>> x{"hello", details::make_field<int>({1,2}, {0,2,3})}, y;
+    common::osstream os;
+    os << x << 42;
+    common::isstream is(os.data().data(), os.size());
+    EXPECT_EQ(os.data().data(), is.data());
+    is >> y;
+    EXPECT_EQ(x, y);
+    EXPECT_EQ(sizeof(int), is.size());
+    EXPECT_EQ(os.data().data() + os.size() - sizeof(int), is.data());
+    common::isstream it = std::move(is);
+    int i;
+    it >> i;
+    EXPECT_EQ(42, i);
+    EXPECT_EQ(0ULL, it.size());
+    try {
+        it >> i;
+        EXPECT_TRUE(false);
+    } catch (common::format_error& e) {
+        EXPECT_STREQ(e.what(), "format error in deserialisation");
+    }
+}
+
 TEST(SerializeTest, Error) {
     std::string s = "hello world";
     std::vector<char> v;
@@ -276,4 +417,28 @@ TEST(SerializeTest, Error) {
     } catch (common::format_error& e) {
         EXPECT_STREQ(e.what(), "format error in deserialisation");
     }
+    std::vector<char> w(12, char(255));
+    w.push_back(1);
+    common::isstream iw(w, common::encoding::compact);
+    size_t z;
+    try {
+        common::details::size_variable_read(iw, z);
+        EXPECT_TRUE(false);
+    } catch (common::format_error& e) {
+        EXPECT_STREQ(e.what(), "format error in deserialisation");
+    }
+    std::vector<char> u = {char(255), char(255), char(255), char(255), char(16)};
+    common::isstream iu(u, common::encoding::compact);
+    uint32_t y;
+    try {
+        common::details::size_variable_read(iu, y);
+        EXPECT_TRUE(false);
+    } catch (common::format_error& e) {
+        EXPECT_STREQ(e.what(), "format error in deserialisation");
+    }
+    u.back() = char(15);
+    common::isstream iv(u, common::encoding::compact);
+    common::details::size_variable_read(iv, y);
+    EXPECT_EQ(std::numeric_limits<uint32_t>::max(), y);
+    EXPECT_EQ(std::numeric_limits<size_t>::max(), rebuild_size(std::numeric_limits<size_t>::max()));
 }
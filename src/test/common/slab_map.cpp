@@ -0,0 +1,89 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lib/common/slab_map.hpp"
+
+using namespace fcpp;
+
+
+// Non-movable type counting live instances.
+struct pinned {
+    pinned(int v) : value(v) {
+        ++live;
+    }
+    pinned(pinned const&) = delete;
+    ~pinned() {
+        --live;
+    }
+    int value;
+    std::mutex m;
+    static int live;
+};
+int pinned::live = 0;
+
+
+TEST(SlabMapTest, Access) {
+    {
+        common::slab_map<size_t, pinned> x;
+        EXPECT_TRUE(x.empty());
+        EXPECT_EQ(x.begin(), x.end());
+        for (size_t i=0; i<200; ++i)
+            EXPECT_TRUE(x.emplace(std::piecewise_construct, std::make_tuple(i), std::make_tuple(int(2*i))).second);
+        EXPECT_FALSE(x.emplace(std::piecewise_construct, std::make_tuple(7), std::make_tuple(0)).second);
+        EXPECT_EQ(200, pinned::live);
+        EXPECT_EQ(200ULL, x.size());
+        EXPECT_EQ(200, x.end() - x.begin());
+        EXPECT_EQ(14, x.at(7).value);
+        EXPECT_EQ(7ULL, x.find(7)->first);
+        EXPECT_EQ(x.end(), x.find(200));
+        EXPECT_EQ(0ULL, x.count(1000000));
+        EXPECT_THROW(x.at(1000000), std::out_of_range);
+        pinned* p = &x.at(151);
+        for (size_t i=0; i<200; i+=2) EXPECT_EQ(1ULL, x.erase(i));
+        EXPECT_EQ(0ULL, x.erase(0));
+        EXPECT_EQ(100, pinned::live);
+        EXPECT_EQ(p, &x.at(151));
+        EXPECT_EQ(0ULL, x.count(150));
+        EXPECT_EQ(302, x.at(151).value);
+        int tot = 0;
+        for (auto const& kv : x) tot += kv.second.value - 2*int(kv.first);
+        EXPECT_EQ(0, tot);
+        // sparse keys, later covered by the direct table
+        x.emplace(std::piecewise_construct, std::make_tuple(5000), std::make_tuple(1));
+        x.emplace(std::piecewise_construct, std::make_tuple(size_t(-1)), std::make_tuple(2));
+        for (size_t i=1000; i<3000; ++i)
+            x.emplace(std::piecewise_construct, std::make_tuple(i), std::make_tuple(3));
+        EXPECT_EQ(1, x.at(5000).value);
+        EXPECT_EQ(2, x.at(size_t(-1)).value);
+        EXPECT_EQ(3, x.at(2999).value);
+        EXPECT_EQ(2102ULL, x.size());
+        EXPECT_EQ(1ULL, x.erase(5000));
+        EXPECT_EQ(0ULL, x.count(5000));
+        x.clear();
+        EXPECT_EQ(0, pinned::live);
+        EXPECT_EQ(0ULL, x.count(7));
+        x.emplace(std::piecewise_construct, std::make_tuple(7), std::make_tuple(1));
+    }
+    EXPECT_EQ(0, pinned::live);
+}
+
+TEST(SlabMapTest, Keys) {
+    common::slab_map<int, int> x;
+    x.emplace(-3, 1);
+    x.emplace(3, 2);
+    EXPECT_EQ(1, x.at(-3));
+    EXPECT_EQ(2, x.at(3));
+    common::slab_map<std::string, int> y;
+    y.emplace("foo", 1);
+    y.emplace("bar", 2);
+    EXPECT_EQ(1, y.at("foo"));
+    EXPECT_EQ(1ULL, y.erase("bar"));
+    EXPECT_EQ(1ULL, y.size());
+    EXPECT_EQ("foo", y.begin()->first);
+}
@@ -23,7 +23,21 @@ using combo = component::combine_spec<
         exports<common::export_list<int>>,
         export_pointer<(O & 1) == 1>,
         export_split<(O & 2) == 2>,
-        online_drop<(O & 4) == 4>
+        online_drop<(O & 4) == 4>,
+        export_flat<(O & 8) == 8>,
+        export_index<(O & 16) == 16>
+    >,
+    component::base<>
+>;
+
+template <int O>
+using delta_combo = component::combine_spec<
+    component::calculus<
+        exports<common::export_list<int>>,
+        export_pointer<(O & 1) == 1>,
+        online_drop<(O & 2) == 2>,
+        export_flat<(O & 4) == 4>,
+        export_delta<3>
     >,
     component::base<>
 >;
@@ -35,7 +49,7 @@ void sendto(T const& source, T& dest) {
 }
 
 
-MULTI_TEST(CalculusTest, SizeThreshold, O, 3) {
+MULTI_TEST(CalculusTest, SizeThreshold, O, 5) {
     typename combo<O>::net  network{common::make_tagged_tuple<>()};
     typename combo<O>::node d0{network, common::make_tagged_tuple<uid, hoodsize>(0, device_t(3))};
     typename combo<O>::node d1{network, common::make_tagged_tuple<uid>(1)};
@@ -91,3 +105,17 @@ MULTI_TEST(CalculusTest, SizeThreshold, O, 3) {
     EXPECT_EQ(2, (int)d0.size());
     d0.round_end(0);
 }
+
+MULTI_TEST(CalculusTest, Delta, O, 3) {
+    typename delta_combo<O>::net  network{common::make_tagged_tuple<>()};
+    typename delta_combo<O>::node d0{network, common::make_tagged_tuple<uid>(0)};
+    typename delta_combo<O>::node d1{network, common::make_tagged_tuple<uid>(1)};
+    for (int i = 1; i <= 7; ++i) {
+        d1.round_start(0);
+        d1.round_end(0);
+        if (i != 2) sendto(d1, d0);
+        d0.round_start(0);
+        EXPECT_EQ(i == 2 or i == 3 ? 1 : 2, (int)d0.size());
+        d0.round_end(0);
+    }
+}
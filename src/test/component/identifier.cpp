@@ -1,5 +1,8 @@
 // Copyright © 2021 Giorgio Audrito. All Rights Reserved.
 
+#include <random>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "lib/component/base.hpp"
@@ -56,7 +59,8 @@ using combo1 = component::combine_spec<
     exposer,
     component::identifier<
         parallel<(O & 1) == 1>,
-        synchronised<(O & 2) == 2>
+        synchronised<(O & 2) == 2>,
+        calendar<(O & 4) == 4>
     >,
     component::base<parallel<(O & 1) == 1>>
 >;
@@ -68,13 +72,14 @@ using combo2 = component::combine_spec<
     component::scheduler<round_schedule<seq_per>>,
     component::identifier<
         parallel<(O & 1) == 1>,
-        synchronised<(O & 2) == 2>
+        synchronised<(O & 2) == 2>,
+        calendar<(O & 4) == 4>
     >,
     component::base<parallel<(O & 1) == 1>>
 >;
 
 
-MULTI_TEST(IdentifierTest, Sequential, O, 2) {
+MULTI_TEST(IdentifierTest, Sequential, O, 3) {
     typename combo1<O>::net network{common::make_tagged_tuple<>()};
     EXPECT_EQ(0, (int)network.node_size());
     EXPECT_EQ(0, (int)network.node_count(0));
@@ -100,7 +105,7 @@ MULTI_TEST(IdentifierTest, Sequential, O, 2) {
     EXPECT_EQ(1, (int)network.node_at(1).uid);
 }
 
-MULTI_TEST(IdentifierTest, Customised, O, 2) {
+MULTI_TEST(IdentifierTest, Customised, O, 3) {
     typename combo1<O>::net network{common::make_tagged_tuple<>()};
     EXPECT_EQ(0, (int)network.node_size());
     EXPECT_EQ(0, (int)network.node_count(0));
@@ -127,7 +132,7 @@ MULTI_TEST(IdentifierTest, Customised, O, 2) {
     EXPECT_EQ(24, (int)network.node_at(24).uid);
 }
 
-MULTI_TEST(IdentifierTest, Parallel, O, 2) {
+MULTI_TEST(IdentifierTest, Parallel, O, 3) {
     typename combo2<O>::net network{common::make_tagged_tuple<>()};
     EXPECT_EQ(0, (int)network.node_size());
     EXPECT_EQ(0, (int)network.node_count(0));
@@ -146,3 +151,38 @@ MULTI_TEST(IdentifierTest, Parallel, O, 2) {
     EXPECT_EQ(1, (int)network.node_erase(42));
     EXPECT_EQ(99, (int)network.node_size());
 }
+
+TEST(IdentifierTest, CalendarQueue) {
+    component::details::times_queue<false> q;
+    component::details::calendar_queue c;
+    EXPECT_EQ(TIME_MAX, c.next());
+    EXPECT_EQ(std::vector<device_t>{}, c.pop(100));
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<times_t> dist(0, 1);
+    device_t uid = 0;
+    for (int i=0; i<1000; ++i, ++uid) {
+        times_t t = 10 * dist(gen);
+        q.push(t, uid);
+        c.push(t, uid);
+    }
+    // periodic rescheduling with a few far away events and events in the past
+    for (int i=0; i<100; ++i) {
+        times_t now = c.next();
+        EXPECT_EQ(q.next(), now);
+        std::vector<device_t> v = q.pop(now + 0.5);
+        EXPECT_EQ(v, c.pop(now + 0.5));
+        for (device_t d : v) {
+            times_t t = now + (d % 50 == 0 ? 1000 : 10) * dist(gen);
+            if (d % 7 == 0) continue;
+            q.push(t, d);
+            c.push(t, d);
+        }
+        if (i % 10 == 0) {
+            q.push(now - 1, uid);
+            c.push(now - 1, uid++);
+        }
+    }
+    EXPECT_EQ(q.pop(1e9), c.pop(1e9));
+    EXPECT_EQ(TIME_MAX, c.next());
+    EXPECT_EQ(std::vector<device_t>{}, c.pop(TIME_MAX));
+}
@@ -393,6 +393,33 @@ MULTI_TEST(BasicsTest, NbrUid, O, 3) {
     EXPECT_EQ(2, (int)details::get_ids(d0.nbr_uid()).size());
 }
 
+MULTI_TEST(BasicsTest, SharedDomain, O, 3) {
+    typename combo<O>::net  network{common::make_tagged_tuple<>()};
+    typename combo<O>::node d0{network, common::make_tagged_tuple<uid>(0)};
+    typename combo<O>::node d1{network, common::make_tagged_tuple<uid>(1)};
+    typename combo<O>::node d2{network, common::make_tagged_tuple<uid>(2)};
+    d0.round_start(0);
+    d1.round_start(0);
+    d2.round_start(0);
+    size_t v = details::get_ids(d0.nbr_uid()).version();
+    for (int i = 0; i < 2; ++i) {
+        coordination::nbr(d0, 0, 1);
+        coordination::nbr(d1, 0, 2);
+        coordination::nbr(d2, 0, 3);
+        coordination::count_hood(d0, 1);
+        coordination::count_hood(d1, 1);
+        coordination::count_hood(d2, 1);
+        sendall(d0, d1, d2);
+    }
+    details::domain const& d = details::get_ids(d0.nbr_uid());
+    EXPECT_LT(v, d.version());
+    field<int> f = coordination::nbr(d0, 0, 1);
+    EXPECT_TRUE(details::get_ids(f).same(d));
+    field<int> g = coordination::align(d0, 1, f + d0.nbr_uid());
+    EXPECT_TRUE(details::get_ids(g).same(d));
+    EXPECT_EQ(5, details::self(g, 2));
+}
+
 MULTI_TEST(BasicsTest, CountHood, O, 3) {
     test_net<combo<O>, std::tuple<int>(int)> n{
         [&](auto& node, int value){
@@ -218,6 +218,62 @@ TEST_F(FieldTest, AlignInplace) {
     FIELD_EQ(ttex, ttres);
 }
 
+TEST_F(FieldTest, SharedDomain) {
+    details::domain d = details::domain::stamp({1,2,3});
+    details::domain e = details::domain::stamp({1,2,3});
+    EXPECT_LT(0ULL, d.version());
+    EXPECT_LT(d.version(), e.version());
+    EXPECT_FALSE(d.same(e));
+    EXPECT_EQ(d, e);
+    field<int> f = details::make_field(d, std::vector<int>{0,1,2,3});
+    field<int> g = details::make_field(d, std::vector<int>{1,4,5,6});
+    field<int> h = f + g;
+    EXPECT_TRUE(details::get_ids(h).same(d));
+    FIELD_EQ(h, build_field(1, {{1,5},{2,7},{3,9}}));
+    f += g;
+    EXPECT_TRUE(details::get_ids(f).same(d));
+    FIELD_EQ(f, h);
+    field<int> r = details::align(fi1, d);
+    EXPECT_FALSE(details::get_ids(r).same(d));
+    FIELD_EQ(r, build_field(2, {{1,1},{3,-1}}));
+    details::align_inplace(r, d);
+    EXPECT_TRUE(details::get_ids(r).same(d));
+    FIELD_EQ(r, build_field(2, {{1,1},{2,2},{3,-1}}));
+    details::self(r, 4) = 4;
+    EXPECT_FALSE(details::get_ids(r).same(d));
+    EXPECT_EQ(0ULL, details::get_ids(r).version());
+    EXPECT_EQ(details::domain({1,2,3}), d);
+    r = details::align(r, d);
+    EXPECT_TRUE(details::get_ids(r).same(d));
+    FIELD_EQ(r, build_field(2, {{1,1},{2,2},{3,-1}}));
+}
+
+TEST_F(FieldTest, FieldBuilder) {
+    details::field_builder<int> b(2);
+    FIELD_EQ(b.build(), field<int>(2));
+    b.insert(3, -1);
+    b.insert(1, 1);
+    b.insert(3, 5);
+    EXPECT_EQ(3ULL, b.pending());
+    FIELD_EQ(b.build(), build_field(2, {{1,1},{3,5}}));
+    EXPECT_EQ(0ULL, b.pending());
+    b.insert(2, 4);
+    b.insert(1, 0);
+    b.insert(7, 3);
+    FIELD_EQ(b.build(), build_field(2, {{1,0},{2,4},{3,5},{7,3}}));
+    details::align_inplace(b.build(), {2,3});
+    b.insert(4, 6);
+    b.insert(3, 1);
+    b.insert(3, 8);
+    details::field_builder<int> const& c = b;
+    FIELD_EQ(c.merged(), build_field(2, {{2,4},{3,8},{4,6}}));
+    EXPECT_EQ(8, c.self(3));
+    EXPECT_EQ(4, c.self(2));
+    EXPECT_EQ(2, c.self(5));
+    EXPECT_EQ(3ULL, b.pending());
+    FIELD_EQ(b.build(), build_field(2, {{2,4},{3,8},{4,6}}));
+}
+
 TEST_F(FieldTest, ModOther) {
     field<int> fin, fex, fres;
     fin = build_field(2, {{1,1},{3,-1}});
@@ -323,6 +379,89 @@ TEST_F(FieldTest, MapReduce) {
     EXPECT_EQ(make_tuple(5,8), g);
 }
 
+TEST_F(FieldTest, SharedFold) {
+    std::vector<device_t> ids;
+    std::vector<int> vals{0};
+    for (int i = 0; i < 11; ++i) {
+        ids.push_back(2*i);
+        vals.push_back(i*(i-5));
+    }
+    details::domain d = details::domain::stamp(std::move(ids));
+    field<int> f = details::make_field(d, std::move(vals));
+    auto sum = [] (int x, int y) { return x+y; };
+    auto min = [] (int x, int y) { return std::min(x,y); };
+    for (size_t n = 1; n <= d.size(); ++n) {
+        details::domain e(std::vector<device_t>(d.begin(), d.begin()+n));
+        field<int> g = details::align(constify(f), e);
+        EXPECT_TRUE(details::get_ids(g).same(e));
+        EXPECT_EQ(details::fold_hood(sum, f, e), details::fold_hood(sum, g, e));
+        EXPECT_EQ(details::fold_hood(min, f, e), details::fold_hood(min, g, e));
+        EXPECT_EQ(details::fold_hood(sum, f, -1, e, 0), details::fold_hood(sum, g, -1, e, 0));
+        EXPECT_EQ(details::fold_hood(min, f, 3, e, 0), details::fold_hood(min, g, 3, e, 0));
+        EXPECT_EQ(details::fold_hood(sum, f, -1, e, e[n-1]), details::fold_hood(sum, g, -1, e, e[n-1]));
+        EXPECT_EQ(details::fold_hood([] (device_t i, int x, int y) {
+            return int(i)*x + y;
+        }, f, e), details::fold_hood([] (device_t i, int x, int y) {
+            return int(i)*x + y;
+        }, g, e));
+    }
+    EXPECT_EQ(110, details::fold_hood(sum, f, d));
+    EXPECT_EQ(-6, details::fold_hood(min, f, d));
+    EXPECT_EQ(70, details::fold_hood(sum, f, 10, d, 20));
+    // non-associative operators fold in the same order on shared and copied domains
+    std::vector<double> xs{0};
+    for (int i = 0; i < 12; ++i) xs.push_back(i*i*3.7 - i*11.3);
+    details::domain h(std::vector<device_t>{0,1,2,3,4,5,6,7,8,9,10,11});
+    details::domain k(std::vector<device_t>(h.begin(), h.end()));
+    field<double> fs = details::make_field(h, std::vector<double>(xs));
+    field<double> fc = details::make_field(k, std::vector<double>(xs));
+    EXPECT_TRUE(details::get_ids(fs).same(h));
+    EXPECT_FALSE(details::get_ids(fc).same(h));
+    auto avg = [] (double x, double r) { return (x+r)/2; };
+    EXPECT_EQ(details::fold_hood(avg, fc, h), details::fold_hood(avg, fs, h));
+    EXPECT_EQ(details::fold_hood(avg, fc, 0.5, h, 7), details::fold_hood(avg, fs, 0.5, h, 7));
+}
+
+TEST_F(FieldTest, KernelFold) {
+    EXPECT_SAME(details::fold_kernel<details::fold_min<int>, int, int>::type, details::fold_lanes);
+    EXPECT_SAME(details::fold_kernel<details::fold_sum<long>, long, long>::type, details::fold_unsigned_lanes);
+    EXPECT_SAME(details::fold_kernel<details::fold_any<bool>, bool, bool>::type, details::fold_find_true);
+    EXPECT_SAME(details::fold_kernel<details::fold_sum<double>, double, double>::type, details::fold_sequential);
+    std::vector<device_t> ids;
+    std::vector<int> ivals{0};
+    std::vector<bool> bvals{false};
+    for (int i = 0; i < 53; ++i) {
+        ids.push_back(i);
+        ivals.push_back((i*7919) % 101 - 50);
+        bvals.push_back(i != 40);
+    }
+    details::domain d = details::domain::stamp(std::move(ids));
+    field<int> fi = details::make_field(d, std::move(ivals));
+    field<bool> fb = details::make_field(d, std::move(bvals));
+    for (size_t n = 1; n <= d.size(); ++n) {
+        details::domain e(std::vector<device_t>(d.begin(), d.begin()+n));
+        field<int> gi = details::align(constify(fi), e);
+        field<bool> gb = details::align(constify(fb), e);
+        field<int> hi = details::make_field(std::vector<device_t>(e.begin(), e.end()), std::vector<int>(details::get_vals(gi)));
+        field<bool> hb = details::make_field(std::vector<device_t>(e.begin(), e.end()), std::vector<bool>(details::get_vals(gb)));
+        EXPECT_FALSE(details::get_ids(hi).same(e));
+        device_t i = e[n/2];
+        EXPECT_EQ(details::fold_hood(details::fold_min<int>{}, hi, e), details::fold_hood(details::fold_min<int>{}, gi, e));
+        EXPECT_EQ(details::fold_hood(details::fold_max<int>{}, hi, e), details::fold_hood(details::fold_max<int>{}, gi, e));
+        EXPECT_EQ(details::fold_hood(details::fold_sum<int>{}, hi, e), details::fold_hood(details::fold_sum<int>{}, gi, e));
+        EXPECT_EQ(details::fold_hood(details::fold_all<int>{}, hi, e), details::fold_hood(details::fold_all<int>{}, gi, e));
+        EXPECT_EQ(details::fold_hood(details::fold_min<int>{}, hi, 7, e, i), details::fold_hood(details::fold_min<int>{}, gi, 7, e, i));
+        EXPECT_EQ(details::fold_hood(details::fold_max<int>{}, hi, 7, e, i), details::fold_hood(details::fold_max<int>{}, gi, 7, e, i));
+        EXPECT_EQ(details::fold_hood(details::fold_sum<int>{}, hi, -9, e, i), details::fold_hood(details::fold_sum<int>{}, gi, -9, e, i));
+        EXPECT_EQ(details::fold_hood(details::fold_all<bool>{}, hb, e), details::fold_hood(details::fold_all<bool>{}, gb, e));
+        EXPECT_EQ(details::fold_hood(details::fold_any<bool>{}, hb, e), details::fold_hood(details::fold_any<bool>{}, gb, e));
+        EXPECT_EQ(details::fold_hood(details::fold_min<bool>{}, hb, true, e, i), details::fold_hood(details::fold_min<bool>{}, gb, true, e, i));
+        EXPECT_EQ(details::fold_hood(details::fold_max<bool>{}, hb, false, e, i), details::fold_hood(details::fold_max<bool>{}, gb, false, e, i));
+    }
+    EXPECT_FALSE(details::fold_hood(details::fold_all<bool>{}, fb, d));
+    EXPECT_TRUE(details::fold_hood(details::fold_all<bool>{}, fb, true, d, 40));
+}
+
 TEST_F(FieldTest, UnaryOperators) {
     field<bool> eq = !fb1;
     EXPECT_FALSE(details::other(eq));
@@ -367,6 +506,23 @@ TEST_F(FieldTest, BinaryOperators) {
     EXPECT_TRUE(eq);
     eq = (fi2 % 2) == build_field(1, {{1,0},{2,1}});
     EXPECT_TRUE(eq);
+    field<int> t = fi1 * 2;
+    int const* p = details::get_vals(t).data();
+    field<int> u = fi1 + std::move(t);
+    EXPECT_EQ(p, details::get_vals(u).data());
+    eq = u == build_field(6, {{1,3},{3,-3}});
+    EXPECT_TRUE(eq);
+    u = 1 - std::move(u);
+    EXPECT_EQ(p, details::get_vals(u).data());
+    eq = u == build_field(-5, {{1,-2},{3,4}});
+    EXPECT_TRUE(eq);
+    u = (fi1 * 2) - std::move(u);
+    eq = u == build_field(9, {{1,4},{3,-6}});
+    EXPECT_TRUE(eq);
+    eq = (fi1 < std::move(u)) == build_field(true, {{1,true},{3,false}});
+    EXPECT_TRUE(eq);
+    eq = (fi2 + (fi1 * 2)) == build_field(5, {{1,6},{2,7},{3,-1}});
+    EXPECT_TRUE(eq);
     double d = details::fold_hood([] (double i, double j) {return i+j;}, fd / fi1, {0,1,2,3});
     EXPECT_DOUBLE_EQ(1.875, d);
     tuple<field<int>, double> x{{1}, 2.5};
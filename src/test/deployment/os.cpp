@@ -0,0 +1,147 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lib/common/mutex.hpp"
+#include "lib/deployment/os.hpp"
+
+using namespace fcpp;
+
+using clock_type = std::chrono::steady_clock;
+
+
+// State shared by a mock transceiver with the test.
+struct mock_state {
+    // Number of failures before a send succeeds.
+    int failures = 0;
+
+    common::mutex<true> mutex;
+
+    // Times and attempt counters of the sends.
+    std::vector<clock_type::time_point> times;
+    std::vector<int> attempts;
+
+    // Number of receives performed.
+    std::atomic<int> receives{0};
+
+    size_t sends() {
+        common::lock_guard<true> l(mutex);
+        return times.size();
+    }
+};
+
+// Non-blocking transceiver recording sends, and failing the first ones.
+struct mock_transceiver {
+    using data_type = mock_state*;
+
+    data_type data;
+
+    mock_transceiver(data_type d) : data(d) {}
+
+    bool send(device_t, std::vector<char> const&, int attempt) {
+        common::lock_guard<true> l(data->mutex);
+        data->times.push_back(clock_type::now());
+        data->attempts.push_back(attempt);
+        return (int)data->times.size() > data->failures;
+    }
+
+    message_type receive(int) {
+        ++data->receives;
+        return {};
+    }
+};
+
+// Node interface required by networks.
+struct fake_node {
+    struct {
+        times_t internal_time() const {
+            return 0;
+        }
+    } net;
+
+    device_t uid = 1;
+
+    void receive(message_type&) {}
+};
+
+using network_type = os::async_retry_network<true, mock_transceiver>::network<fake_node>;
+
+// Waits until a number of sends has been performed (or too much time passed).
+void wait_sends(mock_state& s, size_t n) {
+    for (int i = 0; i < 1000 and s.sends() < n; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+
+TEST(OSTest, WakeOnSend) {
+    fake_node n;
+    mock_state s;
+    network_type net(n, &s);
+    int fast = 0;
+    for (size_t i = 0; i < 10; ++i) {
+        // let the network thread fall asleep for a poll period
+        std::this_thread::sleep_for(network_type::idle_period + std::chrono::milliseconds(3*i));
+        std::vector<char> m{'a', 'b'};
+        clock_type::time_point t = clock_type::now();
+        net.send(m);
+        wait_sends(s, i+1);
+        ASSERT_EQ(i+1, s.sends());
+        common::lock_guard<true> l(s.mutex);
+        if (s.times.back() - t < std::chrono::milliseconds(2)) ++fast;
+    }
+    // without waking up, only one send in eight would be this fast
+    EXPECT_LE(8, fast);
+}
+
+TEST(OSTest, Backoff) {
+    fake_node n;
+    mock_state s;
+    s.failures = 5;
+    {
+        network_type net(n, &s);
+        std::vector<char> m{'a'};
+        net.send(m);
+        wait_sends(s, 6);
+        std::this_thread::sleep_for(network_type::retry_max_period);
+    }
+    ASSERT_EQ(6ULL, s.times.size());
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5}), s.attempts);
+    clock_type::duration wait = network_type::retry_period;
+    for (size_t i = 1; i < s.times.size(); ++i) {
+        EXPECT_LE(wait, s.times[i] - s.times[i-1]);
+        wait = std::min<clock_type::duration>(2 * wait, network_type::retry_max_period);
+    }
+    EXPECT_GT(std::chrono::seconds(1), s.times.back() - s.times.front());
+}
+
+TEST(OSTest, Shutdown) {
+    fake_node n;
+    int fast = 0;
+    for (int i = 0; i < 5; ++i) {
+        mock_state s;
+        s.failures = 1000;
+        clock_type::time_point t;
+        {
+            network_type net(n, &s);
+            std::vector<char> m{'a'};
+            net.send(m);
+            // waiting for the next retry or poll
+            std::this_thread::sleep_for(std::chrono::milliseconds(40));
+            t = clock_type::now();
+        }
+        if (clock_type::now() - t < std::chrono::milliseconds(2)) ++fast;
+        size_t k = s.times.size();
+        EXPECT_LT(0ULL, k);
+        EXPECT_LT(0, s.receives.load());
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        EXPECT_EQ(k, s.times.size());
+    }
+    // without waking up, shutting down would take up to a poll period
+    EXPECT_LE(4, fast);
+}
@@ -53,7 +53,7 @@ using seq_per = sequence::periodic<distribution::constant_n<times_t, 15, 10>, di
 template <int O>
 using combo1 = component::combine_spec<
     component::scheduler<round_schedule<seq_per>>,
-    component::persister<tuple_store<tag,bool,gat,int>>,
+    component::persister<tuple_store<tag,bool,gat,int>, compact_encoding<(O & 8) == 8>>,
     component::calculus<
         program<main>,
         exports<common::export_list<int>>,
@@ -67,7 +67,7 @@ using combo1 = component::combine_spec<
 >;
 
 
-MULTI_TEST(PersisterTest, Main, O, 3) {
+MULTI_TEST(PersisterTest, Main, O, 4) {
     remove(".persistence");
     {
         typename combo1<O>::net network{common::make_tagged_tuple<persistence_path>(".persistence")};
@@ -0,0 +1,168 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lib/common/mutex.hpp"
+#include "lib/deployment/udp_transceiver.hpp"
+
+using namespace fcpp;
+
+
+#ifdef __linux__
+
+// Settings for transceivers on a port specific to the test process.
+os::udp_transceiver::data_type settings(std::string address) {
+    os::udp_transceiver::data_type d;
+    d.address = address;
+    d.port = 40000 + getpid() % 20000;
+    d.datagram_size = 256;
+    return d;
+}
+
+// Waits until a message is received (or too many attempts failed).
+message_type wait_receive(os::udp_transceiver& t) {
+    message_type m;
+    for (int i = 0; i < 250 and m.content.empty(); ++i)
+        m = t.receive(0);
+    return m;
+}
+
+// Node interface required by networks.
+struct fake_node {
+    struct {
+        times_t internal_time() const {
+            return 0;
+        }
+    } net;
+
+    device_t uid;
+
+    void receive(message_type& m) {
+        common::lock_guard<true> l(mutex);
+        messages.push_back(m);
+    }
+
+    common::mutex<true> mutex;
+
+    std::vector<message_type> messages;
+};
+
+
+TEST(UdpTransceiverTest, Exchange) {
+    for (std::string address : {"127.255.255.255", "239.255.0.1"}) {
+        os::udp_transceiver a(settings(address)), b(settings(address)), c(settings(address));
+        std::vector<char> m(1000);
+        for (size_t i = 0; i < m.size(); ++i) m[i] = i * 7;
+        EXPECT_TRUE(a.send(1, m, 0));
+        for (os::udp_transceiver* t : {&b, &c}) {
+            message_type r = wait_receive(*t);
+            EXPECT_EQ(1, (int)r.device);
+            EXPECT_EQ(m, r.content);
+        }
+        EXPECT_TRUE(b.send(2, {'x'}, 0));
+        EXPECT_TRUE(c.send(3, {'y', 'z'}, 0));
+        std::vector<int> devices;
+        for (int i = 0; i < 2; ++i) {
+            message_type r = wait_receive(a);
+            devices.push_back(r.device);
+            EXPECT_EQ(r.device == 2 ? std::vector<char>(1, 'x') : std::vector<char>({'y', 'z'}), r.content);
+        }
+        std::sort(devices.begin(), devices.end());
+        EXPECT_EQ(std::vector<int>({2, 3}), devices);
+        EXPECT_TRUE(a.receive(0).content.empty());
+        EXPECT_EQ(2, (int)wait_receive(c).device);
+        EXPECT_TRUE(c.receive(0).content.empty());
+    }
+}
+
+TEST(UdpTransceiverTest, Wire) {
+    os::udp_transceiver::data_type d = settings("127.255.255.255");
+    os::udp_transceiver t(d);
+    int s = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_LE(0, s);
+    int one = 1;
+    ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    timeval timeout{1, 0};
+    ::setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(d.port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    ASSERT_LE(0, ::bind(s, reinterpret_cast<sockaddr*>(&local), sizeof(local)));
+    EXPECT_TRUE(t.send(0x0102, {'a', 'b', 'c'}, 0));
+    char buf[64];
+    ASSERT_EQ(int(os::udp_transceiver::header_size) + 3, (int)::recv(s, buf, sizeof(buf), 0));
+    std::vector<char> header(buf, buf + os::udp_transceiver::header_size);
+    // uid, total size, offset, sequence number, index and number of fragments, most significant byte first
+    EXPECT_EQ(std::vector<char>({0,0,0,0,0,0,1,2, 0,0,0,3, 0,0,0,0, 0,1, 0,0, 0,1}), header);
+    EXPECT_EQ(std::vector<char>({'a', 'b', 'c'}), std::vector<char>(buf + os::udp_transceiver::header_size, buf + os::udp_transceiver::header_size + 3));
+    ::close(s);
+    // messages needing too many fragments are discarded
+    d.datagram_size = os::udp_transceiver::header_size + 1;
+    os::udp_transceiver u(d);
+    EXPECT_EQ(0ULL, u.dropped());
+    EXPECT_TRUE(u.send(1, std::vector<char>(UINT16_MAX + 1), 0));
+    EXPECT_EQ(1ULL, u.dropped());
+}
+
+TEST(UdpTransceiverTest, Network) {
+    using network_t = os::async_retry_network<true, os::udp_transceiver>::network<fake_node>;
+    fake_node n1, n2;
+    n1.uid = 1;
+    n2.uid = 2;
+    network_t net1(n1, settings("127.255.255.255")), net2(n2, settings("127.255.255.255"));
+    std::vector<char> m(600, 'a');
+    net1.send(m);
+    for (int i = 0; i < 100; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        common::lock_guard<true> l(n2.mutex);
+        if (n2.messages.size()) break;
+    }
+    common::lock_guard<true> l1(n1.mutex), l2(n2.mutex);
+    EXPECT_EQ(0ULL, n1.messages.size());
+    ASSERT_EQ(1ULL, n2.messages.size());
+    EXPECT_EQ(1, (int)n2.messages[0].device);
+    EXPECT_EQ(std::vector<char>(600, 'a'), n2.messages[0].content);
+}
+
+TEST(UdpTransceiverTest, Latency) {
+    using clock_type = std::chrono::steady_clock;
+    using network_t = os::async_retry_network<true, os::udp_transceiver>::network<fake_node>;
+    fake_node n;
+    n.uid = 2;
+    network_t net(n, settings("127.255.255.255"));
+    os::udp_transceiver t(settings("127.255.255.255"));
+    std::vector<clock_type::duration> latency;
+    for (int i = 0; i < 21; ++i) {
+        // sending at different phases of the network thread loop
+        std::this_thread::sleep_for(std::chrono::microseconds(3000 + 700 * i));
+        clock_type::time_point start = clock_type::now();
+        EXPECT_TRUE(t.send(1, {'a', char(i)}, 0));
+        for (int j = 0; j < 10000; ++j) {
+            common::lock_guard<true> l(n.mutex);
+            if (n.messages.size() > latency.size()) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        latency.push_back(clock_type::now() - start);
+    }
+    common::lock_guard<true> l(n.mutex);
+    ASSERT_EQ(21ULL, n.messages.size());
+    std::sort(latency.begin(), latency.end());
+    // the idle period only applies to non-blocking transceivers
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::microseconds>(latency[10]).count(), 2000);
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "gtest/gtest.h"
 
+#include "lib/common/flat_multitype_map.hpp"
 #include "lib/common/multitype_map.hpp"
 #include "lib/internal/context.hpp"
 
@@ -33,25 +34,48 @@ struct metric {
 };
 
 template <int O>
-using context_type = internal::context<(O & 2) != 2, (O & 1) == 1, double, fcpp::field<int>, char>;
+using context_type = internal::context<(O & 2) != 2, (O & 1) == 1, (O & 4) == 4, (O & 8) == 8, double, fcpp::field<int>, char>;
+
 
 class ContextTest : public ::testing::Test {
   protected:
     virtual void SetUp() {
-        m.insert(7, 'a');
-        m.insert(42,'+');
-        m.insert(3,  details::make_field({0,6}, std::vector<int>{1,3,4}));
-        m.insert(18, details::make_field({1,9}, std::vector<int>{9,2,2}));
-        m.insert(8);
+        insert(7, 'a');
+        insert(42,'+');
+        insert(3,  details::make_field({0,6}, std::vector<int>{1,3,4}));
+        insert(18, details::make_field({1,9}, std::vector<int>{9,2,2}));
+        insert(8);
+    }
+
+    // inserts into both hashed and flat exports
+    template <typename... Ts>
+    void insert(Ts const&... xs) {
+        m.insert(xs...);
+        f.insert(xs...);
+    }
+
+    // the export matching the context type
+    template <int O>
+    typename context_type<O>::export_type::value_type const& exports() const {
+        return get_export(common::number_sequence<(O & 4) == 4>{});
+    }
+
+    common::multitype_map<trace_t, fcpp::field<int>, char> const& get_export(common::number_sequence<false>) const {
+        return m;
+    }
+
+    common::flat_multitype_map<trace_t, fcpp::field<int>, char> const& get_export(common::number_sequence<true>) const {
+        return f;
     }
 
     common::multitype_map<trace_t, fcpp::field<int>, char> m;
+    common::flat_multitype_map<trace_t, fcpp::field<int>, char> f;
 };
 
 
-MULTI_TEST_F(ContextTest, Operators, O, 2) {
+MULTI_TEST_F(ContextTest, Operators, O, 4) {
     context_type<O> data;
-    data.insert(1, m, 0.5, 1.5, 9);
+    data.insert(1, exports<O>(), 0.5, 1.5, 9);
     context_type<O> x(data), y, z;
     z = y;
     y = x;
@@ -61,9 +85,9 @@ MULTI_TEST_F(ContextTest, Operators, O, 2) {
 
 MULTI_TEST_F(ContextTest, InsertErase, O, 1) {
     context_type<O> x;
-    x.insert(1, m, 0.5, 1.5, 9);
-    x.insert(2, m, 0.3, 1.5, 9);
-    x.insert(3, m, 0.4, 1.5, 9);
+    x.insert(1, exports<O>(), 0.5, 1.5, 9);
+    x.insert(2, exports<O>(), 0.3, 1.5, 9);
+    x.insert(3, exports<O>(), 0.4, 1.5, 9);
     EXPECT_EQ(size_t(3), x.size(1));
     EXPECT_EQ(size_t(4), x.size(0));
     EXPECT_EQ(device_t(1), x.top());
@@ -74,7 +98,7 @@ MULTI_TEST_F(ContextTest, InsertErase, O, 1) {
     x.freeze(10, 0);
     x.unfreeze(0, metric{0.5}, 1.0);
     EXPECT_EQ(device_t(2), x.top());
-    x.insert(3, m, 0.4, 1.5, 9);
+    x.insert(3, exports<O>(), 0.4, 1.5, 9);
     EXPECT_EQ(device_t(2), x.top());
     x.pop();
     EXPECT_EQ(device_t(3), x.top());
@@ -83,11 +107,39 @@ MULTI_TEST_F(ContextTest, InsertErase, O, 1) {
     EXPECT_EQ(size_t(1), x.size(9));
 }
 
-MULTI_TEST_F(ContextTest, Align, O, 2) {
+MULTI_TEST_F(ContextTest, UpdateEvict, O, 1) {
+    context_type<O> x;
+    for (device_t d = 1; d <= 6; ++d)
+        x.insert(d, exports<O>(), 0.1 * d, 1.5, 4);
+    EXPECT_EQ(size_t(4), x.size(1));
+    EXPECT_EQ(device_t(4), x.top());
+    EXPECT_FALSE(x.accepts(5, 0.5, 1.5, 4));
+    EXPECT_TRUE(x.accepts(7, 0.25, 1.5, 4));
+    EXPECT_TRUE(x.accepts(1, 0.9, 1.5, 4));
+    EXPECT_FALSE(x.accepts(1, 2.0, 1.5, 4));
+    EXPECT_TRUE(x.accepts(8, 0.5, 1.5, 5));
+    x.insert(1, exports<O>(), 0.9, 1.5, 4);
+    EXPECT_EQ(device_t(1), x.top());
+    x.insert(1, exports<O>(), 0.05, 1.5, 4);
+    EXPECT_EQ(device_t(4), x.top());
+    x.insert(7, exports<O>(), 0.25, 1.5, 4);
+    EXPECT_EQ(size_t(4), x.size(1));
+    EXPECT_EQ(device_t(3), x.top());
+    x.insert(8, exports<O>(), 2.0, 1.5, 4);
+    EXPECT_EQ(size_t(4), x.size(1));
+    x.pop();
+    EXPECT_EQ(device_t(7), x.top());
+    x.pop();
+    EXPECT_EQ(device_t(2), x.top());
+    x.pop();
+    EXPECT_EQ(device_t(1), x.top());
+}
+
+MULTI_TEST_F(ContextTest, Align, O, 4) {
     context_type<O> data;
-    data.insert(1, m, 0.5, 1.5, 9);
-    m.insert(9);
-    data.insert(2, m, 1.0, 1.5, 9);
+    data.insert(1, exports<O>(), 0.5, 1.5, 9);
+    insert(9);
+    data.insert(2, exports<O>(), 1.0, 1.5, 9);
     data.freeze(9, 0);
     std::vector<device_t> ex, res;
     ex = std::vector<device_t>{0,1,2};
@@ -99,28 +151,28 @@ MULTI_TEST_F(ContextTest, Align, O, 2) {
     data.unfreeze(0, metric{}, 1.5);
 }
 
-MULTI_TEST_F(ContextTest, Old, O, 2) {
+MULTI_TEST_F(ContextTest, Old, O, 4) {
     char c;
     context_type<O> data;
-    data.insert(1, m, 0.5, 1.5, 9);
+    data.insert(1, exports<O>(), 0.5, 1.5, 9);
     data.freeze(9, 0);
     c = data.old(7, 'c', 0);
     EXPECT_EQ('c', c);
     data.unfreeze(0, metric{}, 1.5);
-    data.insert(0, m, 1.0, 1.5, 9);
+    data.insert(0, exports<O>(), 1.0, 1.5, 9);
     data.freeze(9, 0);
     c = data.old(7, 'c', 0);
     EXPECT_EQ('a', c);
     data.unfreeze(0, metric{}, 1.5);
 }
 
-MULTI_TEST_F(ContextTest, Nbr, O, 2) {
+MULTI_TEST_F(ContextTest, Nbr, O, 4) {
     context_type<O> data;
-    data.insert(1, m, 0.5, 1.5, 9);
-    m.insert(42, '-');
-    m.insert(3,  details::make_field({0,5}, std::vector<int>{1,2,9}));
-    m.insert(18, details::make_field({0,5}, std::vector<int>{1,3,7}));
-    data.insert(2, m, 1.0, 1.5, 9);
+    data.insert(1, exports<O>(), 0.5, 1.5, 9);
+    insert(42, '-');
+    insert(3,  details::make_field({0,5}, std::vector<int>{1,2,9}));
+    insert(18, details::make_field({0,5}, std::vector<int>{1,3,7}));
+    data.insert(2, exports<O>(), 1.0, 1.5, 9);
     data.freeze(9, 0);
     fcpp::field<char> fcr, fce;
     fcr = data.nbr(42, '*', 0);
@@ -0,0 +1,178 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lib/common/flat_multitype_map.hpp"
+#include "lib/common/multitype_map.hpp"
+#include "lib/common/serialize.hpp"
+#include "lib/data/field.hpp"
+#include "lib/internal/export_codec.hpp"
+#include "lib/internal/flat_ptr.hpp"
+
+#include "test/helper.hpp"
+
+using namespace fcpp;
+
+
+template <int O>
+using map_type = std::conditional_t<(O & 2) == 2, common::flat_multitype_map<trace_t, int, char>, common::multitype_map<trace_t, int, char>>;
+
+template <int O>
+using export_type = internal::flat_ptr<map_type<O>, (O & 1) == 1>;
+
+template <int O>
+export_type<O> make_export(int i) {
+    export_type<O> e;
+    e->insert(1, 'a');
+    e->insert(2, i);
+    e->insert(3, i / 2);
+    if (i % 2) e->insert(4, 'b');
+    else e->insert(4, 5);
+    if (i % 3) e->insert(5);
+    e->insert(6);
+    return e;
+}
+
+
+MULTI_TEST(ExportCodecTest, Delta, O, 2) {
+    internal::export_delta<export_type<O>> d;
+    EXPECT_TRUE(d.keyframe());
+    map_type<O> x = *make_export<O>(2), y = *make_export<O>(3);
+    d.encode(7, x, y);
+    EXPECT_FALSE(d.keyframe());
+    EXPECT_EQ(7U, d.seq());
+    EXPECT_EQ(std::vector<trace_t>({4, 5}), d.removed());
+    EXPECT_FALSE(d.values().template count<char>(1));
+    EXPECT_EQ(3, d.values().template at<int>(2));
+    EXPECT_TRUE(d.values().template count<int>(3) == 0);
+    EXPECT_EQ('b', d.values().template at<char>(4));
+    EXPECT_FALSE(d.values().contains(5));
+    EXPECT_FALSE(d.values().contains(6));
+    d.patch(x);
+    EXPECT_EQ(y, x);
+    common::osstream os;
+    os << d;
+    common::isstream is(os.data());
+    internal::export_delta<export_type<O>> e;
+    is >> e;
+    EXPECT_EQ(d, e);
+}
+
+MULTI_TEST(ExportCodecTest, Full, O, 2) {
+    internal::export_codec<export_type<O>, 0> sender, receiver;
+    export_type<O> e = make_export<O>(1);
+    sender.encode(e);
+    export_type<O> const* r = receiver.decode(42, sender.message(e), 0);
+    ASSERT_NE(nullptr, r);
+    EXPECT_EQ(*e, **r);
+}
+
+MULTI_TEST(ExportCodecTest, Stream, O, 2) {
+    internal::export_codec<export_type<O>, 3> sender, receiver;
+    export_type<O> const* r = receiver.decode(42, sender.message({}), 0);
+    ASSERT_NE(nullptr, r);
+    EXPECT_EQ(map_type<O>{}, **r);
+    for (int i = 1; i <= 10; ++i) {
+        export_type<O> e = make_export<O>(i);
+        sender.encode(e);
+        EXPECT_EQ(i % 3 == 1, sender.message(e).keyframe());
+        receiver.prune(i);
+        if (i == 5) continue;
+        r = receiver.decode(42, sender.message(e), i);
+        EXPECT_EQ(i != 6, r != nullptr);
+        if (r != nullptr) {
+            EXPECT_EQ(*e, **r);
+        }
+        r = receiver.decode(42, sender.message(e), i);
+        EXPECT_EQ(i != 6, r != nullptr);
+    }
+    // after an interval of 3, the sender is forgotten once silent for more than period × 3 = 9
+    receiver.prune(13);
+    export_type<O> e = make_export<O>(11);
+    sender.encode(e);
+    EXPECT_NE(nullptr, receiver.decode(42, sender.message(e), 13));
+    receiver.prune(23);
+    e = make_export<O>(12);
+    sender.encode(e);
+    EXPECT_EQ(nullptr, receiver.decode(42, sender.message(e), 23));
+}
+
+MULTI_TEST(ExportCodecTest, Slow, O, 2) {
+    internal::export_codec<export_type<O>, 4> sender, receiver;
+    // the sender performs a round every 5 rounds of the receiver
+    for (int t = 0; t <= 60; ++t) {
+        receiver.prune(t);
+        if (t % 5) continue;
+        export_type<O> e = make_export<O>(t);
+        sender.encode(e);
+        export_type<O> const* r = receiver.decode(42, sender.message(e), t);
+        ASSERT_NE(nullptr, r);
+        EXPECT_EQ(*e, **r);
+    }
+}
+
+MULTI_TEST(ExportCodecTest, Fields, O, 2) {
+    using fmap_type = std::conditional_t<(O & 2) == 2, common::flat_multitype_map<trace_t, field<int>>, common::multitype_map<trace_t, field<int>>>;
+    using fexport_type = internal::flat_ptr<fmap_type, (O & 1) == 1>;
+    fexport_type x, y;
+    x->insert(1, details::make_field({5}, std::vector<int>{0, 4}));
+    y->insert(1, details::make_field({5, 6}, std::vector<int>{0, 4, 9}));
+    internal::export_delta<fexport_type> d;
+    d.encode(2, *x, *y);
+    ASSERT_TRUE(d.values().template count<field<int>>(1));
+    d.patch(*x);
+    EXPECT_EQ(details::get_ids(y->template at<field<int>>(1)), details::get_ids(x->template at<field<int>>(1)));
+    EXPECT_EQ(details::get_vals(y->template at<field<int>>(1)), details::get_vals(x->template at<field<int>>(1)));
+    d.encode(3, *x, *y);
+    EXPECT_FALSE(d.values().template count<field<int>>(1));
+    internal::export_codec<fexport_type, 4> sender, receiver;
+    sender.encode(x);
+    ASSERT_NE(nullptr, receiver.decode(7, sender.message(x), 0));
+    fexport_type z;
+    z->insert(1, details::make_field({5, 6}, std::vector<int>{0, 4, 8}));
+    sender.encode(z);
+    EXPECT_FALSE(sender.message(z).keyframe());
+    fexport_type const* r = receiver.decode(7, sender.message(z), 1);
+    ASSERT_NE(nullptr, r);
+    EXPECT_EQ(std::vector<int>({0, 4, 8}), details::get_vals((*r)->template at<field<int>>(1)));
+}
+
+TEST(ExportCodecTest, InPlace) {
+    using ptr_type = export_type<0>;
+    internal::export_codec<ptr_type, 4> sender, receiver;
+    ptr_type e = make_export<0>(1);
+    sender.encode(e);
+    ptr_type const* r = receiver.decode(42, sender.message(e), 1);
+    ASSERT_NE(nullptr, r);
+    // keyframes are shared with the sender
+    EXPECT_EQ(&*e, &**r);
+    ptr_type held = *r;
+    e = make_export<0>(2);
+    sender.encode(e);
+    r = receiver.decode(42, sender.message(e), 2);
+    ASSERT_NE(nullptr, r);
+    // the first delta copies the keyframe
+    EXPECT_NE(&*held, &**r);
+    EXPECT_EQ(*e, **r);
+    held = *r;
+    map_type<0> const* base = &**r;
+    e = make_export<0>(3);
+    sender.encode(e);
+    r = receiver.decode(42, sender.message(e), 3);
+    ASSERT_NE(nullptr, r);
+    // later deltas of accepted messages patch in place, even if the export is still held elsewhere
+    EXPECT_EQ(base, &**r);
+    EXPECT_EQ(*e, *held);
+    map_type<0> old = *held;
+    e = make_export<0>(4);
+    sender.encode(e);
+    r = receiver.decode(42, sender.message(e), 4, false);
+    ASSERT_NE(nullptr, r);
+    // deltas of rejected messages patch a copy
+    EXPECT_NE(base, &**r);
+    EXPECT_EQ(*e, **r);
+    EXPECT_EQ(old, *held);
+}
@@ -0,0 +1,114 @@
+// Copyright © 2023 Giorgio Audrito. All Rights Reserved.
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "lib/common/flat_multitype_map.hpp"
+#include "lib/common/multitype_map.hpp"
+#include "lib/internal/recycler.hpp"
+
+using namespace fcpp;
+
+
+// Number of global allocations performed so far.
+size_t allocations = 0;
+
+void* operator new(size_t n) {
+    ++allocations;
+    void* p = std::malloc(n > 0 ? n : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Sorts pending insertions into a flat map.
+template <typename... Ts>
+void compact(common::flat_multitype_map<Ts...>& m) {
+    m.compact();
+}
+
+// Does nothing on hash maps.
+template <typename... Ts>
+void compact(common::multitype_map<Ts...>&) {}
+
+// Counts the allocations of rounds filling and compacting an export, which is held by a neighbour for a round.
+template <typename M>
+size_t round_allocations(size_t rounds) {
+    internal::recycler<M, false> r;
+    internal::flat_ptr<M, false> p, held;
+    size_t a = 0;
+    for (size_t k = 0; k < 2 * rounds; ++k) {
+        if (k == rounds) a = allocations;
+        r.reset(p);
+        for (trace_t i = 0; i < 100; ++i) {
+            p->insert(i * 7919, int(i + k));
+            if (i % 2) p->insert(i * 7907, double(k));
+        }
+        compact(*p);
+        held = p;
+    }
+    return allocations - a;
+}
+
+
+TEST(RecyclerTest, Flat) {
+    internal::recycler<std::vector<int>, true> r;
+    internal::flat_ptr<std::vector<int>, true> p;
+    p->assign(10, 1);
+    int const* data = p->data();
+    r.reset(p);
+    EXPECT_TRUE(p->empty());
+    p->push_back(2);
+    EXPECT_EQ(data, p->data());
+}
+
+TEST(RecyclerTest, Shared) {
+    internal::recycler<std::vector<int>, false> r;
+    internal::flat_ptr<std::vector<int>, false> p;
+    p->assign(10, 1);
+    EXPECT_TRUE(p.unique());
+    std::vector<int> const* x = &*p;
+    r.reset(p);
+    EXPECT_TRUE(p->empty());
+    EXPECT_EQ(x, &*p);
+    p->assign(10, 2);
+    std::vector<internal::flat_ptr<std::vector<int>, false>> held;
+    std::vector<std::vector<int> const*> addr;
+    for (int i = 0; i < 3; ++i) {
+        held.push_back(p);
+        EXPECT_FALSE(p.unique());
+        addr.push_back(&*p);
+        r.reset(p);
+        EXPECT_TRUE(p->empty());
+        EXPECT_NE(addr.back(), &*p);
+        EXPECT_EQ(2, held.back()->front());
+        p->assign(10, 2);
+    }
+    held.clear();
+    for (int i = 0; i < 3; ++i) {
+        held.push_back(p);
+        r.reset(p);
+        EXPECT_EQ(addr[i], &*p);
+        EXPECT_TRUE(p->empty());
+        p->push_back(i);
+    }
+}
+
+TEST(RecyclerTest, Allocations) {
+    // flat exports reuse all of their memory across rounds
+    size_t flat = round_allocations<common::flat_multitype_map<trace_t, int, double>>(10);
+    EXPECT_EQ(0ULL, flat);
+    // hash map exports free and reallocate their nodes on every round
+    size_t hashed = round_allocations<common::multitype_map<trace_t, int, double>>(10);
+    EXPECT_LT(0ULL, hashed);
+}
@@ -1,11 +1,15 @@
 // Copyright © 2021 Giorgio Audrito. All Rights Reserved.
 
 #include <algorithm>
+#include <map>
+#include <memory>
 #include <vector>
 
 #include "gtest/gtest.h"
 
 #include "lib/component/base.hpp"
+#include "lib/component/identifier.hpp"
+#include "lib/component/randomizer.hpp"
 #include "lib/component/scheduler.hpp"
 #include "lib/simulation/simulated_positioner.hpp"
 #include "lib/simulation/simulated_connector.hpp"
@@ -47,6 +51,21 @@ struct mytimer {
     };
 };
 
+// Component swallowing messages from device 7.
+struct swallower {
+    template <typename F, typename P>
+    struct component : public P {
+        struct node : public P::node {
+            using P::node::node;
+            template <typename S, typename T>
+            void receive(times_t t, device_t d, common::tagged_tuple<S,T> const& m) {
+                if (d != 7) P::node::receive(t, d, m);
+            }
+        };
+        using net = typename P::net;
+    };
+};
+
 using seq_per = sequence::periodic<distribution::constant_n<times_t, 2>, distribution::constant_n<times_t, 1>, distribution::constant_n<times_t, 9>>;
 
 template <int O>
@@ -104,6 +123,25 @@ MULTI_TEST(SimulatedConnectorTest, Cell, O, 2) {
     EXPECT_EQ(4, n[1]);
     EXPECT_EQ(4, n[2]);
     EXPECT_EQ(3, n[3]);
+    c[1].insert(n[3]);
+    c[1].insert(n[3]);
+    c[1].erase(n[1]);
+    c[1].erase(n[1]);
+    std::vector<int*> v{n};
+    c[1].gather(v);
+    c[0].gather(v);
+    EXPECT_EQ(std::vector<int*>({n, n+3, n+2, n}), v);
+    v.clear();
+    c[0].gather_linked(v, [] (int) { return true; });
+    EXPECT_EQ(std::vector<int*>({n, n+3, n+2}), v);
+    component::details::cell<(O & 1) == 1, int> d(7);
+    EXPECT_EQ(7, d.id());
+    d.insert(n[1]);
+    d.link(d);
+    d.link(c[1]);
+    v.clear();
+    d.gather_linked(v, [] (int i) { return i == 7; });
+    EXPECT_EQ(std::vector<int*>({n+1}), v);
 }
 
 MULTI_TEST(SimulatedConnectorTest, Connection, O, 2) {
@@ -121,6 +159,20 @@ MULTI_TEST(SimulatedConnectorTest, Connection, O, 2) {
     EXPECT_FALSE(connect);
 }
 
+MULTI_TEST(SimulatedConnectorTest, Locality, O, 2) {
+    typename combo<O>::net  network{common::make_tagged_tuple<oth>("foo")};
+    typename combo<O>::node d0{network, common::make_tagged_tuple<uid, x>(0, make_vec(0.5,0.5))};
+    typename combo<O>::node d1{network, common::make_tagged_tuple<uid, x>(1, make_vec(0.0,0.0))};
+    typename combo<O>::node d2{network, common::make_tagged_tuple<uid, x>(2, make_vec(1.5,0.5))};
+    typename combo<O>::node d3{network, common::make_tagged_tuple<uid, x>(3, make_vec(0.5,1.5))};
+    typename combo<O>::node d4{network, common::make_tagged_tuple<uid, x>(4, make_vec(3.5,2.5))};
+    EXPECT_EQ(0ULL, d0.locality());
+    EXPECT_EQ(0ULL, d1.locality());
+    EXPECT_EQ(1ULL, d2.locality());
+    EXPECT_EQ(2ULL, d3.locality());
+    EXPECT_EQ(13ULL, d4.locality());
+}
+
 MULTI_TEST(SimulatedConnectorTest, EnterLeave, O, 2) {
     typename combo<O>::net  network{common::make_tagged_tuple<oth>("foo")};
     typename combo<O>::node d0{network, common::make_tagged_tuple<uid, x>(0, make_vec(0.5,0.5))};
@@ -222,3 +274,224 @@ MULTI_TEST(SimulatedConnectorTest, Messages, O, 2) {
     d = fcpp::details::self(d0.nbr_dist(), 5);
     EXPECT_EQ(INF, d);
 }
+
+template <int O>
+using swallow_combo = component::combine_spec<
+    swallower,
+    component::simulated_connector<message_size<true>, parallel<(O & 1) == 1>, connector<connect::fixed<1>>, delay<distribution::constant_n<times_t, 1, 4>>>,
+    component::simulated_positioner<>,
+    mytimer,
+    component::scheduler<round_schedule<seq_per>>,
+    component::base<parallel<(O & 1) == 1>>
+>;
+
+MULTI_TEST(SimulatedConnectorTest, SwallowedSize, O, 1) {
+    typename swallow_combo<O>::net  network{common::make_tagged_tuple<oth>("foo")};
+    typename swallow_combo<O>::node d0{network, common::make_tagged_tuple<uid, x>(0, make_vec(0,0))};
+    typename swallow_combo<O>::node::message_t m;
+    size_t sz = common::serialized_size_of(m);
+    d0.receive_sized(1, 7, m, sz + 1000);
+    d0.receive(1, 8, m);
+    EXPECT_EQ(sz, fcpp::details::self(d0.nbr_msg_size(), 8));
+    d0.receive_sized(1, 9, m, sz + 1000);
+    EXPECT_EQ(sz + 1000, fcpp::details::self(d0.nbr_msg_size(), 9));
+}
+
+template <int O>
+using clique_combo = component::combine_spec<
+    exposer,
+    component::simulated_connector<message_size<(O & 2) == 2>, parallel<(O & 1) == 1>, delay<distribution::constant_n<times_t, 1, 4>>>,
+    component::simulated_positioner<>,
+    mytimer,
+    component::scheduler<round_schedule<seq_per>>,
+    component::base<parallel<(O & 1) == 1>>
+>;
+
+MULTI_TEST(SimulatedConnectorTest, AllToAll, O, 2) {
+    auto update = [](auto& node) {
+        common::lock_guard<(O & 1) == 1> l(node.mutex);
+        node.update();
+    };
+    typename clique_combo<O>::net  network{common::make_tagged_tuple<threads>(2)};
+    EXPECT_EQ(INF, network.connection_radius());
+    std::vector<std::unique_ptr<typename clique_combo<O>::node>> d;
+    for (int i=0; i<2000; ++i)
+        d.emplace_back(new typename clique_combo<O>::node{network, common::make_tagged_tuple<uid, x>(i, make_vec(i,-i))});
+    d.erase(d.begin()+7);
+    for (auto& n : d) EXPECT_EQ(2, n->next());
+    for (auto& n : d) update(*n);
+    for (auto& n : d) EXPECT_EQ(2.25, n->next());
+    update(*d[0]);
+    update(*d[1998]);
+    EXPECT_EQ(3, d[0]->next());
+    EXPECT_EQ(3, d[1998]->next());
+    for (auto& n : d) {
+        real_t dist = fcpp::details::self(n->nbr_dist(), 0);
+        EXPECT_NEAR(n->uid * sqrt(2.0), dist, 1e-6);
+    }
+    real_t dist;
+    dist = fcpp::details::self(d[0]->nbr_dist(), 1999);
+    EXPECT_NEAR(2827.013, dist, 1e-3);
+    dist = fcpp::details::self(d[0]->nbr_dist(), 1);
+    EXPECT_EQ(INF, dist);
+    dist = fcpp::details::self(d[1998]->nbr_dist(), 1999);
+    EXPECT_NEAR(0, dist, 1e-9);
+}
+
+template <int O>
+using inbox_combo = component::combine_spec<
+    exposer,
+    component::simulated_connector<inbox<true>, message_size<(O & 2) == 2>, parallel<(O & 1) == 1>, connector<connect::fixed<1>>, delay<distribution::constant_n<times_t, 1, 4>>>,
+    component::simulated_positioner<>,
+    mytimer,
+    component::scheduler<round_schedule<seq_per>>,
+    component::base<parallel<(O & 1) == 1>>
+>;
+
+MULTI_TEST(SimulatedConnectorTest, Inbox, O, 2) {
+    auto update = [](auto& node) {
+        common::lock_guard<(O & 1) == 1> l(node.mutex);
+        node.update();
+    };
+    typename inbox_combo<O>::net  network{common::make_tagged_tuple<oth>("foo")};
+    typename inbox_combo<O>::node d0{network, common::make_tagged_tuple<uid, x>(0, make_vec(0.25,0.25))};
+    typename inbox_combo<O>::node d1{network, common::make_tagged_tuple<uid, x>(1, make_vec(0.0,0.0))};
+    typename inbox_combo<O>::node d2{network, common::make_tagged_tuple<uid, x>(2, make_vec(1.5,0.5))};
+    typename inbox_combo<O>::node d3{network, common::make_tagged_tuple<uid, x>(3, make_vec(9.0,9.0))};
+    d0.velocity() = make_vec(1,1);
+    for (int i=0; i<2; ++i) {
+        update(d0);
+        update(d1);
+        update(d2);
+        update(d3);
+    }
+    real_t d;
+    d = fcpp::details::self(d0.nbr_dist(), 0);
+    EXPECT_NEAR(0, d, 1e-9);
+    d = fcpp::details::self(d0.nbr_dist(), 1);
+    EXPECT_EQ(INF, d);
+    d = fcpp::details::self(d1.nbr_dist(), 0);
+    EXPECT_NEAR(0.7071067811865476, d, 1e-9);
+    EXPECT_NEAR(2.75, d0.next(), FCPP_TIME_EPSILON);
+    update(d0);
+    d = fcpp::details::self(d0.nbr_dist(), 1);
+    EXPECT_NEAR(0.7071067811865476, d, 1e-9);
+    d = fcpp::details::self(d0.nbr_dist(), 2);
+    EXPECT_NEAR(1, d, 1e-9);
+    d = fcpp::details::self(d0.nbr_dist(), 3);
+    EXPECT_EQ(INF, d);
+}
+
+// Component exposing node creation.
+struct emplacer {
+    template <typename F, typename P>
+    struct component : public P {
+        using node = typename P::node;
+        struct net : public P::net {
+            using P::net::net;
+            using P::net::node_emplace;
+        };
+    };
+};
+
+using rand_per = sequence::periodic<distribution::interval_n<times_t, 0, 1>, distribution::interval_n<times_t, 1, 3, 2>, distribution::constant_n<times_t, 20>>;
+
+template <int O>
+using deterministic_combo = component::combine_spec<
+    exposer,
+    emplacer,
+    component::simulated_connector<deterministic<true>, parallel<true>, connector<connect::radial<50, connect::fixed<1>>>, delay<distribution::interval_n<times_t, 0, 1, 4>>>,
+    component::simulated_positioner<>,
+    mytimer,
+    component::scheduler<round_schedule<rand_per>>,
+    component::randomizer<>,
+    component::identifier<parallel<true>, synchronised<O == 1>>,
+    component::base<parallel<true>>
+>;
+
+// Runs a simulation, returning the neighbour distances collected by every node.
+template <int O>
+std::vector<std::vector<real_t>> deterministic_run(size_t n) {
+    typename deterministic_combo<O>::net network{common::make_tagged_tuple<threads, epsilon, seed>(n, 0.25, 42)};
+    for (int i=0; i<200; ++i)
+        network.node_emplace(common::make_tagged_tuple<uid, x>(i, make_vec(i%15 * 0.4, i/15 * 0.4)));
+    network.run(15);
+    std::vector<std::vector<real_t>> res;
+    for (device_t i=0; i<200; ++i) {
+        field<real_t> const& f = network.node_at(i).nbr_dist();
+        res.emplace_back(fcpp::details::get_vals(f));
+        for (device_t j : fcpp::details::get_ids(f)) res.back().push_back(j);
+    }
+    return res;
+}
+
+MULTI_TEST(SimulatedConnectorTest, Deterministic, O, 1) {
+    std::vector<std::vector<real_t>> r1 = deterministic_run<O>(1);
+    size_t tot = 0;
+    for (auto const& v : r1) tot += v.size();
+    EXPECT_LT(2000ULL, tot);
+    EXPECT_EQ(r1, deterministic_run<O>(3));
+    EXPECT_EQ(r1, deterministic_run<O>(8));
+}
+
+// Times of the rounds of every node, together with the number of messages received before them.
+std::map<device_t, std::vector<std::pair<times_t, size_t>>> traces;
+
+// Component recording the trace of every node on its deletion.
+struct tracer {
+    template <typename F, typename P>
+    struct component : public P {
+        struct node : public P::node {
+            using P::node::node;
+            ~node() {
+                traces[P::node::uid] = m_trace;
+            }
+            template <typename S, typename T>
+            void receive(times_t t, device_t d, common::tagged_tuple<S,T> const& m) {
+                P::node::receive(t, d, m);
+                ++m_count;
+            }
+            void round_start(times_t t) {
+                P::node::round_start(t);
+                m_trace.emplace_back(t, m_count);
+            }
+            size_t m_count = 0;
+            std::vector<std::pair<times_t, size_t>> m_trace;
+        };
+        using net = typename P::net;
+    };
+};
+
+template <bool b>
+using lookahead_combo = component::combine_spec<
+    tracer,
+    emplacer,
+    component::simulated_connector<deterministic<b>, parallel<b>, connector<connect::fixed<1>>, delay<distribution::interval_n<times_t, 1, 2, 4>>>,
+    component::simulated_positioner<>,
+    mytimer,
+    component::scheduler<round_schedule<rand_per>>,
+    component::randomizer<>,
+    component::identifier<parallel<b>>,
+    component::base<parallel<b>>
+>;
+
+// Runs a simulation to completion, returning the traces of every node.
+template <bool b>
+std::map<device_t, std::vector<std::pair<times_t, size_t>>> lookahead_run(size_t n) {
+    traces.clear();
+    {
+        typename lookahead_combo<b>::net network{common::make_tagged_tuple<threads, epsilon, lookahead, seed>(n, 0, b ? 0.25 : 0, 42)};
+        for (int i=0; i<200; ++i)
+            network.node_emplace(common::make_tagged_tuple<uid, x>(i, make_vec(i%15 * 0.4, i/15 * 0.4)));
+        network.run();
+    }
+    return traces;
+}
+
+TEST(SimulatedConnectorTest, Lookahead) {
+    std::map<device_t, std::vector<std::pair<times_t, size_t>>> r = lookahead_run<false>(1);
+    EXPECT_EQ(200ULL, r.size());
+    EXPECT_LT(2000ULL, r[0].size() * r.size());
+    EXPECT_EQ(r, lookahead_run<true>(1));
+    EXPECT_EQ(r, lookahead_run<true>(4));
+}